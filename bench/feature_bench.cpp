@@ -0,0 +1,214 @@
+/**
+ * accuracy and speed of the reduced precision feature distances against float, on a MOT-format detection file.
+ * the appearance cost of each frame's detections to the previous frame's detections is computed with
+ * CosineFeature and QuantizedCosineFeature, then deep_sort and botsort are replayed with each of them.
+ * the features are packed before the timing starts, as the trackers store them, so only the matrices are timed.
+ *
+ * usage: redoxi_feature_bench [mot_file] [--feature-dim D] [--repeat R]
+ *   mot_file       lines of frame,id,x,y,w,h,conf,class,visibility (default: dancetrack-0039 ground truth)
+ *   --feature-dim  size of the synthetic unit feature attached to each detection (default 512)
+ *   --repeat       times each distance matrix is computed for timing (default 5)
+ */
+#include <RedoxiTrack/RedoxiTrack.h>
+#include <RedoxiTrack/utils/QuantizedCosineFeature.h>
+
+#include "mot_sequence.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+namespace
+{
+struct Variant {
+    std::string name;
+    rxt::FeatureTraitsPtr traits;
+};
+
+struct KernelStats {
+    double seconds = 0;
+    double max_error = 0;
+    double sum_error = 0;
+    size_t num_pairs = 0;
+    size_t num_rows = 0;
+    size_t same_nearest = 0;
+};
+
+int nearest(const rxt::CostMatrix &cost, int i)
+{
+    const float *row = cost.row(i);
+    return (int)(std::min_element(row, row + cost.cols()) - row);
+}
+
+// record which path id each detection ends up in
+class AssignmentRecorder : public rxt::TrackingEventHandler
+{
+  public:
+    int evt_target_association_after(rxt::TrackerBase *sender, const rxt::TrackingEvent::TargetAssociation &evt_data) override
+    {
+        m_det2path[evt_data.m_detection.get()] = evt_data.m_target->get_path_id();
+        return 0;
+    }
+    int evt_target_created_after(rxt::TrackerBase *sender, const rxt::TrackingEvent::TargetAssociation &evt_data) override
+    {
+        m_det2path[evt_data.m_detection.get()] = evt_data.m_target->get_path_id();
+        return 0;
+    }
+
+    std::map<const rxt::Detection *, int> m_det2path;
+};
+
+struct TrackingStats {
+    std::vector<std::vector<int>> path_ids;
+    int id_switches = 0;
+};
+
+// path id of every detection (-1 if not associated) and the number of gt ids whose path id changes
+TrackingStats replay(const rxt::TrackerBasePtr &tracker, const MotSequence &seq, const cv::Mat &img)
+{
+    auto recorder = std::make_shared<AssignmentRecorder>();
+    tracker->add_event_handler(recorder);
+    tracker->begin_track(img, seq.frames[0], 0);
+    for (size_t i = 1; i < seq.frames.size(); i++)
+        tracker->track(img, seq.frames[i], (int)i);
+    tracker->finish_track();
+
+    TrackingStats output;
+    std::map<int, int> gt2path;
+    for (size_t i = 0; i < seq.frames.size(); i++) {
+        output.path_ids.emplace_back();
+        for (size_t k = 0; k < seq.frames[i].size(); k++) {
+            auto it = recorder->m_det2path.find(seq.frames[i][k].get());
+            int path_id = it == recorder->m_det2path.end() ? -1 : it->second;
+            output.path_ids.back().push_back(path_id);
+            if (path_id < 0)
+                continue;
+            auto last = gt2path.find(seq.ids[i][k]);
+            if (last != gt2path.end() && last->second != path_id)
+                output.id_switches++;
+            gt2path[seq.ids[i][k]] = path_id;
+        }
+    }
+    return output;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string mot_file = REDOXI_BENCH_DEFAULT_MOT_FILE;
+    int feature_dim = 512;
+    int repeat = 5;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--feature-dim" && i + 1 < argc)
+            feature_dim = std::atoi(argv[++i]);
+        else if (arg == "--repeat" && i + 1 < argc)
+            repeat = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-h" || arg == "--help") {
+            std::printf("usage: %s [mot_file] [--feature-dim D] [--repeat R]\n", argv[0]);
+            return 0;
+        } else
+            mot_file = arg;
+    }
+
+    MotSequence seq;
+    if (feature_dim <= 0 || !load_mot_file(mot_file, feature_dim, seq)) {
+        std::fprintf(stderr, "failed to load detections from %s\n", mot_file.c_str());
+        return 1;
+    }
+    std::printf("loaded %zu detections in %zu frames from %s, feature dim %d\n",
+                seq.num_detections, seq.frames.size(), mot_file.c_str(), feature_dim);
+
+    using Precision = rxt::QuantizedCosineFeature::Precision;
+    std::vector<Variant> variants = {
+        {"float32", std::make_shared<rxt::CosineFeature>()},
+        {"float16", std::make_shared<rxt::QuantizedCosineFeature>(Precision::Float16)},
+        {"int8", std::make_shared<rxt::QuantizedCosineFeature>(Precision::Int8)},
+    };
+
+    // distance matrices of consecutive frames, errors are against float32
+    std::vector<KernelStats> kernel_stats(variants.size());
+    rxt::FeatureArray now, prev;
+    rxt::CostMatrix reference, cost;
+    for (size_t f = 1; f < seq.frames.size(); f++) {
+        if (seq.frames[f].empty() || seq.frames[f - 1].empty())
+            continue;
+        now.assign(seq.frames[f], variants[0].traits.get());
+        prev.assign(seq.frames[f - 1], variants[0].traits.get());
+        variants[0].traits->compute_distance_matrix(now, prev, reference);
+        for (size_t v = 0; v < variants.size(); v++) {
+            now.assign(seq.frames[f], variants[v].traits.get());
+            prev.assign(seq.frames[f - 1], variants[v].traits.get());
+            auto t0 = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeat; r++)
+                variants[v].traits->compute_distance_matrix(now, prev, cost);
+            auto t1 = std::chrono::steady_clock::now();
+            auto &stats = kernel_stats[v];
+            stats.seconds += std::chrono::duration<double>(t1 - t0).count() / repeat;
+            for (int i = 0; i < cost.rows(); i++) {
+                for (int j = 0; j < cost.cols(); j++) {
+                    double error = std::abs(cost(i, j) - reference(i, j));
+                    stats.max_error = std::max(stats.max_error, error);
+                    stats.sum_error += error;
+                    stats.num_pairs++;
+                }
+                stats.same_nearest += nearest(cost, i) == nearest(reference, i);
+                stats.num_rows++;
+            }
+        }
+    }
+
+    std::printf("\n== distance matrix, detections of each frame to the previous frame\n");
+    std::printf("%-10s %12s %12s %12s %14s\n", "precision", "ms/frame", "max err", "mean err", "same nearest");
+    for (size_t v = 0; v < variants.size(); v++) {
+        auto &stats = kernel_stats[v];
+        std::printf("%-10s %12.4f %12.2e %12.2e %13.2f%%\n", variants[v].name.c_str(),
+                    stats.seconds * 1e3 / std::max<size_t>(1, seq.frames.size() - 1), stats.max_error,
+                    stats.sum_error / std::max<size_t>(1, stats.num_pairs),
+                    100.0 * stats.same_nearest / std::max<size_t>(1, stats.num_rows));
+    }
+
+    // whole trackers, assignments are compared with the float32 run
+    cv::Mat img = cv::Mat::zeros(1080, 1920, CV_8UC3);
+    std::vector<std::pair<std::string, std::function<rxt::TrackerBasePtr(const rxt::FeatureTraitsPtr &)>>> trackers = {
+        {"deep_sort", [&](const rxt::FeatureTraitsPtr &traits) {
+             auto tracker = std::make_shared<rxt::DeepSortTracker>();
+             rxt::DeepSortTrackerParam param;
+             param.set_preferred_image_size(img.size());
+             tracker->init(param);
+             tracker->set_feature_traits(traits);
+             return tracker;
+         }},
+        {"botsort", [&](const rxt::FeatureTraitsPtr &traits) {
+             auto tracker = std::make_shared<rxt::BotsortTracker>();
+             rxt::BotsortTrackerParam param;
+             param.set_preferred_image_size(img.size());
+             tracker->init(param);
+             tracker->set_feature_traits(traits);
+             return tracker;
+         }},
+    };
+
+    for (auto &p : trackers) {
+        std::printf("\n== %s\n", p.first.c_str());
+        std::printf("%-10s %12s %14s\n", "precision", "id switches", "same path id");
+        TrackingStats reference_run;
+        for (size_t v = 0; v < variants.size(); v++) {
+            TrackingStats run = replay(p.second(variants[v].traits), seq, img);
+            if (v == 0)
+                reference_run = run;
+            size_t same = 0, total = 0;
+            for (size_t i = 0; i < run.path_ids.size(); i++) {
+                for (size_t k = 0; k < run.path_ids[i].size(); k++) {
+                    same += run.path_ids[i][k] == reference_run.path_ids[i][k];
+                    total++;
+                }
+            }
+            std::printf("%-10s %12d %13.2f%%\n", variants[v].name.c_str(), run.id_switches,
+                        100.0 * same / std::max<size_t>(1, total));
+        }
+    }
+    return 0;
+}
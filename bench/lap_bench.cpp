@@ -0,0 +1,143 @@
+/**
+ * compare the padded square lapjv (what lapjv_match used to do) with the rectangular solver,
+ * on iou-like sparse costs and on dense uniform costs.
+ *
+ * usage: redoxi_lap_bench [--sizes 50,200,1000] [--thresh T] [--repeat R]
+ */
+#include <RedoxiTrack/RedoxiTrack.h>
+#include <RedoxiTrack/external/lapjv.h>
+#include <RedoxiTrack/utils/utility_functions.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace rxt = RedoxiTrack;
+
+namespace
+{
+// detections scattered over a 1920x1080 frame, targets are the same boxes moved a little, cost = 1 - iou
+void make_iou_costs(int n, std::mt19937 &rng, rxt::CostMatrix &output)
+{
+    std::uniform_real_distribution<float> px(0, 1800), py(0, 1000), size(30, 120), jitter(-8, 8);
+    std::vector<rxt::BBOX> sources(n), targets(n);
+    for (int i = 0; i < n; i++) {
+        sources[i] = rxt::BBOX(px(rng), py(rng), size(rng), size(rng));
+        targets[i] = rxt::BBOX(sources[i].x + jitter(rng), sources[i].y + jitter(rng),
+                               sources[i].width + jitter(rng), sources[i].height + jitter(rng));
+    }
+    std::shuffle(targets.begin(), targets.end(), rng);
+    output.resize(n, n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            output(i, j) = 1 - rxt::compute_iou(sources[i], targets[j]);
+}
+
+void make_uniform_costs(int n, std::mt19937 &rng, rxt::CostMatrix &output)
+{
+    std::uniform_real_distribution<float> dist(0, 1);
+    output.resize(n, n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            output(i, j) = dist(rng);
+}
+
+// the removed lapjv_match body: pad to (n+m)^2 doubles with thresh/2 and solve the square problem
+void solve_padded(const rxt::CostMatrix &cost, float thresh, std::vector<int_t> &x_out)
+{
+    int rows = cost.rows(), cols = cost.cols();
+    uint_t n = rows + cols;
+    std::vector<std::vector<double>> cost_matrix(n, std::vector<double>(n, thresh / 2));
+    for (uint_t row = 0; row < n; row++)
+        for (uint_t col = 0; col < n; col++) {
+            if ((int)row < rows && (int)col < cols)
+                cost_matrix[row][col] = cost(row, col);
+            else if ((int)row >= rows && (int)col >= cols)
+                cost_matrix[row][col] = 0.0;
+        }
+    std::vector<double *> cost_ptr(n);
+    for (uint_t i = 0; i < n; i++)
+        cost_ptr[i] = cost_matrix[i].data();
+    std::vector<int_t> x(n), y(n);
+    lapjv_internal(n, cost_ptr.data(), x.data(), y.data());
+    x_out.assign(x.begin(), x.begin() + rows);
+    for (auto &v : x_out)
+        if (v >= cols)
+            v = -1;
+}
+
+void solve_rectangular(const rxt::CostMatrix &cost, float thresh, std::vector<int_t> &x_out)
+{
+    std::vector<int_t> y(cost.cols());
+    x_out.resize(cost.rows());
+    lapjv_rectangular(cost.rows(), cost.cols(), cost.data(), cost.stride(), thresh, x_out.data(), y.data());
+}
+
+template <typename F>
+double time_ms(F f, int repeat)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++)
+        f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count() / repeat;
+}
+
+void run(const char *name, void (*make)(int, std::mt19937 &, rxt::CostMatrix &), int n, float thresh, int repeat)
+{
+    std::mt19937 rng(n * 31 + 7);
+    rxt::CostMatrix cost;
+    make(n, rng, cost);
+
+    std::vector<int_t> x_padded, x_rect;
+    // padded lapjv is cubic in n+m, do not repeat it at large sizes
+    int padded_repeat = n >= 1000 ? 1 : repeat;
+    double ms_padded = time_ms([&]() { solve_padded(cost, thresh, x_padded); }, padded_repeat);
+    double ms_rect = time_ms([&]() { solve_rectangular(cost, thresh, x_rect); }, repeat);
+
+    int mismatch = 0, matched = 0;
+    for (int i = 0; i < n; i++) {
+        mismatch += x_padded[i] != x_rect[i];
+        matched += x_rect[i] != -1;
+    }
+    std::printf("%-8s %6d %9d %12.3f %12.3f %8.1fx %9d\n", name, n, matched, ms_padded, ms_rect,
+                ms_padded / std::max(ms_rect, 1e-9), mismatch);
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<int> sizes = {50, 200, 1000};
+    float thresh = 0.8f;
+    int repeat = 10;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            sizes.clear();
+            std::string s = argv[++i];
+            std::replace(s.begin(), s.end(), ',', ' ');
+            std::istringstream is(s);
+            int v;
+            while (is >> v)
+                sizes.push_back(v);
+        } else if (arg == "--thresh" && i + 1 < argc)
+            thresh = std::atof(argv[++i]);
+        else if (arg == "--repeat" && i + 1 < argc)
+            repeat = std::max(1, std::atoi(argv[++i]));
+        else {
+            std::printf("usage: %s [--sizes 50,200,1000] [--thresh T] [--repeat R]\n", argv[0]);
+            return 0;
+        }
+    }
+
+    std::printf("thresh %.3f, milliseconds per solve, mismatch = rows assigned differently\n", thresh);
+    std::printf("%-8s %6s %9s %12s %12s %9s %9s\n", "costs", "n", "matched", "padded", "rectangular", "speedup", "mismatch");
+    for (int n : sizes) {
+        run("iou", make_iou_costs, n, thresh, repeat);
+        run("uniform", make_uniform_costs, n, thresh, repeat);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * MOT-format detection files replayed by the benchmarks
+ */
+#pragma once
+
+#include <RedoxiTrack/RedoxiTrack.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace rxt = RedoxiTrack;
+
+struct MotSequence {
+    // frame index (0-based, consecutive) -> detections
+    std::vector<std::vector<rxt::DetectionPtr>> frames;
+    // ids[i][k] is the track id in the file of frames[i][k]
+    std::vector<std::vector<int>> ids;
+    size_t num_detections = 0;
+};
+
+inline rxt::fVECTOR make_feature(int track_id, int dim, std::mt19937 &rng)
+{
+    // each gt id gets a stable base direction, plus per-frame noise
+    std::mt19937 id_rng(track_id * 7919 + 17);
+    std::normal_distribution<float> base_dist(0.f, 1.f);
+    std::normal_distribution<float> noise_dist(0.f, 0.2f);
+    rxt::fVECTOR x(dim);
+    for (int i = 0; i < dim; i++)
+        x[i] = base_dist(id_rng) + noise_dist(rng);
+    x.normalize();
+    return x;
+}
+
+inline bool load_mot_file(const std::string &path, int feature_dim, MotSequence &output)
+{
+    std::ifstream fin(path);
+    if (!fin.is_open())
+        return false;
+
+    std::mt19937 rng(12345);
+    std::map<int, std::vector<rxt::DetectionPtr>> frame2dets;
+    std::map<int, std::vector<int>> frame2ids;
+    std::string line;
+    while (std::getline(fin, line)) {
+        if (line.empty())
+            continue;
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream is(line);
+        int frame = 0, track_id = 0;
+        float x = 0, y = 0, w = 0, h = 0, conf = 1;
+        if (!(is >> frame >> track_id >> x >> y >> w >> h))
+            continue;
+        is >> conf;
+
+        auto det = std::make_shared<rxt::SingleDetection>();
+        det->set_bbox(rxt::BBOX(x, y, w, h));
+        det->set_confidence(conf);
+        det->set_quality(conf);
+        if (feature_dim > 0)
+            det->set_feature(make_feature(track_id, feature_dim, rng));
+        frame2dets[frame].push_back(det);
+        frame2ids[frame].push_back(track_id);
+        output.num_detections++;
+    }
+    if (frame2dets.empty())
+        return false;
+
+    // keep empty frames, the trackers must still be called on them
+    int first = frame2dets.begin()->first;
+    int last = frame2dets.rbegin()->first;
+    output.frames.assign(last - first + 1, std::vector<rxt::DetectionPtr>());
+    output.ids.assign(last - first + 1, std::vector<int>());
+    for (auto &p : frame2dets)
+        output.frames[p.first - first] = p.second;
+    for (auto &p : frame2ids)
+        output.ids[p.first - first] = p.second;
+    return true;
+}
@@ -0,0 +1,162 @@
+/**
+ * replay the same MOT-format detection file on many streams at once, either with one thread per stream
+ * or with MultiStreamTracker on a fixed pool, and report the aggregate frame rate and per-stream latency.
+ * each stream gets its own copy of the detections, the trackers modify them.
+ *
+ * usage: redoxi_multistream_bench [mot_file] [--streams N] [--threads T] [--tracker NAME] [--feature-dim D]
+ *   --streams      number of streams (default 64)
+ *   --threads      threads of the pool, 0 = one per hardware thread (default 0)
+ *   --tracker      simple_sort, deep_sort or botsort (default botsort)
+ *   --feature-dim  attach a synthetic unit feature to each detection, 0 = no feature
+ */
+#include <RedoxiTrack/RedoxiTrack.h>
+
+#include "mot_sequence.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace rxt = RedoxiTrack;
+
+namespace
+{
+rxt::TrackerBasePtr create_tracker(const std::string &name, const cv::Size &image_size)
+{
+    if (name == "simple_sort") {
+        auto tracker = std::make_shared<rxt::SimpleSortTracker>();
+        rxt::SimpleSortTrackerParam param;
+        param.set_preferred_image_size(image_size);
+        tracker->init(param);
+        return tracker;
+    }
+    if (name == "deep_sort") {
+        auto tracker = std::make_shared<rxt::DeepSortTracker>();
+        rxt::DeepSortTrackerParam param;
+        param.set_preferred_image_size(image_size);
+        tracker->init(param);
+        return tracker;
+    }
+    auto tracker = std::make_shared<rxt::BotsortTracker>();
+    rxt::BotsortTrackerParam param;
+    param.set_preferred_image_size(image_size);
+    tracker->init(param);
+    return tracker;
+}
+
+// deep copy of the detections of every frame
+std::vector<std::vector<rxt::DetectionPtr>> copy_frames(const MotSequence &seq)
+{
+    std::vector<std::vector<rxt::DetectionPtr>> output(seq.frames.size());
+    for (size_t i = 0; i < seq.frames.size(); i++)
+        for (auto &det : seq.frames[i])
+            output[i].push_back(det->clone());
+    return output;
+}
+
+void report(const std::string &name, size_t num_frames, double seconds)
+{
+    std::printf("%-24s %10.1f frames/s  (%zu frames in %.3f s)\n", name.c_str(), num_frames / seconds, num_frames,
+                seconds);
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string mot_file = REDOXI_BENCH_DEFAULT_MOT_FILE;
+    int num_streams = 64;
+    int num_threads = 0;
+    int feature_dim = 0;
+    std::string tracker_name = "botsort";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--streams" && i + 1 < argc)
+            num_streams = std::atoi(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc)
+            num_threads = std::atoi(argv[++i]);
+        else if (arg == "--feature-dim" && i + 1 < argc)
+            feature_dim = std::atoi(argv[++i]);
+        else if (arg == "--tracker" && i + 1 < argc)
+            tracker_name = argv[++i];
+        else if (arg == "-h" || arg == "--help") {
+            std::printf("usage: %s [mot_file] [--streams N] [--threads T] [--tracker NAME] [--feature-dim D]\n",
+                        argv[0]);
+            return 0;
+        } else
+            mot_file = arg;
+    }
+
+    MotSequence seq;
+    if (!load_mot_file(mot_file, feature_dim, seq)) {
+        std::fprintf(stderr, "failed to load detections from %s\n", mot_file.c_str());
+        return 1;
+    }
+    std::printf("%d streams of %zu frames from %s, tracker %s, feature dim %d\n", num_streams, seq.frames.size(),
+                mot_file.c_str(), tracker_name.c_str(), feature_dim);
+
+    cv::Size image_size(1920, 1080);
+    cv::Mat img = cv::Mat::zeros(image_size, CV_8UC3);
+    const size_t total_frames = seq.frames.size() * num_streams;
+    using Clock = std::chrono::steady_clock;
+
+    // one thread per stream
+    {
+        std::vector<std::vector<std::vector<rxt::DetectionPtr>>> frames;
+        std::vector<rxt::TrackerBasePtr> trackers;
+        for (int s = 0; s < num_streams; s++) {
+            frames.push_back(copy_frames(seq));
+            trackers.push_back(create_tracker(tracker_name, image_size));
+        }
+        auto t0 = Clock::now();
+        std::vector<std::thread> threads;
+        for (int s = 0; s < num_streams; s++) {
+            threads.emplace_back([&, s]() {
+                trackers[s]->begin_track(img, frames[s][0], 0);
+                for (size_t i = 1; i < frames[s].size(); i++)
+                    trackers[s]->track(img, frames[s][i], (int)i);
+                trackers[s]->finish_track();
+            });
+        }
+        for (auto &t : threads)
+            t.join();
+        report("thread per stream", total_frames, std::chrono::duration<double>(Clock::now() - t0).count());
+    }
+
+    // the pool, frames submitted round robin as cameras would deliver them
+    {
+        std::vector<std::vector<std::vector<rxt::DetectionPtr>>> frames;
+        rxt::MultiStreamTracker multi;
+        multi.init(num_threads);
+        for (int s = 0; s < num_streams; s++) {
+            frames.push_back(copy_frames(seq));
+            multi.add_stream(create_tracker(tracker_name, image_size));
+        }
+        auto t0 = Clock::now();
+        for (size_t i = 0; i < seq.frames.size(); i++)
+            for (int s = 0; s < num_streams; s++)
+                multi.submit(s, img, frames[s][i], (int)i);
+        for (int s = 0; s < num_streams; s++)
+            multi.submit_finish(s);
+        multi.wait_all();
+        double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "pool of %d threads", num_threads > 0 ? num_threads
+                                                                                : (int)std::thread::hardware_concurrency());
+        report(name, total_frames, seconds);
+
+        // everything is submitted up front, so the latency is mostly the wait in the queue
+        double mean = 0, worst = 0, track_time = 0;
+        for (int s = 0; s < num_streams; s++) {
+            rxt::StreamLatency latency = multi.get_stream_latency(s);
+            mean += latency.get_mean_latency() / num_streams;
+            track_time += latency.get_mean_track_time() / num_streams;
+            worst = std::max(worst, latency.max_latency);
+        }
+        std::printf("per stream: mean latency %.3f ms, max latency %.3f ms, mean track() %.4f ms\n", mean * 1e3,
+                    worst * 1e3, track_time * 1e3);
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+/**
+ * replay a MOT-format detection file through decode, detect, track and sink, first one frame after the
+ * other as the examples do, then with TrackingPipeline. decode, detect and sink are simulated by sleeping,
+ * the tracker is real, so the numbers show how much of the stage latencies the pipeline hides.
+ *
+ * usage: redoxi_pipeline_bench [mot_file] [--decode-ms D] [--detect-ms D] [--sink-ms D] [--tracker NAME]
+ *                              [--queue N] [--drop-oldest]
+ *   --decode-ms    time to decode a frame (default 4)
+ *   --detect-ms    time to detect a frame (default 20)
+ *   --sink-ms      time to annotate and write a frame (default 4)
+ *   --tracker      simple_sort, deep_sort or botsort (default botsort)
+ *   --queue        frames per queue between two stages (default 4)
+ *   --drop-oldest  drop the oldest frame of a full queue instead of waiting
+ */
+#include <RedoxiTrack/RedoxiTrack.h>
+
+#include "mot_sequence.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace rxt = RedoxiTrack;
+
+namespace
+{
+rxt::TrackerBasePtr create_tracker(const std::string &name, const cv::Size &image_size)
+{
+    if (name == "simple_sort") {
+        auto tracker = std::make_shared<rxt::SimpleSortTracker>();
+        rxt::SimpleSortTrackerParam param;
+        param.set_preferred_image_size(image_size);
+        tracker->init(param);
+        return tracker;
+    }
+    if (name == "deep_sort") {
+        auto tracker = std::make_shared<rxt::DeepSortTracker>();
+        rxt::DeepSortTrackerParam param;
+        param.set_preferred_image_size(image_size);
+        tracker->init(param);
+        return tracker;
+    }
+    auto tracker = std::make_shared<rxt::BotsortTracker>();
+    rxt::BotsortTrackerParam param;
+    param.set_preferred_image_size(image_size);
+    tracker->init(param);
+    return tracker;
+}
+
+// copies, the trackers modify the detections
+std::vector<rxt::DetectionPtr> copy_detections(const std::vector<rxt::DetectionPtr> &detections)
+{
+    std::vector<rxt::DetectionPtr> output;
+    for (auto &det : detections)
+        output.push_back(det->clone());
+    return output;
+}
+
+void sleep_ms(double ms)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds((long long)(ms * 1000)));
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string mot_file = REDOXI_BENCH_DEFAULT_MOT_FILE;
+    double decode_ms = 4;
+    double detect_ms = 20;
+    double sink_ms = 4;
+    std::string tracker_name = "botsort";
+    rxt::TrackingPipelineParam pipeline_param;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--decode-ms" && i + 1 < argc)
+            decode_ms = std::atof(argv[++i]);
+        else if (arg == "--detect-ms" && i + 1 < argc)
+            detect_ms = std::atof(argv[++i]);
+        else if (arg == "--sink-ms" && i + 1 < argc)
+            sink_ms = std::atof(argv[++i]);
+        else if (arg == "--tracker" && i + 1 < argc)
+            tracker_name = argv[++i];
+        else if (arg == "--queue" && i + 1 < argc)
+            pipeline_param.m_queue_capacity = std::atoi(argv[++i]);
+        else if (arg == "--drop-oldest") {
+            pipeline_param.m_detect_queue_policy = rxt::PipelineQueuePolicy::DropOldest;
+            pipeline_param.m_track_queue_policy = rxt::PipelineQueuePolicy::DropOldest;
+            pipeline_param.m_sink_queue_policy = rxt::PipelineQueuePolicy::DropOldest;
+        } else if (arg == "-h" || arg == "--help") {
+            std::printf("usage: %s [mot_file] [--decode-ms D] [--detect-ms D] [--sink-ms D] [--tracker NAME] "
+                        "[--queue N] [--drop-oldest]\n",
+                        argv[0]);
+            return 0;
+        } else
+            mot_file = arg;
+    }
+
+    MotSequence seq;
+    if (!load_mot_file(mot_file, 0, seq)) {
+        std::fprintf(stderr, "failed to load detections from %s\n", mot_file.c_str());
+        return 1;
+    }
+    std::printf("%zu frames from %s, tracker %s, decode %.1f ms, detect %.1f ms, sink %.1f ms\n",
+                seq.frames.size(), mot_file.c_str(), tracker_name.c_str(), decode_ms, detect_ms, sink_ms);
+
+    cv::Size image_size(1920, 1080);
+    cv::Mat blank = cv::Mat::zeros(image_size, CV_8UC3);
+    const size_t num_frames = seq.frames.size();
+    using Clock = std::chrono::steady_clock;
+
+    // one frame after the other
+    {
+        auto tracker = create_tracker(tracker_name, image_size);
+        auto t0 = Clock::now();
+        for (size_t i = 0; i < num_frames; i++) {
+            sleep_ms(decode_ms);
+            sleep_ms(detect_ms);
+            auto detections = copy_detections(seq.frames[i]);
+            if (i == 0)
+                tracker->begin_track(blank, detections, (int)i);
+            else
+                tracker->track(blank, detections, (int)i);
+            sleep_ms(sink_ms);
+        }
+        tracker->finish_track();
+        double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+        std::printf("%-12s %8.1f frames/s\n", "serial", num_frames / seconds);
+    }
+
+    // pipelined
+    {
+        rxt::TrackingPipeline pipeline;
+        pipeline.init(create_tracker(tracker_name, image_size), pipeline_param);
+        size_t next_frame = 0;
+        pipeline.start(
+            [&](cv::Mat &img) {
+                if (next_frame == num_frames)
+                    return false;
+                next_frame++;
+                sleep_ms(decode_ms);
+                img = blank;
+                return true;
+            },
+            [&](rxt::PipelineFrame &frame) {
+                sleep_ms(detect_ms);
+                frame.detections = copy_detections(seq.frames[frame.frame_number]);
+            },
+            [&](rxt::PipelineFrame &frame) { sleep_ms(sink_ms); });
+        pipeline.wait();
+
+        const char *names[] = {"decode", "detect", "track", "sink"};
+        std::printf("%-12s %8.1f frames/s\n", "pipeline",
+                    pipeline.get_stage_stats(rxt::TrackingPipeline::Sink).get_throughput());
+        for (int s = 0; s < rxt::TrackingPipeline::NumStages; s++) {
+            rxt::PipelineStageStats stats = pipeline.get_stage_stats((rxt::TrackingPipeline::Stage)s);
+            std::printf("  %-10s %6zu frames %6zu dropped, busy %5.1f%%, max queue %zu\n", names[s],
+                        stats.num_frames, stats.num_dropped, stats.get_utilization() * 100, stats.max_queue_depth);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * replay a MOT-format detection file through the trackers and report per-frame latency,
+ * no detector is involved so the numbers only contain tracker time.
+ *
+ * usage: redoxi_bench [mot_file] [--width W] [--height H] [--feature-dim D] [--tracker NAME] [--threads T]
+ *   mot_file       lines of frame,id,x,y,w,h,conf,class,visibility (default: dancetrack-0039 ground truth)
+ *   --feature-dim  attach a synthetic unit feature to each detection (derived from the track id), 0 = no feature
+ *   --tracker      only run one of simple_sort, deep_sort, botsort, optical_flow
+ *   --threads      build the large cost matrices of a frame on a pool of T threads, 0 = single threaded (default 0)
+ */
+#include <RedoxiTrack/RedoxiTrack.h>
+#include <RedoxiTrack/utils/StageTimer.h>
+
+#include "mot_sequence.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+namespace rxt = RedoxiTrack;
+
+namespace
+{
+struct FrameTiming {
+    double total = 0;
+    double stages[rxt::StageTimer::NumStages] = {0};
+};
+
+double percentile(std::vector<double> values, double q)
+{
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    size_t k = std::min(values.size() - 1, (size_t)(q * (values.size() - 1) + 0.5));
+    return values[k];
+}
+
+void report(const std::string &name, const std::vector<FrameTiming> &timings)
+{
+    std::vector<std::string> labels;
+    std::vector<std::vector<double>> columns;
+    for (int s = 0; s < rxt::StageTimer::NumStages; s++) {
+        labels.push_back(rxt::StageTimer::get_stage_name((rxt::StageTimer::Stage)s));
+        columns.emplace_back();
+    }
+    labels.push_back("bookkeeping");
+    columns.emplace_back();
+    labels.push_back("total");
+    columns.emplace_back();
+
+    for (auto &t : timings) {
+        double measured = 0;
+        for (int s = 0; s < rxt::StageTimer::NumStages; s++) {
+            columns[s].push_back(t.stages[s] * 1e3);
+            measured += t.stages[s];
+        }
+        // whatever is not covered by a stage is target bookkeeping (events, state updates, creation/deletion)
+        columns[rxt::StageTimer::NumStages].push_back(std::max(0.0, t.total - measured) * 1e3);
+        columns[rxt::StageTimer::NumStages + 1].push_back(t.total * 1e3);
+    }
+
+    std::printf("\n== %s (%zu frames), milliseconds per track() call\n", name.c_str(), timings.size());
+    std::printf("%-20s %10s %10s %10s %10s\n", "stage", "mean", "p50", "p99", "max");
+    for (size_t i = 0; i < labels.size(); i++) {
+        double sum = 0;
+        for (auto v : columns[i])
+            sum += v;
+        double mean = columns[i].empty() ? 0 : sum / columns[i].size();
+        std::printf("%-20s %10.4f %10.4f %10.4f %10.4f\n", labels[i].c_str(), mean,
+                    percentile(columns[i], 0.5), percentile(columns[i], 0.99),
+                    columns[i].empty() ? 0 : *std::max_element(columns[i].begin(), columns[i].end()));
+    }
+}
+
+std::vector<FrameTiming> run(const rxt::TrackerBasePtr &tracker, const MotSequence &seq, const cv::Mat &img)
+{
+    auto timer = std::make_shared<rxt::StageTimer>();
+    tracker->set_stage_timer(timer);
+
+    std::vector<FrameTiming> timings;
+    timings.reserve(seq.frames.size());
+    tracker->begin_track(img, seq.frames[0], 0);
+    for (size_t i = 1; i < seq.frames.size(); i++) {
+        timer->reset();
+        auto t0 = std::chrono::steady_clock::now();
+        tracker->track(img, seq.frames[i], (int)i);
+        auto t1 = std::chrono::steady_clock::now();
+
+        FrameTiming t;
+        t.total = std::chrono::duration<double>(t1 - t0).count();
+        for (int s = 0; s < rxt::StageTimer::NumStages; s++)
+            t.stages[s] = timer->get((rxt::StageTimer::Stage)s);
+        timings.push_back(t);
+    }
+    tracker->finish_track();
+    tracker->set_stage_timer(nullptr);
+    return timings;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string mot_file = REDOXI_BENCH_DEFAULT_MOT_FILE;
+    int width = 1920;
+    int height = 1080;
+    int feature_dim = 0;
+    std::string only_tracker;
+    int num_threads = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--width" && i + 1 < argc)
+            width = std::atoi(argv[++i]);
+        else if (arg == "--height" && i + 1 < argc)
+            height = std::atoi(argv[++i]);
+        else if (arg == "--feature-dim" && i + 1 < argc)
+            feature_dim = std::atoi(argv[++i]);
+        else if (arg == "--tracker" && i + 1 < argc)
+            only_tracker = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc)
+            num_threads = std::atoi(argv[++i]);
+        else if (arg == "-h" || arg == "--help") {
+            std::printf("usage: %s [mot_file] [--width W] [--height H] [--feature-dim D] [--tracker NAME] [--threads T]\n",
+                        argv[0]);
+            return 0;
+        } else
+            mot_file = arg;
+    }
+
+    MotSequence seq;
+    if (!load_mot_file(mot_file, feature_dim, seq)) {
+        std::fprintf(stderr, "failed to load detections from %s\n", mot_file.c_str());
+        return 1;
+    }
+    std::printf("loaded %zu detections in %zu frames from %s, feature dim %d\n",
+                seq.num_detections, seq.frames.size(), mot_file.c_str(), feature_dim);
+
+    // the trackers only need an image for optical flow, a blank frame keeps decoding out of the numbers
+    cv::Mat img = cv::Mat::zeros(height, width, CV_8UC3);
+    cv::Size image_size(width, height);
+
+    std::vector<std::pair<std::string, std::function<rxt::TrackerBasePtr()>>> trackers = {
+        {"simple_sort", [&]() {
+             auto tracker = std::make_shared<rxt::SimpleSortTracker>();
+             rxt::SimpleSortTrackerParam param;
+             param.set_preferred_image_size(image_size);
+             tracker->init(param);
+             return tracker;
+         }},
+        {"deep_sort", [&]() {
+             auto tracker = std::make_shared<rxt::DeepSortTracker>();
+             rxt::DeepSortTrackerParam param;
+             param.set_preferred_image_size(image_size);
+             tracker->init(param);
+             return tracker;
+         }},
+        {"botsort", [&]() {
+             auto tracker = std::make_shared<rxt::BotsortTracker>();
+             rxt::BotsortTrackerParam param;
+             param.set_preferred_image_size(image_size);
+             tracker->init(param);
+             return tracker;
+         }},
+        {"optical_flow", [&]() {
+             auto tracker = std::make_shared<rxt::OpticalFlowTracker>();
+             rxt::OpticalTrackerParam param;
+             param.set_preferred_image_size(image_size);
+             tracker->init(param);
+             return tracker;
+         }},
+    };
+
+    rxt::WorkStealingPoolPtr pool;
+    if (num_threads > 0) {
+        pool = std::make_shared<rxt::WorkStealingPool>();
+        pool->start(num_threads);
+    }
+
+    for (auto &p : trackers) {
+        if (!only_tracker.empty() && only_tracker != p.first)
+            continue;
+        auto tracker = p.second();
+        tracker->set_thread_pool(pool);
+        auto timings = run(tracker, seq, img);
+        report(p.first, timings);
+    }
+    return 0;
+}
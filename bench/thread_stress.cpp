@@ -0,0 +1,186 @@
+/**
+ * run many trackers at the same time, for builds with REDOXI_TRACK_WITH_TSAN. the trackers are driven
+ * - each from its own thread, sharing one WorkStealingPool for their cost matrices and the optical flow
+ *   started by submit_frame()
+ * - as the streams of a MultiStreamTracker
+ * - by a TrackingPipeline
+ * on synthetic detections with features, so that every tracker also takes its appearance path.
+ * the tracking results are not checked, the test passes if ThreadSanitizer reports nothing.
+ *
+ * usage: redoxi_thread_stress [--trackers N] [--frames F] [--threads T]
+ *   --trackers  trackers at once, simple_sort, deep_sort and botsort in turn (default 32)
+ *   --frames    frames per tracker (default 60)
+ *   --threads   threads of the shared pool and of MultiStreamTracker (default 8)
+ */
+#include <RedoxiTrack/RedoxiTrack.h>
+
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace rxt = RedoxiTrack;
+
+namespace
+{
+const cv::Size ImageSize(1920, 1080);
+const int NumObjects = 20;
+const int FeatureDim = 32;
+
+rxt::TrackerBasePtr create_tracker(int index, const rxt::WorkStealingPoolPtr &pool)
+{
+    rxt::TrackerBasePtr output;
+    if (index % 3 == 0) {
+        auto tracker = std::make_shared<rxt::SimpleSortTracker>();
+        rxt::SimpleSortTrackerParam param;
+        param.set_preferred_image_size(ImageSize);
+        param.m_parallel_min_pairs = 0;
+        tracker->init(param);
+        output = tracker;
+    } else if (index % 3 == 1) {
+        auto tracker = std::make_shared<rxt::DeepSortTracker>();
+        rxt::DeepSortTrackerParam param;
+        param.set_preferred_image_size(ImageSize);
+        param.m_parallel_min_pairs = 0;
+        tracker->init(param);
+        output = tracker;
+    } else {
+        auto tracker = std::make_shared<rxt::BotsortTracker>();
+        rxt::BotsortTrackerParam param;
+        param.set_preferred_image_size(ImageSize);
+        param.m_parallel_min_pairs = 0;
+        param.m_use_optical_before_track = true;
+        tracker->init(param);
+        output = tracker;
+    }
+    // with m_parallel_min_pairs 0 every cost matrix goes through the pool
+    output->set_thread_pool(pool);
+    return output;
+}
+
+// objects walking to the right with jittered boxes, confidences and features, a new vector per call
+std::vector<rxt::DetectionPtr> create_detections(int frame_number, int seed, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> jitter(-3, 3);
+    std::uniform_real_distribution<float> confidence(0.3f, 1.0f);
+    std::normal_distribution<float> noise(0, 1);
+    std::vector<rxt::DetectionPtr> output;
+    for (int i = 0; i < NumObjects; i++) {
+        auto det = std::make_shared<rxt::SingleDetection>();
+        float x = 50 + i * 90 + frame_number * 2 + jitter(rng);
+        float y = 100 + (i % 5) * 150 + jitter(rng);
+        det->set_bbox(rxt::BBOX(x, y, 60, 150));
+        float c = confidence(rng);
+        det->set_confidence(c);
+        det->set_quality(c);
+
+        // a fixed feature per object plus some noise per frame
+        std::mt19937 object_rng(i * 31 + seed);
+        rxt::fVECTOR feature(FeatureDim);
+        for (int k = 0; k < FeatureDim; k++)
+            feature[k] = noise(object_rng) + 0.1f * noise(rng);
+        feature.normalize();
+        det->set_feature(feature);
+        output.push_back(det);
+    }
+    return output;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int num_trackers = 32;
+    int num_frames = 60;
+    int num_threads = 8;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--trackers" && i + 1 < argc)
+            num_trackers = std::atoi(argv[++i]);
+        else if (arg == "--frames" && i + 1 < argc)
+            num_frames = std::atoi(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc)
+            num_threads = std::atoi(argv[++i]);
+        else {
+            std::printf("usage: %s [--trackers N] [--frames F] [--threads T]\n", argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    // textured, so that the optical flow finds keypoints
+    cv::Mat img(ImageSize, CV_8UC3);
+    cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(255));
+
+    auto pool = std::make_shared<rxt::WorkStealingPool>();
+    pool->start(num_threads);
+
+    // a thread per tracker
+    {
+        std::vector<std::thread> threads;
+        for (int k = 0; k < num_trackers; k++) {
+            threads.emplace_back([&, k]() {
+                std::mt19937 rng(k);
+                auto tracker = create_tracker(k, pool);
+                tracker->begin_track(img, create_detections(0, k, rng), 0);
+                for (int f = 1; f < num_frames; f++) {
+                    tracker->submit_frame(img, f);
+                    tracker->track(img, create_detections(f, k, rng), f);
+                }
+                tracker->finish_track();
+            });
+        }
+        for (auto &t : threads)
+            t.join();
+        std::printf("%-16s %d trackers x %d frames\n", "threads", num_trackers, num_frames);
+    }
+
+    // MultiStreamTracker
+    {
+        rxt::MultiStreamTracker multi_tracker;
+        multi_tracker.init(num_threads);
+        for (int k = 0; k < num_trackers; k++)
+            multi_tracker.add_stream(create_tracker(k, pool));
+
+        std::mutex mutex;
+        size_t num_targets = 0;
+        multi_tracker.set_frame_callback([&](int stream_id, int frame_number, rxt::TrackerBase &tracker) {
+            std::lock_guard<std::mutex> lock(mutex);
+            num_targets += tracker.get_all_open_targets().size();
+        });
+
+        std::vector<std::mt19937> rngs;
+        for (int k = 0; k < num_trackers; k++)
+            rngs.emplace_back(k);
+        for (int f = 0; f < num_frames; f++)
+            for (int k = 0; k < num_trackers; k++)
+                multi_tracker.submit(k, img, create_detections(f, k, rngs[k]), f);
+        for (int k = 0; k < num_trackers; k++)
+            multi_tracker.submit_finish(k);
+        multi_tracker.wait_all();
+        std::printf("%-16s %d streams, %zu open targets seen\n", "multi stream", num_trackers, num_targets);
+    }
+
+    // TrackingPipeline
+    {
+        rxt::TrackingPipeline pipeline;
+        pipeline.init(create_tracker(2, pool), rxt::TrackingPipelineParam());
+        std::mt19937 rng(0);
+        int next_frame = 0;
+        size_t num_targets = 0;
+        pipeline.start(
+            [&](cv::Mat &frame_img) {
+                if (next_frame == num_frames)
+                    return false;
+                next_frame++;
+                frame_img = img;
+                return true;
+            },
+            [&](rxt::PipelineFrame &frame) { frame.detections = create_detections(frame.frame_number, 0, rng); },
+            [&](rxt::PipelineFrame &frame) { num_targets += frame.targets.size(); });
+        pipeline.wait();
+        std::printf("%-16s %d frames, %zu open targets seen\n", "pipeline", num_frames, num_targets);
+    }
+
+    pool->stop();
+    return 0;
+}
@@ -65,5 +65,11 @@ std::filesystem::path get_yolox_model();
 /** Get YOLOX model with INT8 quantization from opencv model zoo */
 std::filesystem::path get_yolox_model_int8();
 
+/** Get person re-identification model from opencv model zoo */
+std::filesystem::path get_person_reid_model();
+
+/** Get person re-identification model with INT8 quantization from opencv model zoo */
+std::filesystem::path get_person_reid_model_int8();
+
 const std::vector<std::array<int, 3>> &get_distinct_colors();
 } // namespace RedoxiExamples
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+#include "example_common.h"
+#include <RedoxiTrack/detection/SingleDetection.h>
+#include <opencv2/dnn.hpp>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace RedoxiExamples
+{
+
+/** Configuration for the person re-identification feature extractor.
+ * The defaults match person_reid_youtu_2021nov from the opencv model zoo.
+ */
+struct PersonReidExtractorConfig {
+    std::string model_path;
+
+    // the model is quantized to int8, it runs on the CPU with the OpenCV backend
+    bool is_int8 = false;
+
+    // crops per inference, the last batch of a frame can be smaller
+    int batch_size = 16;
+
+    // set if the model was exported with a fixed batch size, the last batch
+    // of a frame is then padded to batch_size
+    bool fixed_batch = false;
+
+    cv::Size input_size = cv::Size(128, 256);         // width x height
+    cv::Scalar mean = cv::Scalar(0.485, 0.456, 0.406); // RGB, in 0..1
+    cv::Scalar std = cv::Scalar(0.229, 0.224, 0.225);  // RGB, in 0..1
+
+    cv::dnn::Backend backend = cv::dnn::DNN_BACKEND_OPENCV;
+    cv::dnn::Target target = cv::dnn::DNN_TARGET_CPU;
+};
+
+/** Computes an appearance feature for each person detection of a frame.
+ * All boxes of a frame are cropped and sent to the network in batches, the
+ * embeddings are attached to the detections with set_feature().
+ */
+class PersonReidExtractor
+{
+  public:
+    using Detection = RedoxiTrack::SingleDetection;
+    using DetectionPtr = std::shared_ptr<Detection>;
+    using DetectionList = std::vector<DetectionPtr>;
+
+    PersonReidExtractor(){};
+    virtual ~PersonReidExtractor(){};
+
+    virtual void init(const PersonReidExtractorConfig &config);
+
+    /** Compute and attach the features of the detections.
+     * Detections whose box is outside the frame are left without feature.
+     * @param frame the frame the detections were found in, BGR
+     * @param detections the detections of the frame
+     */
+    virtual void extract(const cv::Mat &frame, const DetectionList &detections);
+
+    /** Number of crops processed since init() or reset_statistics() */
+    size_t get_num_crops() const
+    {
+        return m_num_crops;
+    }
+
+    /** Crops per second of extract(), including cropping and preprocessing */
+    double get_crops_per_second() const
+    {
+        return m_seconds > 0 ? m_num_crops / m_seconds : 0;
+    }
+
+    void reset_statistics()
+    {
+        m_num_crops = 0;
+        m_seconds = 0;
+    }
+
+  protected:
+    /** Run the network on crops [first, last) and write one feature per row
+     * of m_features, starting at row first
+     */
+    virtual void _infer_batch(size_t first, size_t last);
+
+  protected:
+    PersonReidExtractorConfig m_config;
+    cv::dnn::Net m_net;
+
+    // reused across frames
+    std::vector<cv::Mat> m_crops;
+    std::vector<size_t> m_crop_owners; // index of the detection of each crop
+    cv::Mat m_features;                // one row per crop
+
+    size_t m_num_crops = 0;
+    double m_seconds = 0;
+};
+
+}; // namespace RedoxiExamples
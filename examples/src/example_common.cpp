@@ -105,6 +105,16 @@ std::filesystem::path get_yolox_model_int8()
     return Paths::DataDir / "tmp" / "object_detection_yolox_2022nov_int8.onnx";
 }
 
+std::filesystem::path get_person_reid_model()
+{
+    return Paths::DataDir / "tmp" / "person_reid_youtu_2021nov.onnx";
+}
+
+std::filesystem::path get_person_reid_model_int8()
+{
+    return Paths::DataDir / "tmp" / "person_reid_youtu_2021nov_int8.onnx";
+}
+
 const std::vector<std::array<int, 3>> &get_distinct_colors()
 {
     return distinct_colors;
@@ -0,0 +1,101 @@
+#include "example_reid_extractor.h"
+#include <algorithm>
+
+namespace RedoxiExamples
+{
+
+void PersonReidExtractor::init(const PersonReidExtractorConfig &config)
+{
+    if (config.model_path.empty())
+        throw std::runtime_error("Model not set");
+    if (config.batch_size <= 0)
+        throw std::runtime_error("Batch size must be positive");
+
+    this->m_config = config;
+    this->m_net = cv::dnn::readNet(config.model_path);
+
+    // quantized layers are only implemented by the OpenCV CPU backend
+    if (config.is_int8) {
+        this->m_config.backend = cv::dnn::DNN_BACKEND_OPENCV;
+        this->m_config.target = cv::dnn::DNN_TARGET_CPU;
+    }
+    this->m_net.setPreferableBackend(this->m_config.backend);
+    this->m_net.setPreferableTarget(this->m_config.target);
+    this->reset_statistics();
+}
+
+void PersonReidExtractor::extract(const cv::Mat &frame,
+                                  const DetectionList &detections)
+{
+    if (this->m_net.empty())
+        throw std::runtime_error("Model not set");
+
+    cv::TickMeter timer;
+    timer.start();
+
+    // crop all boxes first, so that the network sees full batches
+    cv::Rect frame_rect(0, 0, frame.cols, frame.rows);
+    this->m_crops.clear();
+    this->m_crop_owners.clear();
+    for (size_t i = 0; i < detections.size(); i++) {
+        cv::Rect box = cv::Rect(detections[i]->get_bbox()) & frame_rect;
+        if (box.empty())
+            continue;
+        this->m_crops.push_back(frame(box));
+        this->m_crop_owners.push_back(i);
+    }
+    if (this->m_crops.empty())
+        return;
+
+    const size_t batch_size = this->m_config.batch_size;
+    for (size_t first = 0; first < this->m_crops.size(); first += batch_size)
+        this->_infer_batch(first,
+                           std::min(first + batch_size, this->m_crops.size()));
+
+    // attach the embeddings
+    for (size_t k = 0; k < this->m_crops.size(); k++) {
+        const float *row = this->m_features.ptr<float>((int)k);
+        RedoxiTrack::fVECTOR feature =
+            Eigen::Map<const RedoxiTrack::fVECTOR>(row, this->m_features.cols);
+        detections[this->m_crop_owners[k]]->set_feature(feature);
+    }
+
+    timer.stop();
+    this->m_num_crops += this->m_crops.size();
+    this->m_seconds += timer.getTimeSec();
+}
+
+void PersonReidExtractor::_infer_batch(size_t first, size_t last)
+{
+    std::vector<cv::Mat> batch(this->m_crops.begin() + first,
+                               this->m_crops.begin() + last);
+    if (this->m_config.fixed_batch) {
+        while (batch.size() < (size_t)this->m_config.batch_size)
+            batch.push_back(batch.back());
+    }
+
+    // (pixel / 255 - mean) / std, in RGB order
+    cv::dnn::Image2BlobParams params;
+    params.datalayout = cv::dnn::DNN_LAYOUT_NCHW;
+    params.ddepth = CV_32F;
+    params.size = this->m_config.input_size;
+    params.swapRB = true;
+    for (int c = 0; c < 3; c++) {
+        params.mean[c] = this->m_config.mean[c] * 255;
+        params.scalefactor[c] = 1.0 / (this->m_config.std[c] * 255);
+    }
+    cv::Mat blob = cv::dnn::blobFromImagesWithParams(batch, params);
+
+    this->m_net.setInput(blob);
+    cv::Mat output = this->m_net.forward();
+
+    // one embedding per row, whatever the spatial dimensions of the output
+    output = output.reshape(1, output.size[0]);
+    if (first == 0)
+        this->m_features.create((int)this->m_crops.size(), output.cols,
+                                CV_32F);
+    output.rowRange(0, (int)(last - first))
+        .copyTo(this->m_features.rowRange((int)first, (int)last));
+}
+
+} // namespace RedoxiExamples
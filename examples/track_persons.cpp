@@ -11,6 +11,7 @@
 #include "RedoxiTrack/tracker/TrackingEventHandler.h"
 #include "example_common.h"
 #include "example_person_detector.h"
+#include "example_reid_extractor.h"
 #include "opencv_demo_yolox.h"
 
 namespace rxt = RedoxiTrack;
@@ -22,6 +23,7 @@ struct YoloxConfig;
 
 std::shared_ptr<cv_yolox::YoloX> load_model();
 std::shared_ptr<RedoxiExamples::PersonBodyDetector> create_body_detector(const std::shared_ptr<cv_yolox::YoloX> &model);
+std::shared_ptr<RedoxiExamples::PersonReidExtractor> create_reid_extractor(bool use_int8, int batch_size);
 std::shared_ptr<rxt::DeepSortTracker> create_deepsort_tracker(cv::Size image_size, std::shared_ptr<rxt::ExternalTrackingEventHandler> event_handler);
 std::shared_ptr<rxt::SimpleSortTracker> create_simple_sort_tracker(cv::Size image_size, std::shared_ptr<rxt::ExternalTrackingEventHandler> event_handler);
 std::shared_ptr<rxt::BotsortTracker> create_botsort_tracker(cv::Size image_size, std::shared_ptr<rxt::ExternalTrackingEventHandler> event_handler);
@@ -45,6 +47,15 @@ int main()
     auto net = load_model();
     auto detector = create_body_detector(net);
 
+    // attach appearance features to the detections?
+    // disabled by default, unless explicitly enabled
+    std::shared_ptr<ex::PersonReidExtractor> reid_extractor;
+    if (ex::get_and_print_env("REDOXI_EXAMPLE_ENABLE_REID") == "1") {
+        bool use_int8 = ex::get_and_print_env("REDOXI_EXAMPLE_REID_INT8") == "1";
+        std::string batch_size = ex::get_and_print_env("REDOXI_EXAMPLE_REID_BATCH_SIZE");
+        reid_extractor = create_reid_extractor(use_int8, batch_size.empty() ? 16 : std::stoi(batch_size));
+    }
+
     // load video
     auto video_sample =
         ex::get_video_tracking_sample(ex::ExampleData::DancetrackSample);
@@ -123,9 +134,16 @@ int main()
     while (cap.read(frame)) {
         spdlog::info("Processing frame {}, size: {}x{}, channels: {}", ith_frame,
                      frame.cols, frame.rows, frame.channels());
+        // trackers with optical flow compute it while the detector runs, track() below joins it
+        if (ith_frame > 0)
+            tracker->submit_frame(frame, ith_frame);
         spdlog::info("Detecting persons ...");
         auto person_list = detector->detect(frame);
         spdlog::info("Detected {} persons", person_list.size());
+        if (reid_extractor) {
+            reid_extractor->extract(frame, person_list);
+            spdlog::info("Extracted features, {:.1f} crops/s", reid_extractor->get_crops_per_second());
+        }
 
         // if this is the first frame, call begin_track()
         std::vector<rxt::DetectionPtr> _detlist;
@@ -186,6 +204,10 @@ int main()
 
     // finish tracking, must be called after tracking is done
     tracker->finish_track();
+    if (reid_extractor) {
+        spdlog::info("Feature extraction: {} crops, {:.1f} crops/s", reid_extractor->get_num_crops(),
+                     reid_extractor->get_crops_per_second());
+    }
 
     if (use_visualization) {
         cv::waitKey(0);
@@ -313,5 +335,30 @@ std::shared_ptr<RedoxiExamples::PersonBodyDetector> create_body_detector(const s
     return detector;
 }
 
+std::shared_ptr<RedoxiExamples::PersonReidExtractor> create_reid_extractor(bool use_int8, int batch_size)
+{
+    auto model_file = use_int8 ? ex::get_person_reid_model_int8() : ex::get_person_reid_model();
+    if (!fs::exists(model_file)) {
+        spdlog::error("Model file not found: {}, configure with WITH_EXAMPLE_REID_MODELS=ON", model_file.string());
+        throw std::runtime_error("Model file not found");
+    }
+
+    spdlog::info("Loading re-identification model from file: {}, batch size {}", model_file.string(), batch_size);
+    RedoxiExamples::PersonReidExtractorConfig config;
+    config.model_path = model_file.string();
+    config.is_int8 = use_int8;
+    config.batch_size = batch_size;
+
+    // the int8 model only runs on the CPU
+    YoloxConfig device;
+    if (!use_int8) {
+        config.backend = device.backend;
+        config.target = device.target;
+    }
+
+    auto extractor = std::make_shared<RedoxiExamples::PersonReidExtractor>();
+    extractor->init(config);
+    return extractor;
+}
 
 /** @brief Event handler to collect tracking events */
@@ -20,6 +20,8 @@
 #include "RedoxiTrack/tracker/DeepSortTracker.h"
 #include "RedoxiTrack/tracker/SimpleSortTracker.h"
 #include "RedoxiTrack/tracker/BotsortTracker.h"
+#include "RedoxiTrack/tracker/MultiStreamTracker.h"
+#include "RedoxiTrack/tracker/TrackingPipeline.h"
 
 #include "RedoxiTrack/tracker/DeepSortMotionPrediction.h"
 #include "RedoxiTrack/tracker/SimpleSortMotionPrediction.h"
@@ -17,6 +17,9 @@ class REDOXI_TRACK_API DeepSortTrackTarget : public TrackTarget
     virtual DetectionPtr clone() const override;
     virtual void copy_to(Detection &target) const override;
 
+    virtual DetectionPtr clone(bool with_detection) const override;
+    virtual void copy_to(Detection &target, bool with_detection) const override;
+
     void print() override;
 };
 using DeepSortTrackTargetPtr = std::shared_ptr<DeepSortTrackTarget>;
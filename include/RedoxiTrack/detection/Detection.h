@@ -2,12 +2,16 @@
 
 #include "RedoxiTrack/RedoxiTrackConfig.h"
 #include "RedoxiTrack/detection/IDObject.h"
+#include "RedoxiTrack/utils/PackedFeatures.h"
 
 namespace RedoxiTrack
 {
 class Detection;
 using DetectionPtr = std::shared_ptr<Detection>;
 
+// read-only view of a feature, see Detection::feature_view()
+using FeatureView = Eigen::Map<const fVECTOR>;
+
 /**
  * a general detection
  */
@@ -55,6 +59,31 @@ class REDOXI_TRACK_API Detection : public IDObject
         return x;
     }
 
+    /**
+     * get the feature without copy, the view is valid until the feature is changed.
+     * a detection with a feature maps its own storage, one without returns an empty view
+     * @return
+     */
+    virtual FeatureView feature_view() const = 0;
+
+    /**
+     * whether the detection has a non-empty feature
+     * @return
+     */
+    virtual bool has_feature() const
+    {
+        return feature_view().size() != 0;
+    }
+
+    /**
+     * the feature packed by the tracker for comparison, see FeatureTraits::pack_feature(), null if there is none
+     * @return
+     */
+    virtual const PackedFeatures *packed_feature() const
+    {
+        return nullptr;
+    }
+
     /**
      * create new detection which has same content
      * @return
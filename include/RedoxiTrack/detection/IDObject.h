@@ -1,20 +1,19 @@
 #pragma once
 
 #include "RedoxiTrack/RedoxiTrackConfig.h"
+#include <cstdint>
 
 namespace RedoxiTrack
 {
 
-// object with globally unique id
+// object with globally unique id, ids are drawn from one atomic 64-bit counter so that
+// objects may be created on any thread, see the thread safety notes of TrackerBase
 class REDOXI_TRACK_API IDObject
 {
   private:
-    int m_id = 0;
-    static int generate_id()
-    {
-        static int _id = 0;
-        return _id++;
-    }
+    int64_t m_id = 0;
+    // defined in the library, so that every module shares one counter
+    static int64_t generate_id();
 
   public:
     IDObject()
@@ -25,7 +24,7 @@ class REDOXI_TRACK_API IDObject
     {
     }
 
-    int get_id() const
+    int64_t get_id() const
     {
         return m_id;
     }
@@ -5,8 +5,7 @@
 
 #include "RedoxiTrack/RedoxiTrackConfig.h"
 #include "RedoxiTrack/detection/TrackTarget.h"
-// #include "opencv2/highgui/highgui.hpp"
-#include "opencv2/video/tracking.hpp"
+#include "RedoxiTrack/utils/KalmanFilter.h"
 
 
 namespace RedoxiTrack
@@ -14,25 +13,28 @@ namespace RedoxiTrack
 class REDOXI_TRACK_API KalmanTrackTarget : public TrackTarget
 {
   public:
-    cv::KalmanFilter &get_kf()
+    KalmanFilter &get_kf()
     {
         return m_kf;
     }
-    const cv::KalmanFilter &get_kf() const
+    const KalmanFilter &get_kf() const
     {
         return m_kf;
     }
-    void set_kf(const cv::KalmanFilter &input_kf)
+    void set_kf(const KalmanFilter &input_kf)
     {
         m_kf = input_kf;
     }
     virtual DetectionPtr clone() const override;
     virtual void copy_to(Detection &target) const override;
 
+    virtual DetectionPtr clone(bool with_detection) const override;
+    virtual void copy_to(Detection &target, bool with_detection) const override;
+
     void print() override;
 
   protected:
-    cv::KalmanFilter m_kf;
+    KalmanFilter m_kf;
 
   public:
     /**
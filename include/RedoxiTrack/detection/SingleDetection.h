@@ -12,12 +12,23 @@ class REDOXI_TRACK_API SingleDetection : public Detection
   protected:
     BBOX m_bbox;
     fVECTOR m_feature;
+    PackedFeatures m_packed_feature;
     float m_confidence;
     float m_quality;
 
   public:
     virtual void set_bbox(const BBOX &box);
+    /**
+     * set the feature, which drops the packed feature
+     * @param x
+     */
     virtual void set_feature(const fVECTOR &x);
+
+    /**
+     * keep the feature packed for comparison, one row packed from the current feature
+     * @param x
+     */
+    virtual void set_packed_feature(const PackedFeatures &x);
     virtual void set_confidence(const float &conf);
     virtual void set_quality(const float &q);
 
@@ -32,6 +43,19 @@ class REDOXI_TRACK_API SingleDetection : public Detection
     virtual void get_feature(fVECTOR &output) const override;
     virtual fVECTOR get_feature() const override;
 
+    virtual FeatureView feature_view() const override
+    {
+        return FeatureView(m_feature.data(), m_feature.size());
+    }
+    virtual bool has_feature() const override
+    {
+        return m_feature.size() != 0;
+    }
+    virtual const PackedFeatures *packed_feature() const override
+    {
+        return m_packed_feature.size() != 0 ? &m_packed_feature : nullptr;
+    }
+
     DetectionPtr clone() const override;
 
     void copy_to(Detection &to) const override;
@@ -24,11 +24,13 @@ class REDOXI_TRACK_API HungarianAlgorithm
     HungarianAlgorithm();
     ~HungarianAlgorithm();
     float Solve(vector<vector<float>> &DistMatrix, vector<int> &Assignment);
+    // DistMatrix is row-major, element (i, j) is at DistMatrix[i * rowStride + j]
+    float Solve(const float *DistMatrix, int nRows, int nCols, size_t rowStride, vector<int> &Assignment);
 
   private:
-    void assignmentoptimal(int *assignment, float *cost, float *distMatrix, int nOfRows, int nOfColumns);
+    void assignmentoptimal(int *assignment, float *cost, const float *distMatrix, size_t rowStride, int nOfRows, int nOfColumns);
     void buildassignmentvector(int *assignment, bool *starMatrix, int nOfRows, int nOfColumns);
-    void computeassignmentcost(int *assignment, float *cost, float *distMatrix, int nOfRows);
+    void computeassignmentcost(int *assignment, float *cost, const float *distMatrix, size_t rowStride, int nOfRows);
     void step2a(int *assignment, float *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim);
     void step2b(int *assignment, float *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim);
     void step3(int *assignment, float *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim);
@@ -73,6 +73,24 @@ extern REDOXI_TRACK_API int_t lapjv_internal(
     const uint_t n, cost_t *cost[],
     int_t *x, int_t *y);
 
+/** Same as lapjv_internal, but reads a row-major float matrix where cost[i][j] is cost[i * stride + j],
+ * costs are widened to cost_t while solving.
+ */
+extern REDOXI_TRACK_API int_t lapjv_internal_flat(
+    const uint_t n, const float *cost, const uint_t stride,
+    int_t *x, int_t *y);
+
+/** Rectangular assignment on a row-major float matrix (cost[i][j] is cost[i * stride + j]) where any row or column
+ * may stay unassigned. Leaving a row and a column unassigned costs thresh, so pairs with cost above thresh are
+ * never assigned. This gives the same assignment as padding to (n_rows + n_cols) square with thresh / 2
+ * for unassigned rows and columns and calling lapjv_internal, without building the padded matrix.
+ * On return x[i] is the column of row i and y[j] the row of column j, -1 if unassigned.
+ */
+extern REDOXI_TRACK_API int_t lapjv_rectangular(
+    const uint_t n_rows, const uint_t n_cols,
+    const float *cost, const uint_t stride, const float thresh,
+    int_t *x, int_t *y);
+
 extern REDOXI_TRACK_API int_t lapmod_internal(
     const uint_t n, cost_t *cc, uint_t *ii, uint_t *kk,
     int_t *x, int_t *y, fp_t fp_version);
@@ -13,6 +13,11 @@
 #include "RedoxiTrack/tracker/TrackerBase.h"
 #include "RedoxiTrack/tracker/TrackingEventHandler.h"
 #include "RedoxiTrack/utils/CosineFeature.h"
+#include "RedoxiTrack/utils/BoxArray.h"
+#include "RedoxiTrack/utils/CostMatrix.h"
+#include "RedoxiTrack/utils/FeatureGallery.h"
+#include "RedoxiTrack/utils/FeatureIndex.h"
+#include "RedoxiTrack/utils/SpatialGrid.h"
 #include "opencv2/core/core_c.h"
 // #include "opencv2/highgui.hpp"
 
@@ -31,6 +36,12 @@ class REDOXI_TRACK_API BotsortTracker : public TrackerBase
         DefaultDetectionTraits(BotsortTracker *p);
         FeatureTraitsPtr get_feature_traits() const override;
 
+        // b must be targets of the tracker, see BotsortTracker::_compute_feature_distance()
+        void compute_distance_matrix(const Detection *const *a, size_t size_a, const Detection *const *b,
+                                     size_t size_b, CostMatrix &output) override;
+        void compute_distance_matrix(const Detection *const *a, size_t size_a, const Detection *const *b,
+                                     size_t size_b, const CandidatePairs &candidates, CostMatrix &output) override;
+
       public:
       protected:
         BotsortTracker *m_tracker = nullptr;
@@ -114,6 +125,14 @@ class REDOXI_TRACK_API BotsortTracker : public TrackerBase
     void
         track(const cv::Mat &img, int frame_number) override;
 
+    /**
+     * start the optical flow of the next frame on the thread pool of this tracker, see TrackerBase::submit_frame().
+     * does nothing unless BotsortTrackerParam::m_use_optical_before_track is set
+     * @param img
+     * @param frame_number
+     */
+    void submit_frame(const cv::Mat &img, int frame_number) override;
+
     virtual void push_tracking_state() override;
 
     virtual void pop_tracking_state(bool apply = true) override;
@@ -152,6 +171,14 @@ class REDOXI_TRACK_API BotsortTracker : public TrackerBase
   protected:
     void _update_features(BotsortTrackTargetPtr &target, const fVECTOR &features);
 
+    /**
+     * add the feature of source to the target's gallery, if galleries are enabled. the packed feature of source
+     * is added as it is if m_feature_traits compares packed features
+     * @param target
+     * @param source the target itself or its matched detection, the feature is normalized here
+     */
+    void _update_gallery(const TrackTargetPtr &target, const Detection &source);
+
     void _bbox2xcycwh(const BBOX &bbox, cv::Mat &output);
 
     void _match_maha_distance(const std::vector<DetectionPtr> &sources,
@@ -168,8 +195,69 @@ class REDOXI_TRACK_API BotsortTracker : public TrackerBase
                              std::vector<int> &output_unmatched_source,
                              std::vector<int> &output_unmatched_target);
     void _remove_duplicate_targets();
+
+    /**
+     * find the overlapping pairs of m_source_boxes and m_target_boxes with the spatial grid
+     * @return false if the spatial index is disabled or the problem is too small, the caller should use all pairs
+     */
+    bool _find_candidates();
+
+    /**
+     * iou distance of m_source_boxes to m_target_boxes, only of the candidate pairs if use_candidates is true,
+     * the others are 1. all pairs are computed in tiles of rows on the thread pool, if any
+     * @param use_candidates the result of _find_candidates()
+     * @param output
+     */
+    void _compute_iou_distance(bool use_candidates, CostMatrix &output);
+
+    /**
+     * distance matrix of the default detection comparision. a target is compared by its gallery if it has one,
+     * by its smoothed feature otherwise, which the tracker keeps normalized
+     * @param a
+     * @param size_a
+     * @param b targets of this tracker
+     * @param size_b
+     * @param candidates if not null, only these pairs are computed and the others are set to the max distance
+     * @param output
+     */
+    void _compute_feature_distance(const Detection *const *a, size_t size_a, const Detection *const *b, size_t size_b,
+                                   const CandidatePairs *candidates, CostMatrix &output);
+
     void _remove_targets(vector<TrackTargetPtr> &removed);
 
+    /**
+     * move lost targets past m_max_time_lost to m_long_lost_targets, close the long lost targets past m_max_time_reid
+     * @param removed the closed targets are appended
+     */
+    void _update_long_lost(std::vector<TrackTargetPtr> &removed);
+
+    /**
+     * take the kalman and optical flow targets of a long lost target out of m_kalman_tracker and
+     * m_optical_flow_tracker, so that they are not predicted any more, or put them back when it is re-identified.
+     * the target keeps them, its motion state is restarted at the detection that takes it back
+     * @param target
+     */
+    void _detach_motion_targets(const TrackTargetPtr &target);
+    void _attach_motion_targets(const TrackTargetPtr &target);
+
+    /**
+     * match detections to long lost targets by appearance only, matched targets are found again
+     * @param detections
+     * @param unmatched indices of the detections to try, the matched ones are removed
+     * @param frame_number
+     * @param activated
+     * @param refind
+     */
+    void _reidentify_long_lost(const std::vector<DetectionPtr> &detections, std::vector<int> &unmatched, int frame_number,
+                               std::vector<TrackTargetPtr> &activated, std::vector<TrackTargetPtr> &refind);
+
+    /**
+     * in the motion only mode the targets keep no feature and share their underlying detection with the snapshot
+     * instead of cloning it, so a snapshot copies no feature at all
+     * @param state
+     */
+    void _tracking_state_fill(TrackerTrackingState &state) override;
+
     void _update_target(TrackTargetPtr &botsort_target_ptr, const DetectionPtr &det, const int &frame_number,
                         bool add_refind, std::vector<TrackTargetPtr> &activated, std::vector<TrackTargetPtr> &refind);
     /**
@@ -181,14 +269,25 @@ class REDOXI_TRACK_API BotsortTracker : public TrackerBase
      */
     void _motion_predict(const cv::Mat &img, std::vector<TrackTargetPtr> &target_pool, int frame_number);
 
-    void _fuse_score(std::vector<std::vector<float>> &dist_matrix_iou,
+    void _fuse_score(CostMatrix &dist_matrix_iou,
                      const std::vector<DetectionPtr> &detections);
 
+    // record checkpoints into m_trace_sink, these do nothing unless tracing is compiled in and enabled
+    void _trace_targets(int checkpoint, const std::map<int, TrackTargetPtr> &targets);
+    void _trace_targets(int checkpoint, const std::vector<TrackTargetPtr> &targets);
+    void _trace_detections(int checkpoint, const std::vector<DetectionPtr> &detections);
+    void _trace_matches(int checkpoint, const std::vector<std::pair<int, int>> &matched_pair);
+    void _trace_indices(int checkpoint, const std::vector<int> &indices);
+    void _trace_cost_matrix(int checkpoint, const CostMatrix &cost_matrix);
+
 
   protected:
     std::map<int, TrackTargetPtr> m_tracked_targets;
     std::map<int, TrackTargetPtr> m_lost_targets;
     std::map<int, TrackTargetPtr> m_removed_targets;
+    // lost targets past m_max_time_lost that can still be re-identified, their features are in m_reid_index
+    std::map<int, TrackTargetPtr> m_long_lost_targets;
+    FeatureIndex m_reid_index;
 
     OpticalFlowTrackerPtr m_optical_flow_tracker;
     BotsortKalmanTrackerPtr m_kalman_tracker;
@@ -197,6 +296,28 @@ class REDOXI_TRACK_API BotsortTracker : public TrackerBase
 
     DetectionTraitsPtr m_detection_comparision;
     FeatureTraitsPtr m_feature_traits;
+
+    // fixed by init() from BotsortTrackerParam::m_use_reid_feature. without appearance the tracker is motion only,
+    // features are not projected, compared, smoothed or kept by the targets, and association is by iou alone
+    bool m_use_appearance = true;
+
+    // cost matrices and box arrays reused across frames by the matching functions
+    CostMatrix m_iou_cost;
+    CostMatrix m_match_cost;
+    BoxArray m_source_boxes;
+    BoxArray m_target_boxes;
+
+    // candidate pairs of m_source_boxes and m_target_boxes, valid when _find_candidates() returns true
+    SpatialGrid m_spatial_grid;
+    CandidatePairs m_candidates;
+    // pairs within m_proximity_thresh by iou distance, the only ones compared by appearance
+    CandidatePairs m_gated_pairs;
+
+    // appearance distances, reused across frames
+    CostMatrix m_appearance_cost;
+
+    // recent features of each target, see BotsortTrackerParam::m_gallery_size
+    FeatureGallery m_feature_gallery;
 };
 using BotsortTrackerPtr = std::shared_ptr<BotsortTracker>;
 } // namespace RedoxiTrack
@@ -6,6 +6,7 @@
 #include "RedoxiTrack/RedoxiTrackConfig.h"
 #include "RedoxiTrack/tracker/OpticalTrackerParam.h"
 #include "RedoxiTrack/tracker/TrackerParam.h"
+#include "RedoxiTrack/utils/FeatureGallery.h"
 
 
 namespace RedoxiTrack
@@ -33,15 +34,40 @@ class REDOXI_TRACK_API BotsortTrackerParam : public TrackerParam
     float m_new_track_thresh = 0.7; // botsort nni 0.5   bytetrack0.6  botsort 0.7
     int m_keep_track_buffer = 30;
     int m_max_time_lost = 30;
+    // after m_max_time_lost, lost targets with a feature are kept m_max_time_reid more frames (0 to disable) in an
+    // approximate nearest neighbour index of their features. a high score detection left unmatched by the other
+    // associations takes such a target back if their appearance distance is below m_reid_thresh
+    int m_max_time_reid = 0;
+    float m_reid_thresh = 0.15;
+    // links per target and search width of the index, see FeatureIndex
+    int m_reid_index_neighbors = 16;
+    int m_reid_index_ef = 64;
+    // closest long lost targets found in the index for each detection, the candidates of the re-identification
+    int m_reid_num_neighbors = 4;
     float m_match_thresh = 0.8; // botsort nni 0.6   bytetrack0.8  botsort 0.8
     float m_aspect_ratio_thresh = 1.6;
     float m_min_box_area = 10.0;
     float m_proximity_thresh = 0.5;
     float m_appearance_thresh = 0.25; // botsort nni 0.5   botsort 0.25
     float m_alpha_smooth_features = 0.9;
+    // file written by FeatureProjection::save() (e.g. by redoxi_fit_projection), empty to disable. the features of
+    // the detections are projected by it when they enter the tracker, everything after works on the projected ones
+    std::string m_feature_projection_file;
+    // besides the smoothed feature, keep the last m_gallery_size features of each track (0 to disable) and match
+    // by their min or mean distance. memory is bounded by m_gallery_size x feature dim x m_gallery_max_tracks
+    int m_gallery_size = 0;
+    int m_gallery_max_tracks = 256;
+    FeatureGallery::QueryMode m_gallery_query_mode = FeatureGallery::QueryMode::Min;
     bool m_use_optical_before_track = false;
     bool m_fuse_score = false; // botsort/bytetrack false
+    // false makes the tracker motion only, every feature path is skipped including re-identification, see
+    // BotsortTracker::m_use_appearance. detections without feature are matched by iou either way
     bool m_use_reid_feature = true;
+    // only pairs whose boxes overlap (after growing by the radius in pixels) reach the cost matrices,
+    // found with a uniform grid over the targets once a matching has at least m_spatial_index_min_pairs pairs
+    bool m_use_spatial_index = true;
+    float m_spatial_index_radius = 0;
+    int m_spatial_index_min_pairs = 1024;
     OpticalTrackerParam m_optical_param;
     TrackerParam m_kalman_param;
 };
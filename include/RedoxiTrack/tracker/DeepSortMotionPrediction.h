@@ -11,12 +11,16 @@ namespace RedoxiTrack
 class REDOXI_TRACK_API DeepSortMotionPrediction : public MotionPredictionByKalman
 {
   public:
+    // the batched predict() and update() of the base class
+    using MotionPredictionByKalman::predict;
+    using MotionPredictionByKalman::update;
+
     /**
      * init kalmanFilter's state
      * @param kf
      * @param bbox
      */
-    void init(cv::KalmanFilter &kf, const BBOX &bbox) override;
+    void init(KalmanFilter &kf, const BBOX &bbox) override;
 
     /**
      * kalmanFilter predict, x_t = A*x_{t-1}
@@ -25,21 +29,21 @@ class REDOXI_TRACK_API DeepSortMotionPrediction : public MotionPredictionByKalma
      * @param delta_frame_number
      * @param flag
      */
-    void predict(cv::KalmanFilter &kf, BBOX &output_bbox, int delta_frame_number, const bool flag = false) override;
+    void predict(KalmanFilter &kf, BBOX &output_bbox, int delta_frame_number, const bool flag = false) override;
 
     /**
      * update kalmanFilter, ^x_t = Ax_{t-1} + k(z_t - CAx_{t-1})
      * @param kf
      * @param bbox
      */
-    void update(cv::KalmanFilter &kf, const BBOX &bbox) override;
+    void update(KalmanFilter &kf, const BBOX &bbox) override;
 
     /**
-     * get updated bbox from kalmanFilter's statePost
+     * get updated bbox from kalmanFilter's state_post
      * @param kf
      * @param output_bbox
      */
-    void get_bbox_state(cv::KalmanFilter &kf, BBOX &output_bbox) override;
+    void get_bbox_state(KalmanFilter &kf, BBOX &output_bbox) override;
 
     /**
      * get kalmanFilter's measurement mean and covariance, c*x_t and cP_tc'+measurementNoiseCov
@@ -47,14 +51,22 @@ class REDOXI_TRACK_API DeepSortMotionPrediction : public MotionPredictionByKalma
      * @param output_mean
      * @param output_covariance
      */
-    void project_state2measurement(cv::KalmanFilter &kf, cv::Mat &output_mean,
-                                   cv::Mat &output_covariance) const override;
+    void project_state2measurement(KalmanFilter &kf, KalmanFilter::MeasureVector &output_mean,
+                                   KalmanFilter::MeasureMatrix &output_covariance) const override;
 
     MotionPredictionByKalmanPtr clone() const override;
 
     void copy_to(MotionPredictionByKalman &to) const override;
 
   protected:
+    bool _is_constant_velocity() const override
+    {
+        return true;
+    }
+    void _prepare_predict(KalmanFilter &kf, int delta_frame_number, bool flag) override;
+    void _prepare_update(KalmanFilter &kf, const BBOX &bbox, KalmanFilter::MeasureVector &output_measurement) override;
+    void _state2bbox(const KalmanFilter::StateVector &state, BBOX &output_bbox) const override;
+
     static void _bbox2xyah(const BBOX &bbox, std::vector<float> &output);
     static void _xyah2bbox(float x, float y, float a, float h, BBOX &output_bbox);
 
@@ -64,7 +76,7 @@ class REDOXI_TRACK_API DeepSortMotionPrediction : public MotionPredictionByKalma
      */
     float m_std_weight_position = 1.0 / 20.0;
     float m_std_weight_velocity = 1.0 / 160.0;
-    cv::Mat m_update_measurement;
+    KalmanFilter::MeasureVector m_update_measurement = KalmanFilter::MeasureVector::Zero();
 };
 using DeepSortMotionPredictionPtr = std::shared_ptr<DeepSortMotionPrediction>;
 } // namespace RedoxiTrack
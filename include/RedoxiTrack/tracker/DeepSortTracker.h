@@ -11,6 +11,9 @@
 #include "RedoxiTrack/tracker/OpticalFlowTracker.h"
 #include "RedoxiTrack/tracker/TrackerBase.h"
 #include "RedoxiTrack/tracker/TrackingEventHandler.h"
+#include "RedoxiTrack/utils/BoxArray.h"
+#include "RedoxiTrack/utils/CostMatrix.h"
+#include "RedoxiTrack/utils/FeatureGallery.h"
 
 namespace RedoxiTrack
 {
@@ -25,6 +28,16 @@ class REDOXI_TRACK_API DeepSortTracker : public TrackerBase
         DefaultDetectionTraits(DeepSortTracker *p);
         FeatureTraitsPtr get_feature_traits() const override;
 
+        // b must be targets of the tracker, see
+        // DeepSortTracker::_compute_feature_distance()
+        void compute_distance_matrix(const Detection *const *a, size_t size_a,
+                                     const Detection *const *b, size_t size_b,
+                                     CostMatrix &output) override;
+        void compute_distance_matrix(const Detection *const *a, size_t size_a,
+                                     const Detection *const *b, size_t size_b,
+                                     const CandidatePairs &candidates,
+                                     CostMatrix &output) override;
+
       public:
       protected:
         DeepSortTracker *m_tracker = nullptr;
@@ -121,6 +134,14 @@ class REDOXI_TRACK_API DeepSortTracker : public TrackerBase
 
     void track(const cv::Mat &img, int frame_number) override;
 
+    /**
+     * start the optical flow of the next frame on the thread pool of this tracker, see TrackerBase::submit_frame().
+     * does nothing unless DeepSortTrackerParam::m_use_optical_before_track is set
+     * @param img
+     * @param frame_number
+     */
+    void submit_frame(const cv::Mat &img, int frame_number) override;
+
     virtual void push_tracking_state() override;
 
     virtual void pop_tracking_state(bool apply = true) override;
@@ -164,7 +185,44 @@ class REDOXI_TRACK_API DeepSortTracker : public TrackerBase
     void _update_features(DeepSortTrackTargetPtr &target,
                           const fVECTOR &features);
 
-    void _bbox2xyah(const BBOX &bbox, cv::Mat &output);
+    /**
+     * add the feature of source to the target's gallery, if galleries are
+     * enabled. the packed feature of source is added as it is if
+     * m_feature_traits compares packed features
+     * @param target
+     * @param source the target itself or its matched detection, the feature
+     * is normalized here
+     */
+    void _update_gallery(const TrackTargetPtr &target, const Detection &source);
+
+    void _bbox2xyah(const BBOX &bbox, KalmanFilter::MeasureVector &output);
+
+    /**
+     * distance matrix of the default detection comparision. a target is
+     * compared by its gallery if it has one, by its smoothed feature
+     * otherwise, which the tracker keeps normalized
+     * @param a
+     * @param size_a
+     * @param b targets of this tracker
+     * @param size_b
+     * @param candidates can be null
+     * @param output
+     */
+    void _compute_feature_distance(const Detection *const *a, size_t size_a,
+                                   const Detection *const *b, size_t size_b,
+                                   const CandidatePairs *candidates,
+                                   CostMatrix &output);
+
+    /**
+     * squared mahalanobis distance of every source to the kalman prediction of every target,
+     * output[i][j] is the distance of sources[i] to targets[j]
+     * @param sources
+     * @param targets
+     * @param output
+     */
+    void _compute_gating_distance(const std::vector<DetectionPtr> &sources,
+                                  const std::vector<TrackTargetPtr> &targets,
+                                  CostMatrix &output);
 
     void
         _match_maha_distance(const std::vector<DetectionPtr> &sources,
@@ -203,6 +261,25 @@ class REDOXI_TRACK_API DeepSortTracker : public TrackerBase
 
     DetectionTraitsPtr m_detection_comparision;
     FeatureTraitsPtr m_feature_traits;
+
+    // cost matrix and box arrays reused across frames by the matching functions
+    CostMatrix m_cost_matrix;
+    BoxArray m_source_boxes;
+    BoxArray m_target_boxes;
+
+    // appearance distances, reused across frames
+    CostMatrix m_appearance_matrix;
+    // pairs inside the gate, the only ones compared by appearance
+    CandidatePairs m_gated_pairs;
+
+    // recent features of each target, see DeepSortTrackerParam::m_gallery_size
+    FeatureGallery m_feature_gallery;
+
+    // gating distances and their inputs, reused across frames
+    CostMatrix m_gating_matrix;
+    std::vector<KalmanFilter::MeasureVector> m_source_measurements;
+    std::vector<KalmanFilter::MeasureVector> m_target_means;
+    std::vector<KalmanFilter::MeasureMatrix> m_target_covariances;
 };
 using DeepSortTrackerPtr = std::shared_ptr<DeepSortTracker>;
 } // namespace RedoxiTrack
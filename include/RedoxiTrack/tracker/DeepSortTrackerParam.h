@@ -7,6 +7,7 @@
 #include "RedoxiTrack/RedoxiTrackConfig.h"
 #include "RedoxiTrack/tracker/OpticalTrackerParam.h"
 #include "RedoxiTrack/tracker/TrackerParam.h"
+#include "RedoxiTrack/utils/FeatureGallery.h"
 
 namespace RedoxiTrack
 {
@@ -44,6 +45,14 @@ class REDOXI_TRACK_API DeepSortTrackerParam : public TrackerParam
     // float m_gating_threshold = 6.325 * 1e-3 * (1080 + 1920) / 2;
 
     float m_alpha_smooth_features = 0.9;
+    // file written by FeatureProjection::save() (e.g. by redoxi_fit_projection), empty to disable. the features of
+    // the detections are projected by it when they enter the tracker, everything after works on the projected ones
+    std::string m_feature_projection_file;
+    // besides the smoothed feature, keep the last m_gallery_size features of each track (0 to disable) and match
+    // by their min or mean distance. memory is bounded by m_gallery_size x feature dim x m_gallery_max_tracks
+    int m_gallery_size = 0;
+    int m_gallery_max_tracks = 256;
+    FeatureGallery::QueryMode m_gallery_query_mode = FeatureGallery::QueryMode::Min;
     float m_gating_dist_lambda = 0.98;
     float m_duplicate_iou_dist = 0.15;
     bool m_use_optical_before_track = true;
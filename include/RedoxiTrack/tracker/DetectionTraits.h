@@ -6,6 +6,7 @@
 
 #include "RedoxiTrack/RedoxiTrackConfig.h"
 #include "RedoxiTrack/detection/Detection.h"
+#include "RedoxiTrack/utils/CostMatrix.h"
 #include "RedoxiTrack/utils/FeatureTraits.h"
 
 namespace RedoxiTrack
@@ -25,6 +26,32 @@ class REDOXI_TRACK_API DetectionTraits
      * @return
      */
     virtual double compute_detection_distance(const Detection *a, const Detection *b) = 0;
+
+    /**
+     * output(i, j) = distance of a[i] to b[j], as given by compute_detection_distance(b[j], a[i]).
+     * the trackers compare their detections (a) with their targets (b) through this function, so a comparator
+     * gets (target, detection) as the trackers always passed them.
+     * the default calls compute_detection_distance() for every pair, override it to compute all pairs as a batch
+     * @param a
+     * @param size_a
+     * @param b
+     * @param size_b
+     * @param output resized to size_a x size_b
+     */
+    virtual void compute_distance_matrix(const Detection *const *a, size_t size_a, const Detection *const *b,
+                                         size_t size_b, CostMatrix &output);
+
+    /**
+     * same as above but only the pairs listed in candidates are computed, the other elements are unspecified
+     * @param a
+     * @param size_a
+     * @param b
+     * @param size_b
+     * @param candidates
+     * @param output resized to size_a x size_b
+     */
+    virtual void compute_distance_matrix(const Detection *const *a, size_t size_a, const Detection *const *b,
+                                         size_t size_b, const CandidatePairs &candidates, CostMatrix &output);
 };
 
 class REDOXI_TRACK_API FeatureBasedDetTraits : public DetectionTraits
@@ -42,7 +69,22 @@ class REDOXI_TRACK_API FeatureBasedDetTraits : public DetectionTraits
      * @return
      */
     virtual double compute_detection_distance(const Detection *a, const Detection *b) override;
+
+    /**
+     * pack the features of a and b and compare them with one call to FeatureTraits::compute_distance_matrix()
+     */
+    virtual void compute_distance_matrix(const Detection *const *a, size_t size_a, const Detection *const *b,
+                                         size_t size_b, CostMatrix &output) override;
+    virtual void compute_distance_matrix(const Detection *const *a, size_t size_a, const Detection *const *b,
+                                         size_t size_b, const CandidatePairs &candidates,
+                                         CostMatrix &output) override;
+
     virtual FeatureTraitsPtr get_feature_traits() const = 0;
+
+  protected:
+    // packed features of the last batch, reused across calls
+    FeatureArray m_features_a;
+    FeatureArray m_features_b;
 };
 using DetectionTraitsPtr = std::shared_ptr<DetectionTraits>;
 } // namespace RedoxiTrack
@@ -9,6 +9,8 @@
 #include "RedoxiTrack/tracker/DeepSortMotionPrediction.h"
 #include "RedoxiTrack/tracker/MotionPredictionByKalman.h"
 #include "RedoxiTrack/tracker/TrackerBase.h"
+#include "RedoxiTrack/utils/BoxArray.h"
+#include "RedoxiTrack/utils/CostMatrix.h"
 
 
 namespace RedoxiTrack
@@ -92,6 +94,13 @@ class REDOXI_TRACK_API KalmanTracker : public TrackerBase
      */
     void update_kalman(TrackTargetPtr &target, const BBOX &bbox);
 
+    /**
+     * update many targets' kalmanFilter's state in one batch, same as calling update_kalman() on each of them
+     * @param targets
+     * @param bboxes
+     */
+    void update_kalman(const std::vector<TrackTargetPtr> &targets, const std::vector<BBOX> &bboxes);
+
 
     MotionPredictionByKalmanPtr get_motion_prediction() const
     {
@@ -109,6 +118,15 @@ class REDOXI_TRACK_API KalmanTracker : public TrackerBase
      * @param notify_event_handler
      */
     void _motion_predict(int delta_frame_number, TrackTargetPtr &target, bool notify_event_handler = false);
+
+    /**
+     * motion predict all targets with one batched kalmanFilter predict, events are sent per target as above
+     * @param delta_frame_number
+     * @param targets
+     * @param notify_event_handler
+     */
+    void _motion_predict(int delta_frame_number, const std::vector<TrackTargetPtr> &targets,
+                         bool notify_event_handler = false);
     /**
      * target kalmanFilter predict
      * @param target
@@ -119,6 +137,17 @@ class REDOXI_TRACK_API KalmanTracker : public TrackerBase
 
   private:
     MotionPredictionByKalmanPtr m_motion_predict;
+
+    // iou cost matrix and box arrays, reused across frames
+    CostMatrix m_cost_matrix;
+    BoxArray m_source_boxes;
+    BoxArray m_target_boxes;
+
+    // batched predict and update arguments, reused across frames
+    std::vector<TrackTargetPtr> m_batch_targets;
+    std::vector<KalmanFilter *> m_batch_filters;
+    std::vector<bool> m_batch_flags;
+    std::vector<BBOX> m_batch_bboxes;
 };
 using KalmanTrackerPtr = std::shared_ptr<KalmanTracker>;
 } // namespace RedoxiTrack
@@ -4,8 +4,8 @@
 
 #pragma once
 #include "RedoxiTrack/RedoxiTrackConfig.h"
-// #include "opencv2/highgui/highgui.hpp"
-#include "opencv2/video/tracking.hpp"
+#include "RedoxiTrack/utils/KalmanBatch.h"
+#include "RedoxiTrack/utils/KalmanFilter.h"
 
 namespace RedoxiTrack
 {
@@ -24,7 +24,7 @@ class REDOXI_TRACK_API MotionPredictionByKalman
      * @param kf
      * @param bbox
      */
-    virtual void init(cv::KalmanFilter &kf, const BBOX &bbox) = 0;
+    virtual void init(KalmanFilter &kf, const BBOX &bbox) = 0;
 
     /**
      * kalmanFilter predict, x_t = A*x_{t-1}
@@ -33,21 +33,21 @@ class REDOXI_TRACK_API MotionPredictionByKalman
      * @param delta_frame_number
      * @param flag
      */
-    virtual void predict(cv::KalmanFilter &kf, BBOX &output_bbox, int delta_frame_number, const bool flag = false) = 0;
+    virtual void predict(KalmanFilter &kf, BBOX &output_bbox, int delta_frame_number, const bool flag = false) = 0;
 
     /**
      * update kalmanFilter, ^x_t = Ax_{t-1} + k(z_t - CAx_{t-1})
      * @param kf
      * @param bbox
      */
-    virtual void update(cv::KalmanFilter &kf, const BBOX &bbox) = 0;
+    virtual void update(KalmanFilter &kf, const BBOX &bbox) = 0;
 
     /**
-     * get updated bbox from kalmanFilter's statePost
+     * get updated bbox from kalmanFilter's state_post
      * @param kf
      * @param output_bbox
      */
-    virtual void get_bbox_state(cv::KalmanFilter &kf, BBOX &output_bbox) = 0;
+    virtual void get_bbox_state(KalmanFilter &kf, BBOX &output_bbox) = 0;
 
     /**
      * get kalmanFilter's measurement mean and covariance, c*x_t and cP_tc'+measurementNoiseCov
@@ -55,8 +55,26 @@ class REDOXI_TRACK_API MotionPredictionByKalman
      * @param output_mean
      * @param output_covariance
      */
-    virtual void project_state2measurement(cv::KalmanFilter &kf, cv::Mat &output_mean,
-                                           cv::Mat &output_covariance) const = 0;
+    virtual void project_state2measurement(KalmanFilter &kf, KalmanFilter::MeasureVector &output_mean,
+                                           KalmanFilter::MeasureMatrix &output_covariance) const = 0;
+
+    /**
+     * predict many kalmanFilters, same as calling predict() on each of them.
+     * constant velocity models run all filters through one KalmanBatch pass
+     * @param kfs
+     * @param flags flags[i] is the flag of predict() for kfs[i]
+     * @param output_bboxes
+     * @param delta_frame_number
+     */
+    virtual void predict(const std::vector<KalmanFilter *> &kfs, const std::vector<bool> &flags,
+                         std::vector<BBOX> &output_bboxes, int delta_frame_number);
+
+    /**
+     * update many kalmanFilters, same as calling update() on each of them
+     * @param kfs
+     * @param bboxes bboxes[i] is the measurement of kfs[i]
+     */
+    virtual void update(const std::vector<KalmanFilter *> &kfs, const std::vector<BBOX> &bboxes);
 
     virtual MotionPredictionByKalmanPtr clone() const = 0;
     virtual void copy_to(MotionPredictionByKalman &to) const
@@ -65,9 +83,44 @@ class REDOXI_TRACK_API MotionPredictionByKalman
         to.m_measureNum = m_measureNum;
     };
 
+  protected:
+    /**
+     * whether the model uses A = [I dt*I; 0 I], H = [I 0] and diagonal Q and R, see KalmanBatch.
+     * such a model implements _prepare_predict() and _prepare_update()
+     */
+    virtual bool _is_constant_velocity() const
+    {
+        return false;
+    }
+
+    /**
+     * set everything predict() sets on the filter before KalmanFilter::predict()
+     */
+    virtual void _prepare_predict(KalmanFilter &kf, int delta_frame_number, bool flag)
+    {
+    }
+
+    /**
+     * set everything update() sets on the filter before KalmanFilter::correct(), and the measurement of bbox
+     */
+    virtual void _prepare_update(KalmanFilter &kf, const BBOX &bbox, KalmanFilter::MeasureVector &output_measurement)
+    {
+    }
+
+    /**
+     * convert a state to the bbox it describes
+     */
+    virtual void _state2bbox(const KalmanFilter::StateVector &state, BBOX &output_bbox) const
+    {
+    }
+
   protected:
     int m_stateNum;
     int m_measureNum;
+
+    // scratch of the batched predict() and update()
+    KalmanBatch m_batch;
+    std::vector<KalmanFilter::MeasureVector> m_batch_measurements;
 };
 
 } // namespace RedoxiTrack
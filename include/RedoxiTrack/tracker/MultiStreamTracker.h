@@ -0,0 +1,168 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+#include "RedoxiTrack/tracker/TrackerBase.h"
+#include "RedoxiTrack/utils/WorkStealingPool.h"
+#include <chrono>
+#include <deque>
+#include <exception>
+
+namespace RedoxiTrack
+{
+
+/**
+ * frame timing of one stream of MultiStreamTracker, in seconds
+ */
+struct REDOXI_TRACK_API StreamLatency {
+    size_t num_frames = 0;
+    // from submit() to the end of the frame's begin_track() / track(), including the wait in the queue.
+    // the frame callback is not included
+    double last_latency = 0;
+    double sum_latency = 0;
+    double max_latency = 0;
+    // within begin_track() / track() only
+    double sum_track_time = 0;
+    // submitted and not yet tracked
+    size_t num_pending = 0;
+
+    double get_mean_latency() const
+    {
+        return num_frames > 0 ? sum_latency / num_frames : 0;
+    }
+    double get_mean_track_time() const
+    {
+        return num_frames > 0 ? sum_track_time / num_frames : 0;
+    }
+};
+
+/**
+ * runs many independent trackers, one per video stream, on a fixed WorkStealingPool instead of one thread
+ * per stream. frames are submitted with their stream id and tracked in submission order within each stream,
+ * frames of different streams run in parallel. at most one frame of a stream is queued in the pool at a time,
+ * so a busy stream can not hold back the others.
+ * the trackers keep their own targets, so no other synchronization is needed as long as the streams do not
+ * share detections or helper objects, see the thread safety notes of TrackerBase
+ */
+class REDOXI_TRACK_API MultiStreamTracker
+{
+  public:
+    /**
+     * called on a worker thread after each frame of a stream, in the frame order of the stream.
+     * the tracker must only be read here, e.g. by get_all_open_targets()
+     */
+    using FrameCallback = std::function<void(int stream_id, int frame_number, TrackerBase &tracker)>;
+
+    MultiStreamTracker(){};
+    virtual ~MultiStreamTracker();
+
+    MultiStreamTracker(const MultiStreamTracker &) = delete;
+    MultiStreamTracker &operator=(const MultiStreamTracker &) = delete;
+
+    /**
+     * start the worker threads
+     * @param num_threads <= 0 to use one thread per hardware thread
+     */
+    virtual void init(int num_threads);
+
+    /**
+     * add a stream, may be called while other streams are running
+     * @param tracker an initialized tracker, owned by the stream from now on
+     * @return the stream id
+     */
+    virtual int add_stream(const TrackerBasePtr &tracker);
+
+    int get_num_streams() const;
+
+    /**
+     * get the tracker of a stream, it must not be used while frames of the stream are pending, see wait()
+     * @param stream_id
+     * @return
+     */
+    TrackerBasePtr get_tracker(int stream_id) const;
+
+    /**
+     * set the callback, before the first submit()
+     * @param callback
+     */
+    void set_frame_callback(const FrameCallback &callback)
+    {
+        m_frame_callback = callback;
+    }
+
+    /**
+     * queue a frame of a stream and return, the first frame of a stream (or the first after submit_finish())
+     * goes to begin_track(), the others to track().
+     * img is not copied, its pixels must not be overwritten until the frame is tracked
+     * @param stream_id
+     * @param img
+     * @param detections
+     * @param frame_number
+     */
+    virtual void submit(int stream_id, const cv::Mat &img, const std::vector<DetectionPtr> &detections,
+                        int frame_number);
+
+    /**
+     * queue finish_track() of a stream after its pending frames
+     * @param stream_id
+     */
+    virtual void submit_finish(int stream_id);
+
+    /**
+     * block until the pending frames of a stream are tracked. if one of them threw, the later frames
+     * of the stream were skipped and the exception is rethrown here, once
+     * @param stream_id
+     */
+    virtual void wait(int stream_id);
+
+    /**
+     * wait() for every stream, rethrows the first exception found
+     */
+    virtual void wait_all();
+
+    StreamLatency get_stream_latency(int stream_id) const;
+    void reset_stream_latency(int stream_id);
+
+  protected:
+    using Clock = std::chrono::steady_clock;
+
+    struct Frame {
+        cv::Mat img;
+        std::vector<DetectionPtr> detections;
+        int frame_number = 0;
+        bool finish = false;
+        Clock::time_point submit_time;
+    };
+
+    struct Stream {
+        int id = 0;
+        TrackerBasePtr tracker;
+        // begin_track() was called and finish_track() not yet, only touched by the task running the stream
+        bool started = false;
+
+        mutable std::mutex mutex;
+        std::condition_variable idle;
+        std::deque<Frame> frames;
+        // a task of this stream is queued or running in the pool
+        bool scheduled = false;
+        std::exception_ptr error;
+        StreamLatency latency;
+    };
+
+    Stream *_get_stream(int stream_id) const;
+
+    void _enqueue(Stream *stream, Frame &&frame);
+
+    // track the oldest frame of the stream, then queue the stream again if more are pending
+    void _run_stream(Stream *stream);
+
+  protected:
+    WorkStealingPool m_pool;
+    FrameCallback m_frame_callback;
+
+    // streams are never removed, so their pointers stay valid
+    mutable std::mutex m_streams_mutex;
+    std::vector<std::unique_ptr<Stream>> m_streams;
+};
+using MultiStreamTrackerPtr = std::shared_ptr<MultiStreamTracker>;
+
+} // namespace RedoxiTrack
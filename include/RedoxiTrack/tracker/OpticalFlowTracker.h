@@ -7,6 +7,8 @@
 #include "RedoxiTrack/tracker/TrackerParam.h"
 
 // #include "NNIEOpticalFlow.h"
+#include "RedoxiTrack/utils/BoxArray.h"
+#include "RedoxiTrack/utils/CostMatrix.h"
 #include "RedoxiTrack/utils/utility_functions.h"
 
 namespace RedoxiTrack
@@ -73,6 +75,13 @@ class REDOXI_TRACK_API OpticalFlowTracker : public TrackerBase
     void
         track(const cv::Mat &img, int frame_number) override;
 
+    /**
+     * start the optical flow of the open targets to img in the background, see TrackerBase::submit_frame()
+     * @param img
+     * @param frame_number
+     */
+    void submit_frame(const cv::Mat &img, int frame_number) override;
+
     const std::map<int, TrackTargetPtr> &get_all_open_targets() const override;
 
     TrackTargetPtr get_open_target(int path_id) const override;
@@ -110,7 +119,45 @@ class REDOXI_TRACK_API OpticalFlowTracker : public TrackerBase
     void _motion_predict(const cv::Mat &img, int frame_number, const std::map<int, TrackTargetPtr> &id2target);
     void _delete_target(std::map<int, TrackTargetPtr> &id2target, const int id);
 
+    // the keypoints of each box, m_pts_per_width x m_pts_per_height per box
+    void _generate_keypoints(const std::vector<BBOX> &bboxes, std::vector<POINT> &output) const;
+
+    /**
+     * join the flow of submit_frame(), usable if it was started for this frame and image and every target
+     * in ids is still at the box it had then
+     * @param img
+     * @param frame_number
+     * @param ids ascending
+     * @param bboxes the current box of each id
+     * @param output_index the index of each id in m_pending_flow
+     * @return false if there is no usable flow
+     */
+    bool _join_pending_flow(const cv::Mat &img, int frame_number, const std::vector<int> &ids,
+                            const std::vector<BBOX> &bboxes, std::vector<int> &output_index);
+
+    // drop the flow of submit_frame(), before the previous image changes
+    void _reset_pending_flow();
+
     OpticalFlowMotionPredictionPtr m_motion_predict;
+
+    // iou cost matrix and box arrays, reused across frames
+    CostMatrix m_cost_matrix;
+    BoxArray m_source_boxes;
+    BoxArray m_target_boxes;
+
+    // the optical flow of submit_frame(), also the keypoint buffers of the synchronous flow
+    struct PendingFlow {
+        int frame_number = INIT_TRACKING_FRAME;
+        cv::Mat img;
+        // ascending, with the box each target had at submit_frame()
+        std::vector<int> ids;
+        std::vector<BBOX> bboxes;
+        std::vector<POINT> points;
+        OpticalFlowMotionPrediction::Result result;
+    };
+    PendingFlow m_pending_flow;
+    // after m_pending_flow, so that it is joined before the flow goes away
+    AsyncTask m_flow_task;
 };
 using OpticalFlowTrackerPtr = std::shared_ptr<OpticalFlowTracker>;
 
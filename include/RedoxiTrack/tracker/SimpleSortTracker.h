@@ -10,6 +10,8 @@
 #include "RedoxiTrack/tracker/KalmanTracker.h"
 #include "RedoxiTrack/tracker/TrackerBase.h"
 #include "RedoxiTrack/tracker/TrackingEventHandler.h"
+#include "RedoxiTrack/utils/BoxArray.h"
+#include "RedoxiTrack/utils/CostMatrix.h"
 
 namespace RedoxiTrack
 {
@@ -24,6 +26,16 @@ class REDOXI_TRACK_API SimpleSortTracker : public TrackerBase
         DefaultDetectionTraits(SimpleSortTracker *p);
         FeatureTraitsPtr get_feature_traits() const override;
 
+        // b must be targets of the tracker, see
+        // SimpleSortTracker::_compute_feature_distance()
+        void compute_distance_matrix(const Detection *const *a, size_t size_a,
+                                     const Detection *const *b, size_t size_b,
+                                     CostMatrix &output) override;
+        void compute_distance_matrix(const Detection *const *a, size_t size_a,
+                                     const Detection *const *b, size_t size_b,
+                                     const CandidatePairs &candidates,
+                                     CostMatrix &output) override;
+
       public:
       protected:
         SimpleSortTracker *m_tracker = nullptr;
@@ -123,7 +135,34 @@ class REDOXI_TRACK_API SimpleSortTracker : public TrackerBase
     void _update_features(SimpleSortTrackTargetPtr &target,
                           const fVECTOR &features);
 
-    void _bbox2xyah(const BBOX &bbox, cv::Mat &output);
+    void _bbox2xyah(const BBOX &bbox, KalmanFilter::MeasureVector &output);
+
+    /**
+     * distance matrix of the default detection comparision. the features of b
+     * are used as they are, the tracker keeps the features of its targets
+     * normalized
+     * @param a
+     * @param size_a
+     * @param b
+     * @param size_b
+     * @param candidates can be null
+     * @param output
+     */
+    void _compute_feature_distance(const Detection *const *a, size_t size_a,
+                                   const Detection *const *b, size_t size_b,
+                                   const CandidatePairs *candidates,
+                                   CostMatrix &output);
+
+    /**
+     * squared mahalanobis distance of every source to the kalman prediction of every target,
+     * output[i][j] is the distance of sources[i] to targets[j]
+     * @param sources
+     * @param targets
+     * @param output
+     */
+    void _compute_gating_distance(const std::vector<DetectionPtr> &sources,
+                                  const std::vector<TrackTargetPtr> &targets,
+                                  CostMatrix &output);
 
     void
         _match_maha_distance(const std::vector<DetectionPtr> &sources,
@@ -150,6 +189,22 @@ class REDOXI_TRACK_API SimpleSortTracker : public TrackerBase
 
     DetectionTraitsPtr m_detection_comparision;
     FeatureTraitsPtr m_feature_traits;
+
+    // cost matrix and box arrays reused across frames by the matching functions
+    CostMatrix m_cost_matrix;
+    BoxArray m_source_boxes;
+    BoxArray m_target_boxes;
+
+    // appearance distances, reused across frames
+    CostMatrix m_appearance_matrix;
+    // pairs inside the gate, the only ones compared by appearance
+    CandidatePairs m_gated_pairs;
+
+    // gating distances and their inputs, reused across frames
+    CostMatrix m_gating_matrix;
+    std::vector<KalmanFilter::MeasureVector> m_source_measurements;
+    std::vector<KalmanFilter::MeasureVector> m_target_means;
+    std::vector<KalmanFilter::MeasureMatrix> m_target_covariances;
 };
 using SimpleSortTrackerPtr = std::shared_ptr<SimpleSortTracker>;
 } // namespace RedoxiTrack
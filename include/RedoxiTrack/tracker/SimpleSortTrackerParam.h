@@ -38,6 +38,9 @@ class REDOXI_TRACK_API SimpleSortTrackerParam : public TrackerParam
     // float m_gating_threshold = 6.325 * 1e-3 * (1080 + 1920) / 2;
 
     float m_alpha_smooth_features = 0.9;
+    // file written by FeatureProjection::save() (e.g. by redoxi_fit_projection), empty to disable. the features of
+    // the detections are projected by it when they enter the tracker, everything after works on the projected ones
+    std::string m_feature_projection_file;
     float m_gating_dist_lambda = 0.98;
     float m_duplicate_iou_dist = 0.15;
     TrackerParam m_kalman_param;
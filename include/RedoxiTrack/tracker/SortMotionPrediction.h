@@ -11,22 +11,26 @@ namespace RedoxiTrack
 class REDOXI_TRACK_API SortMotionPrediction : public MotionPredictionByKalman
 {
   public:
-    void init(cv::KalmanFilter &kf, const BBOX &bbox) override;
+    // the batched predict() and update() of the base class
+    using MotionPredictionByKalman::predict;
+    using MotionPredictionByKalman::update;
 
-    void predict(cv::KalmanFilter &kf, BBOX &output_bbox, int delta_frame_number, const bool flag = false) override;
+    void init(KalmanFilter &kf, const BBOX &bbox) override;
 
-    void update(cv::KalmanFilter &kf, const BBOX &bbox) override;
+    void predict(KalmanFilter &kf, BBOX &output_bbox, int delta_frame_number, const bool flag = false) override;
 
-    void get_bbox_state(cv::KalmanFilter &kf, BBOX &output_bbox) override;
+    void update(KalmanFilter &kf, const BBOX &bbox) override;
 
-    void project_state2measurement(cv::KalmanFilter &kf, cv::Mat &output_mean,
-                                   cv::Mat &output_covariance) const override;
+    void get_bbox_state(KalmanFilter &kf, BBOX &output_bbox) override;
+
+    void project_state2measurement(KalmanFilter &kf, KalmanFilter::MeasureVector &output_mean,
+                                   KalmanFilter::MeasureMatrix &output_covariance) const override;
 
   protected:
     static void _get_rect_from_xysr(float cx, float cy, float s, float r, BBOX &output_bbox);
 
   protected:
-    cv::Mat m_update_measurement;
+    KalmanFilter::MeasureVector m_update_measurement = KalmanFilter::MeasureVector::Zero();
 };
 using SortMotionPredictionPtr = std::shared_ptr<SortMotionPrediction>;
 } // namespace RedoxiTrack
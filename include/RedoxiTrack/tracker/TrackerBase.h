@@ -5,11 +5,18 @@
 
 #include "RedoxiTrack/detection/Detection.h"
 #include "RedoxiTrack/detection/TrackTarget.h"
+#include "RedoxiTrack/tracker/DetectionTraits.h"
 #include "RedoxiTrack/tracker/TrackerParam.h"
 #include "RedoxiTrack/tracker/TrackingEventHandler.h"
+#include "RedoxiTrack/utils/FeatureGallery.h"
+#include "RedoxiTrack/utils/StageTimer.h"
+#include "RedoxiTrack/utils/TraceSink.h"
+#include "RedoxiTrack/utils/WorkStealingPool.h"
 
 namespace RedoxiTrack
 {
+class FeatureTraits;
+
 class REDOXI_TRACK_API TrackerTrackingState
 {
   public:
@@ -30,6 +37,17 @@ class REDOXI_TRACK_API TrackerTrackingState
 };
 using TrackerTrackingStatePtr = std::shared_ptr<TrackerTrackingState>;
 
+/**
+ * thread safety: a tracker is not thread safe, all calls on one instance must come from one thread at a time
+ * (MultiStreamTracker serializes them per stream). different instances may run on different threads at the
+ * same time, the library keeps no global state besides the atomic id counter of IDObject, as long as
+ * they do not share:
+ * - detections, the trackers modify them (features of low score detections are cleared, features are projected)
+ * - DetectionTraits, FeatureTraits set by set_feature_traits(), StageTimer or TraceSink objects, these keep
+ *   per-call scratch or results. a FeatureProjection or the WorkStealingPool of set_thread_pool() may be shared
+ * - event handlers, they are called on the thread of the tracker
+ * subclasses must keep this: per-frame scratch belongs in members, not in statics or globals
+ */
 class REDOXI_TRACK_API TrackerBase
 {
   public:
@@ -90,6 +108,18 @@ class REDOXI_TRACK_API TrackerBase
      */
     virtual void track(const cv::Mat &img, int frame_number) = 0;
 
+    /**
+     * start the work of the next frame that only needs its image, e.g. the optical flow of the targets, in the
+     * background while the detector still runs. the next track() with the same img and frame_number joins it,
+     * the pixels of img must not change until then. the work runs on the pool of set_thread_pool(), or on its
+     * own thread without one. calling track() without it is fine, trackers without such work ignore it
+     * @param img
+     * @param frame_number
+     */
+    virtual void submit_frame(const cv::Mat &img, int frame_number)
+    {
+    }
+
     /**
      * get all targets still being tracked
      * @return
@@ -153,6 +183,51 @@ class REDOXI_TRACK_API TrackerBase
         return m_id2target;
     }
 
+    /**
+     * attach a timer which accumulates the time spent in each stage of track(),
+     * set to nullptr to disable profiling (default)
+     * @param timer
+     */
+    void set_stage_timer(const StageTimerPtr &timer)
+    {
+        m_stage_timer = timer;
+    }
+
+    const StageTimerPtr &get_stage_timer() const
+    {
+        return m_stage_timer;
+    }
+
+    /**
+     * attach a sink which records tracking checkpoints, the sink must also be enabled at runtime.
+     * trackers only record when the library is built with REDOXI_TRACK_WITH_TRACE
+     * @param sink
+     */
+    void set_trace_sink(const TraceSinkPtr &sink)
+    {
+        m_trace_sink = sink;
+    }
+
+    const TraceSinkPtr &get_trace_sink() const
+    {
+        return m_trace_sink;
+    }
+
+    /**
+     * attach a pool which builds large cost matrices in parallel within a frame, see
+     * TrackerParam::m_parallel_min_pairs. nullptr to stay on the calling thread (default)
+     * @param pool a started pool, may be shared by several trackers
+     */
+    void set_thread_pool(const WorkStealingPoolPtr &pool)
+    {
+        m_thread_pool = pool;
+    }
+
+    const WorkStealingPoolPtr &get_thread_pool() const
+    {
+        return m_thread_pool;
+    }
+
   protected:
     /**
      * create a new tracking state
@@ -172,6 +247,91 @@ class REDOXI_TRACK_API TrackerBase
      */
     virtual void _tracking_state_recover(const TrackerTrackingState &state);
 
+    /**
+     * true if checkpoints should be recorded to m_trace_sink, always false when trace is compiled out
+     */
+    bool _is_tracing() const
+    {
+        return REDOXI_TRACK_WITH_TRACE && m_trace_sink && m_trace_sink->is_enabled();
+    }
+
+    /**
+     * project the features of the detections in place with the projection of traits, if it has one.
+     * all features of the input size are projected with one matrix product, the detections must be SingleDetection
+     * @param detections
+     * @param traits can be null
+     */
+    void _project_features(const std::vector<DetectionPtr> &detections, const FeatureTraits *traits);
+
+    /**
+     * store the packed form of the normalized features of the detections, if traits compares packed features.
+     * detections that already keep a packed feature of the precision of traits are left as they are,
+     * the others must be SingleDetection
+     * @param detections
+     * @param traits can be null
+     */
+    void _pack_features(const std::vector<DetectionPtr> &detections, const FeatureTraits *traits);
+
+    /**
+     * store the packed form of the feature of item, if traits compares packed features. called whenever the
+     * tracker sets the feature of a target, so that the distance matrices never pack it again
+     * @param item
+     * @param traits
+     * @param normalize false if the feature of item is already normalized
+     */
+    void _pack_feature(SingleDetection &item, const FeatureTraits &traits, bool normalize);
+
+    /**
+     * the packed feature item keeps for traits, or its normalized feature packed to a buffer of this object
+     * if it keeps none of the precision of traits. the result is valid until the next call
+     * @param item
+     * @param traits
+     * @return null if item has no feature or traits compares float features
+     */
+    const PackedFeatures *_get_packed_feature(const Detection &item, const FeatureTraits &traits);
+
+    /**
+     * appearance distance of sources to targets through comparison as one batch,
+     * output[i][j] is the distance of sources[i] to targets[j]
+     * @param comparison the detection comparision of the tracker
+     * @param sources
+     * @param targets
+     * @param candidates if not null, only these pairs are computed
+     * @param output
+     */
+    void _compute_appearance_distance(DetectionTraits &comparison, const std::vector<DetectionPtr> &sources,
+                                      const std::vector<TrackTargetPtr> &targets, const CandidatePairs *candidates,
+                                      CostMatrix &output);
+
+    /**
+     * feature distance of detections a to targets b, the default detection comparision of the trackers.
+     * a target is compared by its gallery if it has one, by its smoothed feature otherwise, which the tracker
+     * keeps normalized. the features of a are normalized by traits
+     * @param traits
+     * @param gallery null or without capacity to compare by the smoothed features only
+     * @param mode how a gallery is queried
+     * @param a
+     * @param size_a
+     * @param b targets of this tracker
+     * @param size_b
+     * @param candidates if not null, only these pairs are computed and the others are set to the max distance
+     * @param output
+     */
+    void _compute_target_feature_distance(const FeatureTraits &traits, FeatureGallery *gallery,
+                                          FeatureGallery::QueryMode mode, const Detection *const *a, size_t size_a,
+                                          const Detection *const *b, size_t size_b, const CandidatePairs *candidates,
+                                          CostMatrix &output);
+
+    /**
+     * run fn(begin, end) over the rows of a rows x cols matrix, in tiles on m_thread_pool when there is one and
+     * the matrix has at least TrackerParam::m_parallel_min_pairs elements, in one call on this thread otherwise.
+     * fn must only write its own rows and must not throw or record to m_trace_sink
+     * @param rows
+     * @param cols
+     * @param fn
+     */
+    void _parallel_rows(size_t rows, size_t cols, const std::function<void(size_t, size_t)> &fn) const;
+
     void _update_frame_number(int frame_number)
     {
         assert(m_frame_number <= frame_number);
@@ -209,6 +369,35 @@ class REDOXI_TRACK_API TrackerBase
     TrackerParamPtr m_param;
 
     std::set<TrackingEventHandlerPtr> m_event_handlers;
+
+    /**
+     * optional profiling timer, nullptr if not profiling
+     */
+    StageTimerPtr m_stage_timer;
+
+    /**
+     * optional checkpoint trace, nullptr if not tracing
+     */
+    TraceSinkPtr m_trace_sink;
+
+    /**
+     * optional pool for the cost matrices of large frames, nullptr to stay on the calling thread
+     */
+    WorkStealingPoolPtr m_thread_pool;
+
+    // features gathered by _project_features(), reused across frames
+    fMATRIX m_projection_input;
+    fMATRIX m_projection_output;
+    // feature and its packed form in _pack_feature() and _get_packed_feature(), reused across calls
+    fVECTOR m_pack_input;
+    PackedFeatures m_pack_output;
+    // detections compared by _compute_appearance_distance(), reused across frames
+    std::vector<const Detection *> m_source_ptrs;
+    std::vector<const Detection *> m_target_ptrs;
+    // packed features and gallery ids of _compute_target_feature_distance(), reused across frames
+    FeatureArray m_source_features;
+    FeatureArray m_target_features;
+    std::vector<int> m_gallery_ids;
 };
 
 using TrackerBasePtr = std::shared_ptr<TrackerBase>;
@@ -27,6 +27,20 @@ class REDOXI_TRACK_API TrackerParam
     int m_max_time_since_update = 30;
     float m_max_iou_distance = 0.5;
 
+    /**
+     * with a thread pool set by TrackerBase::set_thread_pool(), cost matrices of at least m_parallel_min_pairs
+     * elements are built by tiles of rows in parallel, smaller ones stay on the calling thread
+     */
+    int m_parallel_min_pairs = 65536;
+
+    /**
+     * DeepSORT and SORT solve their associations with hungarian_match_sparse(), one problem per connected
+     * component of the gated pairs, instead of one dense hungarian_match(). faster on wide scenes, but the
+     * dense solver couples the components through the costs above the gate, so the assignments can differ.
+     * BoT-SORT always splits, lapjv gives the same assignment either way
+     */
+    bool m_use_sparse_assignment = false;
+
     cv::Size m_preferred_image_size{1920, 1080};
 };
 using TrackerParamPtr = std::shared_ptr<TrackerParam>;
@@ -47,6 +47,15 @@ class REDOXI_TRACK_API TargetMotionPredict : public TrackingEventData
  * The TrackingEventHandler class provides virtual methods to handle various tracking events such as target
  * association, target creation, target closure, and target motion prediction. These methods can be overridden by derived
  * classes to implement custom event handling logic.
+ *
+ * Order of the events: KalmanTracker::track(img, detections, frame_number) corrects the filters of all matched
+ * targets in one batch, so it fires evt_target_association_before for every matched pair first, then corrects
+ * the filters, then fires evt_target_association_after for every pair in the same order. A before handler thus
+ * sees no target corrected yet, and an after handler sees all of them corrected. KalmanTracker ignores the
+ * results of the before handlers.
+ * KalmanTracker::track(img, frame_number) predicts all filters first, then fires evt_target_motion_predict_before
+ * and evt_target_motion_predict_after per target around setting its predicted bbox.
+ * The other trackers fire the before and after events of one pair together.
  */
 class REDOXI_TRACK_API TrackingEventHandler
 {
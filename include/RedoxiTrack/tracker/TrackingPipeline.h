@@ -0,0 +1,207 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+#include "RedoxiTrack/tracker/TrackerBase.h"
+#include "RedoxiTrack/utils/SpscRing.h"
+#include <chrono>
+#include <exception>
+#include <thread>
+
+namespace RedoxiTrack
+{
+
+/**
+ * one frame on its way through TrackingPipeline
+ */
+struct REDOXI_TRACK_API PipelineFrame {
+    // counted by the decode stage from 0, frames dropped later leave gaps
+    int frame_number = 0;
+    cv::Mat img;
+    // filled by the detect stage
+    std::vector<DetectionPtr> detections;
+    // copies of the open targets after track(), by path id, filled by the track stage
+    std::map<int, TrackTargetPtr> targets;
+};
+
+/**
+ * what a stage does when the queue to the next stage is full
+ */
+enum class PipelineQueuePolicy {
+    // wait until the next stage takes a frame, the slowest stage sets the pace and no frame is lost
+    Block = 0,
+    // drop the oldest queued frame, the stages before never wait and the latency stays bounded
+    DropOldest
+};
+
+class REDOXI_TRACK_API TrackingPipelineParam
+{
+  public:
+    // frames each queue between two stages holds, at least 2
+    int m_queue_capacity = 4;
+    // policy of the queues into the detect, track and sink stage
+    PipelineQueuePolicy m_detect_queue_policy = PipelineQueuePolicy::Block;
+    PipelineQueuePolicy m_track_queue_policy = PipelineQueuePolicy::Block;
+    PipelineQueuePolicy m_sink_queue_policy = PipelineQueuePolicy::Block;
+};
+
+/**
+ * counters of one stage of TrackingPipeline, times in seconds
+ */
+struct REDOXI_TRACK_API PipelineStageStats {
+    // frames the stage finished
+    size_t num_frames = 0;
+    // frames dropped from the queue into the stage, by PipelineQueuePolicy::DropOldest
+    size_t num_dropped = 0;
+    // frames waiting in the queue into the stage, now and at most
+    size_t queue_depth = 0;
+    size_t max_queue_depth = 0;
+    // within the stage function
+    double busy_time = 0;
+    // since start()
+    double elapsed_time = 0;
+
+    double get_throughput() const
+    {
+        return elapsed_time > 0 ? num_frames / elapsed_time : 0;
+    }
+    // fraction of the time the stage was working, the stage near 1 limits the throughput
+    double get_utilization() const
+    {
+        return elapsed_time > 0 ? busy_time / elapsed_time : 0;
+    }
+};
+
+/**
+ * runs decode, detect, track and sink of a video stream as a pipeline, each stage on its own thread
+ * with a bounded lock-free SpscRing to the next one, so the throughput is that of the slowest stage rather
+ * than the sum of all stages. frames keep their order, the tracker is only used by the track stage.
+ * the stages wait on their queues by spinning briefly, then sleeping in short steps
+ */
+class REDOXI_TRACK_API TrackingPipeline
+{
+  public:
+    enum Stage {
+        Decode = 0,
+        Detect,
+        Track,
+        Sink,
+        NumStages
+    };
+
+    /**
+     * get the next frame, false at the end of the stream. img must own its pixels, e.g. a new cv::Mat per call,
+     * the later stages still use the previous ones
+     */
+    using DecodeFunction = std::function<bool(cv::Mat &img)>;
+    // fill frame.detections from frame.img
+    using DetectFunction = std::function<void(PipelineFrame &frame)>;
+    using SinkFunction = std::function<void(PipelineFrame &frame)>;
+
+    TrackingPipeline(){};
+    virtual ~TrackingPipeline();
+
+    TrackingPipeline(const TrackingPipeline &) = delete;
+    TrackingPipeline &operator=(const TrackingPipeline &) = delete;
+
+    /**
+     * @param tracker an initialized tracker, begin_track() is called on the first frame and finish_track()
+     * after the last one
+     * @param param
+     */
+    virtual void init(const TrackerBasePtr &tracker, const TrackingPipelineParam &param);
+
+    /**
+     * start the stage threads, the pipeline must be stopped
+     * @param decode
+     * @param detect
+     * @param sink can be empty
+     */
+    virtual void start(const DecodeFunction &decode, const DetectFunction &detect, const SinkFunction &sink);
+
+    /**
+     * block until every frame of the stream went through the sink, then join the threads.
+     * if a stage threw, the others stop early and the exception is rethrown here
+     */
+    virtual void wait();
+
+    /**
+     * stop decoding, let the frames already decoded go through, then wait()
+     */
+    virtual void stop();
+
+    bool is_running() const
+    {
+        return m_running;
+    }
+
+    /**
+     * may be called from any thread while the pipeline runs, the counters are kept after wait()
+     * @param stage
+     * @return
+     */
+    PipelineStageStats get_stage_stats(Stage stage) const;
+
+  protected:
+    using Clock = std::chrono::steady_clock;
+    using Ring = SpscRing<PipelineFrame>;
+
+    struct StageCounters {
+        std::atomic<size_t> num_frames{0};
+        std::atomic<size_t> num_dropped{0};
+        std::atomic<size_t> max_queue_depth{0};
+        // nanoseconds
+        std::atomic<long long> busy_time{0};
+    };
+
+    void _decode_loop();
+    void _detect_loop();
+    void _track_loop();
+    void _sink_loop();
+
+    // run a stage loop, turn its exception into an abort of the pipeline
+    void _run_stage(void (TrackingPipeline::*loop)());
+
+    /**
+     * queue a frame for stage, following its policy
+     * @return false if the pipeline was aborted
+     */
+    bool _push(Stage stage, PipelineFrame &frame);
+
+    /**
+     * wait for the next frame of stage
+     * @return false once the previous stage is done and the queue is empty, or the pipeline was aborted
+     */
+    bool _pop(Stage stage, PipelineFrame &frame);
+
+    // the previous stage will not push to the queue of stage any more
+    void _close(Stage stage);
+
+    void _add_busy_time(Stage stage, Clock::time_point start);
+
+  protected:
+    TrackerBasePtr m_tracker;
+    TrackingPipelineParam m_param;
+
+    DecodeFunction m_decode;
+    DetectFunction m_detect;
+    SinkFunction m_sink;
+
+    // m_queues[stage] feeds stage, there is none into Decode
+    std::unique_ptr<Ring> m_queues[NumStages];
+    std::atomic<bool> m_closed[NumStages];
+    StageCounters m_counters[NumStages];
+
+    std::atomic<bool> m_stop_requested{false};
+    std::atomic<bool> m_aborted{false};
+    std::mutex m_error_mutex;
+    std::exception_ptr m_error;
+
+    std::atomic<bool> m_running{false};
+    // m_end_time is valid once m_running is false
+    Clock::time_point m_start_time;
+    Clock::time_point m_end_time;
+    std::vector<std::thread> m_threads;
+};
+using TrackingPipelinePtr = std::shared_ptr<TrackingPipeline>;
+
+} // namespace RedoxiTrack
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+
+namespace RedoxiTrack
+{
+
+/**
+ * corners of a list of bboxes stored as structure-of-arrays, the layout read by the batched iou kernels.
+ * x2, y2 are BBOX::br(), the +1 pixel convention of compute_iou() is applied by the kernels
+ */
+struct REDOXI_TRACK_API BoxArray {
+    std::vector<float> x1;
+    std::vector<float> y1;
+    std::vector<float> x2;
+    std::vector<float> y2;
+
+    size_t size() const
+    {
+        return x1.size();
+    }
+
+    void clear()
+    {
+        x1.clear();
+        y1.clear();
+        x2.clear();
+        y2.clear();
+    }
+
+    void push_back(const BBOX &bbox)
+    {
+        x1.push_back(bbox.x);
+        y1.push_back(bbox.y);
+        x2.push_back(bbox.x + bbox.width);
+        y2.push_back(bbox.y + bbox.height);
+    }
+
+    void assign(const std::vector<BBOX> &bboxes)
+    {
+        clear();
+        for (auto &b : bboxes)
+            push_back(b);
+    }
+
+    /**
+     * fill from detections or track targets, get_bbox() is called once per item
+     * @param items
+     */
+    template <typename T>
+    void assign(const std::vector<std::shared_ptr<T>> &items)
+    {
+        clear();
+        for (auto &p : items)
+            push_back(p->get_bbox());
+    }
+};
+
+} // namespace RedoxiTrack
@@ -14,5 +14,19 @@ class REDOXI_TRACK_API CosineFeature : public FeatureTraits
     virtual void linear_combine(fVECTOR *output, const fVECTOR &fa, const fVECTOR &fb, double wa = 1, double wb = 1) const override;
     virtual double max_distance() const override;
     virtual double min_distance() const override;
+
+    /**
+     * scale to unit length, the distance of two unit features is (1 - a.b) / 2
+     * @param feature
+     */
+    virtual void normalize(Eigen::Ref<fVECTOR> feature) const override;
+
+    /**
+     * all distances from one matrix product, output = (1 - a * b') / 2.
+     * the rows must be unit length, see normalize()
+     */
+    virtual void compute_distance_matrix(const FeatureArray &a, const FeatureArray &b, CostMatrix &output) const override;
+    virtual void compute_distance_matrix(const FeatureArray &a, const FeatureArray &b, const CandidatePairs &candidates,
+                                         CostMatrix &output) const override;
 };
 } // namespace RedoxiTrack
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+
+namespace RedoxiTrack
+{
+
+/**
+ * dense row-major float matrix used for association costs, row i holds the costs of source i to all targets.
+ * every row starts on an Alignment boundary, so element (i, j) is at data()[i * stride() + j].
+ * the storage is kept across resize(), a tracker can hold one as a member and refill it on every frame.
+ */
+class REDOXI_TRACK_API CostMatrix
+{
+  public:
+    // alignment of each row in bytes
+    static const size_t Alignment = 64;
+
+  public:
+    CostMatrix() = default;
+    CostMatrix(int rows, int cols, float value = 0);
+    CostMatrix(const CostMatrix &other);
+    CostMatrix(CostMatrix &&other) noexcept;
+    CostMatrix &operator=(const CostMatrix &other);
+    CostMatrix &operator=(CostMatrix &&other) noexcept;
+    ~CostMatrix();
+
+    /**
+     * change the shape, reusing the storage when it is large enough.
+     * the content is undefined afterwards
+     * @param rows
+     * @param cols
+     */
+    void resize(int rows, int cols);
+
+    /**
+     * change the shape and set all elements to value
+     * @param rows
+     * @param cols
+     * @param value
+     */
+    void assign(int rows, int cols, float value);
+
+    void fill(float value);
+
+    int rows() const
+    {
+        return m_rows;
+    }
+    int cols() const
+    {
+        return m_cols;
+    }
+    bool empty() const
+    {
+        return m_rows == 0 || m_cols == 0;
+    }
+
+    /**
+     * number of floats between the starts of two consecutive rows
+     * @return
+     */
+    size_t stride() const
+    {
+        return m_stride;
+    }
+
+    float *data()
+    {
+        return m_data;
+    }
+    const float *data() const
+    {
+        return m_data;
+    }
+
+    float *row(int i)
+    {
+        return m_data + i * m_stride;
+    }
+    const float *row(int i) const
+    {
+        return m_data + i * m_stride;
+    }
+
+    float &operator()(int i, int j)
+    {
+        return m_data[i * m_stride + j];
+    }
+    float operator()(int i, int j) const
+    {
+        return m_data[i * m_stride + j];
+    }
+
+    void swap(CostMatrix &other) noexcept;
+
+  protected:
+    float *m_data = nullptr;
+    size_t m_capacity = 0; // allocated floats
+    size_t m_stride = 0;
+    int m_rows = 0;
+    int m_cols = 0;
+};
+
+} // namespace RedoxiTrack
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+#include "RedoxiTrack/utils/CostMatrix.h"
+#include "RedoxiTrack/utils/FeatureTraits.h"
+#include "RedoxiTrack/utils/SpatialGrid.h"
+
+#include <unordered_map>
+
+namespace RedoxiTrack
+{
+
+/**
+ * the last few features of each track, kept in ring buffers carved from one slab.
+ * the slab holds capacity x max tracks features, so memory does not grow with the length of a sequence.
+ * when every slot is taken, the gallery of the track updated least recently is dropped for the new one.
+ * a gallery keeps either float features or packed ones (see FeatureTraits::pack_feature()), not both
+ */
+class REDOXI_TRACK_API FeatureGallery
+{
+  public:
+    // how the distances of a feature to the entries of a gallery are reduced to one
+    enum class QueryMode {
+        Min,
+        Mean
+    };
+
+  public:
+    /**
+     * drop all galleries and set the size of the slab, which is allocated when the first feature is added
+     * @param capacity features kept per track, 0 disables the gallery
+     * @param max_tracks number of tracks that can have a gallery at the same time
+     */
+    void init(int capacity, int max_tracks);
+
+    int get_capacity() const
+    {
+        return m_capacity;
+    }
+
+    int get_max_tracks() const
+    {
+        return m_max_tracks;
+    }
+
+    // drop all galleries, the slab is kept
+    void clear();
+
+    /**
+     * append a feature to the gallery of a track, overwriting its oldest feature when the gallery is full.
+     * the feature must be in the form given by FeatureTraits::normalize()
+     * @param path_id
+     * @param feature
+     */
+    void add(int path_id, const fVECTOR &feature);
+
+    /**
+     * same as above for a feature already packed, one row in the form given by FeatureTraits::pack_feature()
+     * @param path_id
+     * @param feature
+     */
+    void add(int path_id, const PackedFeatures &feature);
+
+    void remove(int path_id);
+
+    bool contains(int path_id) const
+    {
+        return m_path2slot.count(path_id) != 0;
+    }
+
+    // number of features in the gallery of path_id
+    int get_size(int path_id) const;
+
+    /**
+     * output(i, j) = min or mean distance of a's row i to the features in the gallery of path_ids[j].
+     * all galleries are compared with a in one call to traits.compute_distance_matrix().
+     * columns of ids without gallery are left unchanged, and with candidates only the listed pairs are written
+     * @param a
+     * @param path_ids
+     * @param traits
+     * @param mode
+     * @param candidates can be null
+     * @param output must already be a.size() x path_ids.size()
+     */
+    void compute_distance_matrix(const FeatureArray &a, const std::vector<int> &path_ids, const FeatureTraits &traits,
+                                 QueryMode mode, const CandidatePairs *candidates, CostMatrix &output);
+
+  protected:
+    struct Slot {
+        int path_id = -1;
+        // number of features and next row to write, in 0 .. capacity - 1
+        int count = 0;
+        int head = 0;
+        uint64_t last_update = 0;
+    };
+
+    // the row of path_id's gallery the next feature is written to, the gallery is created if needed
+    int _next_row(int path_id);
+    int _acquire_slot(int path_id);
+
+  protected:
+    int m_capacity = 0;
+    int m_max_tracks = 0;
+
+    // row slot * m_capacity + k is the k-th feature of a slot
+    fMATRIX m_slab;
+    // the same rows for packed features
+    PackedFeatures m_packed_slab;
+    std::vector<Slot> m_slots;
+    std::vector<int> m_free_slots;
+    std::unordered_map<int, int> m_path2slot;
+    uint64_t m_clock = 0;
+
+    // features of the queried galleries gathered in the order of path_ids, reused across queries.
+    // the features of path_ids[j] are rows m_offsets[j] .. m_offsets[j + 1] - 1
+    FeatureArray m_gathered;
+    std::vector<int> m_offsets;
+    CandidatePairs m_gathered_candidates;
+    CostMatrix m_distances;
+};
+
+} // namespace RedoxiTrack
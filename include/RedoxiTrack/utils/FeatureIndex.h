@@ -0,0 +1,110 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+
+#include <random>
+#include <unordered_map>
+
+namespace RedoxiTrack
+{
+
+/**
+ * approximate nearest neighbour search over unit features, by the cosine distance (1 - a.b) / 2 of CosineFeature.
+ * the items are linked in a hierarchical navigable small world graph (HNSW), so a search visits about
+ * log(size) x max_neighbors items instead of all of them.
+ * items are added and removed one at a time. a removed item stays in the graph as a waypoint until
+ * removed items outnumber the others, then the graph is rebuilt from the remaining items.
+ * searches share a visited list, so an index must not be searched from several threads at once
+ */
+class REDOXI_TRACK_API FeatureIndex
+{
+  public:
+    /**
+     * @param max_neighbors links kept per item on the upper layers, twice as many on the bottom layer
+     * @param ef_construction candidates considered when an item is linked, larger builds a better graph
+     */
+    explicit FeatureIndex(int max_neighbors = 16, int ef_construction = 100);
+
+    // remove all items
+    void clear();
+
+    size_t size() const
+    {
+        return m_key2node.size();
+    }
+
+    bool contains(int key) const
+    {
+        return m_key2node.count(key) != 0;
+    }
+
+    /**
+     * add an item, replacing the item with the same key if there is one
+     * @param key
+     * @param feature unit length, all items must have the same size
+     */
+    void add(int key, const Eigen::Ref<const fVECTOR> &feature);
+
+    void remove(int key);
+
+    /**
+     * find the k nearest items of a query
+     * @param query unit length
+     * @param k
+     * @param ef candidates kept during the search, larger is more accurate and slower. the index is searched
+     * exhaustively while it holds no more than ef items
+     * @param output (distance, key) of at most k items, nearest first
+     */
+    void search(const Eigen::Ref<const fVECTOR> &query, int k, int ef, std::vector<std::pair<float, int>> &output) const;
+
+  protected:
+    struct Node {
+        int key = 0;
+        bool removed = false;
+        // links[l] are the neighbours on layer l, the node is on layers 0 .. links.size() - 1
+        std::vector<std::vector<int>> links;
+    };
+    using Candidate = std::pair<float, int>;
+
+    const float *_feature(int node) const
+    {
+        return m_features.data() + (size_t)node * m_dim;
+    }
+
+    // 1 - a.b, ordered like the cosine distance
+    float _distance(const float *a, const float *b) const;
+
+    int _max_links(int level) const
+    {
+        return level == 0 ? 2 * m_max_neighbors : m_max_neighbors;
+    }
+
+    // the ef nodes nearest to q reachable from entry on one layer, nearest first
+    void _search_layer(const float *q, int entry, int ef, int level, std::vector<Candidate> &output) const;
+
+    // keep at most m of the candidates (nearest first), preferring those that are not behind a kept one
+    void _select_neighbors(const std::vector<Candidate> &candidates, int m, std::vector<int> &output) const;
+
+    void _insert(int node);
+    void _rebuild();
+
+  protected:
+    int m_max_neighbors;
+    int m_ef_construction;
+    double m_level_mult;
+
+    int m_dim = 0;
+    // node i is at m_features[i * m_dim]
+    std::vector<float> m_features;
+    std::vector<Node> m_nodes;
+    std::unordered_map<int, int> m_key2node;
+    size_t m_num_removed = 0;
+    int m_entry = -1;
+    std::mt19937 m_rng;
+
+    // m_visited[i] == m_visit_mark if node i was visited by the current search
+    mutable std::vector<uint32_t> m_visited;
+    mutable uint32_t m_visit_mark = 0;
+};
+
+} // namespace RedoxiTrack
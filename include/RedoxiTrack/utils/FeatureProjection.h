@@ -0,0 +1,87 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+
+namespace RedoxiTrack
+{
+
+/**
+ * linear map of features to fewer dimensions, output = components x (input - mean), usually fitted by PCA.
+ * reid models emit 512 to 2048-d features while association by cosine distance gains little beyond ~128-d,
+ * so projecting the features once when they enter a tracker makes every later distance and update cheaper
+ */
+class REDOXI_TRACK_API FeatureProjection
+{
+  public:
+    bool empty() const
+    {
+        return m_components.size() == 0;
+    }
+
+    int input_dim() const
+    {
+        return (int)m_components.cols();
+    }
+
+    int output_dim() const
+    {
+        return (int)m_components.rows();
+    }
+
+    const fVECTOR &get_mean() const
+    {
+        return m_mean;
+    }
+
+    // one component per row
+    const fMATRIX &get_components() const
+    {
+        return m_components;
+    }
+
+    /**
+     * set the projection directly
+     * @param mean input_dim, subtracted before projecting
+     * @param components output_dim x input_dim
+     */
+    void set(const fVECTOR &mean, const fMATRIX &components);
+
+    /**
+     * fit by PCA, keeping the output_dim directions of largest variance
+     * @param samples one feature per row, at least 2 rows
+     * @param output_dim in 1 .. samples.cols()
+     * @param center subtract the mean of the samples. without it the directions of largest energy are kept, which
+     * preserves the dot products of the features best, so cosine thresholds tuned on the full features still apply
+     * @return fraction of the variance (or energy) of the samples kept by the projection
+     */
+    double fit(const fMATRIX &samples, int output_dim, bool center = false);
+
+    /**
+     * read a projection written by save(), throws if the file can not be read
+     * @param path
+     */
+    void load(const std::string &path);
+
+    void save(const std::string &path) const;
+
+    /**
+     * project one feature
+     * @param input input_dim
+     * @param output resized to output_dim
+     */
+    void project(const Eigen::Ref<const fVECTOR> &input, fVECTOR &output) const;
+
+    /**
+     * project the rows of input with one matrix product
+     * @param input one input_dim feature per row
+     * @param output resized to input.rows() x output_dim
+     */
+    void project(const fMATRIX &input, fMATRIX &output) const;
+
+  protected:
+    fVECTOR m_mean;
+    fMATRIX m_components;
+};
+using FeatureProjectionPtr = std::shared_ptr<FeatureProjection>;
+
+} // namespace RedoxiTrack
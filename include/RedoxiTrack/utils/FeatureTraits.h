@@ -5,9 +5,63 @@
 #pragma once
 
 #include "RedoxiTrack/RedoxiTrackConfig.h"
+#include "RedoxiTrack/utils/CostMatrix.h"
+#include "RedoxiTrack/utils/FeatureProjection.h"
+#include "RedoxiTrack/utils/PackedFeatures.h"
+#include "RedoxiTrack/utils/SpatialGrid.h"
 
 namespace RedoxiTrack
 {
+class FeatureTraits;
+
+/**
+ * features of a list of detections or track targets packed as the rows of one matrix,
+ * the layout read by FeatureTraits::compute_distance_matrix()
+ */
+struct REDOXI_TRACK_API FeatureArray {
+    // row i is the feature of item i, zero if it has none. no columns when packed is filled instead
+    fMATRIX features;
+    // row i is the feature of item i, filled instead of features for traits that compare packed features
+    PackedFeatures packed;
+    // has_feature[i] = 0 if item i has no feature
+    std::vector<uint8_t> has_feature;
+
+    size_t size() const
+    {
+        return has_feature.size();
+    }
+
+    int dim() const
+    {
+        return packed.dim != 0 ? packed.dim : (int)features.cols();
+    }
+
+    /**
+     * fill from detections or track targets, all non-empty features must have the same size.
+     * if traits compares packed features, see FeatureTraits::get_packed_precision(), packed is filled with the
+     * packed features the items keep, and only the items without one are packed here
+     * @param items
+     * @param traits if not null, each row is brought to its stored form by traits->normalize()
+     * @param normalize false if the features of the items are already in their stored form
+     */
+    template <typename T>
+    void assign(const std::vector<std::shared_ptr<T>> &items, const FeatureTraits *traits = nullptr,
+                bool normalize = true)
+    {
+        assign(items.data(), items.size(), traits, normalize);
+    }
+
+    /**
+     * same as above from an array of raw or shared pointers
+     * @param items
+     * @param size
+     * @param traits
+     * @param normalize
+     */
+    template <typename Pointer>
+    void assign(const Pointer *items, size_t size, const FeatureTraits *traits = nullptr, bool normalize = true);
+};
+
 class REDOXI_TRACK_API FeatureTraits
 {
   public:
@@ -18,6 +72,132 @@ class REDOXI_TRACK_API FeatureTraits
     virtual void linear_combine(fVECTOR *output, const fVECTOR &fa, const fVECTOR &fb, double wa = 1, double wb = 1) const = 0;
     virtual double max_distance() const = 0;
     virtual double min_distance() const = 0;
+
+    /**
+     * bring a feature to the form it is stored in, so that distances can be computed without redoing it.
+     * the default keeps the feature unchanged
+     * @param feature
+     */
+    virtual void normalize(Eigen::Ref<fVECTOR> feature) const
+    {
+    }
+
+    /**
+     * the precision features are packed to for comparison, the default compares float features and returns false.
+     * trackers then pack each feature once when they store it, see pack_feature()
+     * @param output
+     * @return true if features are compared packed
+     */
+    virtual bool get_packed_precision(PackedFeatures::Precision &output) const
+    {
+        return false;
+    }
+
+    /**
+     * pack a feature in the form given by normalize() to one row of output, if get_packed_precision() is true
+     * @param feature
+     * @param output
+     */
+    virtual void pack_feature(const Eigen::Ref<const fVECTOR> &feature, PackedFeatures &output) const
+    {
+        output.clear();
+    }
+
+    /**
+     * output(i, j) = distance of a's row i to b's row j, or max_distance() if either has no feature.
+     * the rows must be in the form given by normalize(), the default calls distance() for every pair
+     * @param a
+     * @param b
+     * @param output resized to a.size() x b.size()
+     */
+    virtual void compute_distance_matrix(const FeatureArray &a, const FeatureArray &b, CostMatrix &output) const;
+
+    /**
+     * same as above but only the pairs listed in candidates are computed, the other elements are set to max_distance()
+     * @param a
+     * @param b
+     * @param candidates
+     * @param output
+     */
+    virtual void compute_distance_matrix(const FeatureArray &a, const FeatureArray &b, const CandidatePairs &candidates,
+                                         CostMatrix &output) const;
+
+    /**
+     * projection of the features of detections when they enter a tracker, null (the default) to keep them.
+     * the distances, smoothed features and galleries then all work on the projected features
+     * @param projection
+     */
+    void set_projection(const FeatureProjectionPtr &projection)
+    {
+        m_projection = projection;
+    }
+
+    const FeatureProjectionPtr &get_projection() const
+    {
+        return m_projection;
+    }
+
+    /**
+     * project a feature in place if a projection is set and the feature has its input size.
+     * features of other sizes, e.g. already projected ones, are left unchanged
+     * @param feature
+     * @return true if the feature was projected
+     */
+    bool project(fVECTOR &feature) const;
+
+  protected:
+    // set the elements of rows and columns without feature to max_distance()
+    void _fill_missing(const FeatureArray &a, const FeatureArray &b, CostMatrix &output) const;
+
+  protected:
+    FeatureProjectionPtr m_projection;
 };
 using FeatureTraitsPtr = std::shared_ptr<FeatureTraits>;
+
+template <typename Pointer>
+void FeatureArray::assign(const Pointer *items, size_t size, const FeatureTraits *traits, bool normalize)
+{
+    features.resize(size, 0);
+    has_feature.assign(size, 0);
+    packed.clear();
+    PackedFeatures::Precision precision;
+    if (traits && traits->get_packed_precision(precision)) {
+        fVECTOR feature;
+        PackedFeatures row;
+        for (size_t i = 0; i < size; i++) {
+            if (!items[i]->has_feature())
+                continue;
+            const int dim = (int)items[i]->feature_view().size();
+            if (packed.dim == 0)
+                packed.reset(precision, dim, size);
+            assert_throw(packed.dim == dim, "features of different sizes can not be packed together");
+            const PackedFeatures *stored = items[i]->packed_feature();
+            if (stored && stored->precision == precision && stored->dim == dim)
+                packed.copy_row(i, *stored, 0);
+            else {
+                feature = items[i]->feature_view();
+                if (normalize)
+                    traits->normalize(feature);
+                traits->pack_feature(feature, row);
+                packed.copy_row(i, row, 0);
+            }
+            has_feature[i] = 1;
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        if (!items[i]->has_feature())
+            continue;
+        const auto feature = items[i]->feature_view();
+        if (features.cols() == 0)
+            features.setZero(size, feature.size());
+        assert_throw(features.cols() == feature.size(), "features of different sizes can not be packed together");
+        Eigen::Map<fVECTOR> row(features.row(i).data(), features.cols());
+        row = feature;
+        if (traits && normalize)
+            traits->normalize(row);
+        has_feature[i] = 1;
+    }
+}
 } // namespace RedoxiTrack
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+
+namespace RedoxiTrack
+{
+
+/**
+ * linear kalman filter on fixed-size eigen matrices, stored inline without heap allocation.
+ * fields and predict()/correct() follow cv::KalmanFilter (without control input), so a model written for
+ * cv::KalmanFilter maps one to one: statePre -> state_pre, errorCovPost -> error_cov_post, ...
+ */
+template <int StateNum, int MeasureNum>
+class FixedKalmanFilter
+{
+  public:
+    static const int StateSize = StateNum;
+    static const int MeasureSize = MeasureNum;
+
+    using StateVector = Eigen::Matrix<float, StateNum, 1>;
+    using StateMatrix = Eigen::Matrix<float, StateNum, StateNum>;
+    using MeasureVector = Eigen::Matrix<float, MeasureNum, 1>;
+    using MeasureMatrix = Eigen::Matrix<float, MeasureNum, MeasureNum>;
+    using MeasurementMatrix = Eigen::Matrix<float, MeasureNum, StateNum>;
+    using GainMatrix = Eigen::Matrix<float, StateNum, MeasureNum>;
+
+  public:
+    FixedKalmanFilter()
+    {
+        state_pre.setZero();
+        state_post.setZero();
+        transition_matrix.setIdentity();
+        process_noise_cov.setIdentity();
+        measurement_matrix.setZero();
+        measurement_noise_cov.setIdentity();
+        error_cov_pre.setZero();
+        error_cov_post.setZero();
+        gain.setZero();
+    }
+
+    /**
+     * x'_t = A*x_{t-1}, P'_t = A*P_{t-1}*A' + Q. like cv::KalmanFilter, the post state is set to the
+     * prediction so that predicting again without a measurement continues from it
+     * @return the predicted state
+     */
+    const StateVector &predict()
+    {
+        state_pre.noalias() = transition_matrix * state_post;
+        StateMatrix ap;
+        ap.noalias() = transition_matrix * error_cov_post;
+        error_cov_pre.noalias() = ap * transition_matrix.transpose();
+        error_cov_pre += process_noise_cov;
+        state_post = state_pre;
+        error_cov_post = error_cov_pre;
+        return state_pre;
+    }
+
+    /**
+     * x_t = x'_t + K*(z_t - H*x'_t), P_t = P'_t - K*H*P'_t, with K = P'_t*H'*(H*P'_t*H' + R)^-1
+     * @param measurement z_t
+     * @return the corrected state
+     */
+    const StateVector &correct(const MeasureVector &measurement)
+    {
+        Eigen::Matrix<float, MeasureNum, StateNum> hp;
+        hp.noalias() = measurement_matrix * error_cov_pre;
+        MeasureMatrix innovation_cov;
+        innovation_cov.noalias() = hp * measurement_matrix.transpose();
+        innovation_cov += measurement_noise_cov;
+        // K' = S^-1 * H * P', S is symmetric positive definite
+        gain = innovation_cov.ldlt().solve(hp).transpose();
+        MeasureVector residual = measurement;
+        residual.noalias() -= measurement_matrix * state_pre;
+        state_post = state_pre;
+        state_post.noalias() += gain * residual;
+        error_cov_post = error_cov_pre;
+        error_cov_post.noalias() -= gain * hp;
+        return state_post;
+    }
+
+  public:
+    StateVector state_pre;               // x'_t
+    StateVector state_post;              // x_t
+    StateMatrix transition_matrix;       // A
+    StateMatrix process_noise_cov;       // Q
+    MeasurementMatrix measurement_matrix; // H
+    MeasureMatrix measurement_noise_cov; // R
+    StateMatrix error_cov_pre;           // P'_t
+    StateMatrix error_cov_post;          // P_t
+    GainMatrix gain;                     // K
+};
+
+// the filter held by KalmanTrackTarget, 8 states and 4 measurements.
+// models with fewer states leave the extra states decoupled at zero covariance
+using KalmanFilter = FixedKalmanFilter<8, 4>;
+
+} // namespace RedoxiTrack
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+
+#include <cstring>
+#include <vector>
+
+namespace RedoxiTrack
+{
+/**
+ * features packed with reduced precision, one feature per row, as compared by QuantizedCosineFeature.
+ * a row is fp16, or int8 with one scale per row, zero padded to a multiple of RowAlignment elements
+ */
+struct REDOXI_TRACK_API PackedFeatures {
+    enum class Precision {
+        Float16,
+        Int8
+    };
+    static const int RowAlignment = 32;
+
+    Precision precision = Precision::Float16;
+    int dim = 0;
+    int stride = 0;
+    std::vector<uint16_t> halves;
+    std::vector<int8_t> values;
+    // int8 only, value * scale is the float element
+    std::vector<float> scales;
+
+    size_t size() const
+    {
+        return stride == 0 ? 0 : (precision == Precision::Float16 ? halves.size() : values.size()) / stride;
+    }
+
+    /**
+     * set to rows zero rows of dim elements, the buffers are reused
+     * @param precision
+     * @param dim
+     * @param rows
+     */
+    void reset(Precision precision, int dim, size_t rows)
+    {
+        this->precision = precision;
+        this->dim = dim;
+        stride = (dim + RowAlignment - 1) / RowAlignment * RowAlignment;
+        if (precision == Precision::Float16) {
+            halves.assign(rows * stride, 0);
+            values.clear();
+            scales.clear();
+        } else {
+            halves.clear();
+            values.assign(rows * stride, 0);
+            scales.assign(rows, 0);
+        }
+    }
+
+    // drop all rows, the buffers are kept
+    void clear()
+    {
+        dim = 0;
+        stride = 0;
+        halves.clear();
+        values.clear();
+        scales.clear();
+    }
+
+    /**
+     * copy row j of other to row i, other must be packed with the same precision and dim
+     * @param i
+     * @param other
+     * @param j
+     */
+    void copy_row(size_t i, const PackedFeatures &other, size_t j)
+    {
+        if (precision == Precision::Float16) {
+            std::memcpy(halves.data() + i * stride, other.halves.data() + j * stride, stride * sizeof(uint16_t));
+        } else {
+            std::memcpy(values.data() + i * stride, other.values.data() + j * stride, stride * sizeof(int8_t));
+            scales[i] = other.scales[j];
+        }
+    }
+};
+} // namespace RedoxiTrack
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "RedoxiTrack/utils/CosineFeature.h"
+
+namespace RedoxiTrack
+{
+/**
+ * cosine distance computed on reduced precision copies of the features, fp16 or int8 with one scale per vector.
+ * the trackers pack each feature once when it is stored, detections when they arrive and targets and galleries
+ * when their features change (see FeatureTraits::pack_feature()), and the distance matrices read only the packed
+ * rows, 2x or 4x less memory than float. dot products use F16C and AVX2 with REDOXI_TRACK_WITH_AVX2,
+ * NEON on aarch64 with REDOXI_TRACK_WITH_NEON, and plain loops otherwise
+ */
+class REDOXI_TRACK_API QuantizedCosineFeature : public CosineFeature
+{
+  public:
+    using Precision = PackedFeatures::Precision;
+
+  public:
+    explicit QuantizedCosineFeature(Precision precision = Precision::Float16);
+
+    Precision get_precision() const
+    {
+        return m_precision;
+    }
+
+    /**
+     * distance of the quantized features, computed element by element without packing them.
+     * the same as compute_distance_matrix() up to float rounding
+     */
+    virtual double distance(const fVECTOR &input1, const fVECTOR &input2) const override;
+
+    virtual bool get_packed_precision(Precision &output) const override
+    {
+        output = m_precision;
+        return true;
+    }
+
+    virtual void pack_feature(const Eigen::Ref<const fVECTOR> &feature, PackedFeatures &output) const override;
+
+    /**
+     * compares the packed rows of a and b, arrays without them (not filled by FeatureArray::assign() with this
+     * object) are packed first
+     */
+    virtual void compute_distance_matrix(const FeatureArray &a, const FeatureArray &b, CostMatrix &output) const override;
+    virtual void compute_distance_matrix(const FeatureArray &a, const FeatureArray &b, const CandidatePairs &candidates,
+                                         CostMatrix &output) const override;
+
+    /**
+     * pack the rows of features with the precision of this object
+     * @param features one feature per row
+     * @param output
+     */
+    void pack(const fMATRIX &features, PackedFeatures &output) const;
+
+    /**
+     * output(i, j) = (1 - a's row i . b's row j) / 2, rows without feature are not treated specially
+     * @param a
+     * @param b
+     * @param output
+     */
+    void compute_distance_matrix(const PackedFeatures &a, const PackedFeatures &b, CostMatrix &output) const;
+
+    /**
+     * dot product of a packed row of a and a packed row of b, both packed with the same precision and dim
+     * @param a
+     * @param i
+     * @param b
+     * @param j
+     * @return
+     */
+    static float dot(const PackedFeatures &a, size_t i, const PackedFeatures &b, size_t j);
+
+  protected:
+    // a's packed rows, or a packed to scratch if it has none
+    const PackedFeatures &_packed(const FeatureArray &a, PackedFeatures &scratch) const;
+
+  protected:
+    Precision m_precision;
+};
+} // namespace RedoxiTrack
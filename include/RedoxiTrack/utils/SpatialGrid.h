@@ -0,0 +1,75 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+#include "RedoxiTrack/utils/BoxArray.h"
+
+namespace RedoxiTrack
+{
+
+/**
+ * candidate (source, target) pairs in compressed rows,
+ * the targets of source i are targets[offsets[i]] .. targets[offsets[i + 1] - 1], in ascending order
+ */
+struct REDOXI_TRACK_API CandidatePairs {
+    std::vector<int> offsets;
+    std::vector<int> targets;
+
+    int num_sources() const
+    {
+        return offsets.empty() ? 0 : (int)offsets.size() - 1;
+    }
+    size_t num_pairs() const
+    {
+        return targets.size();
+    }
+};
+
+/**
+ * uniform grid over a set of boxes, used to find which boxes can overlap a query box
+ * without testing every pair. each box is registered in every cell it touches.
+ */
+class REDOXI_TRACK_API SpatialGrid
+{
+  public:
+    /**
+     * index the boxes, the grid keeps its storage across calls.
+     * only a pointer to boxes is kept, it must stay unchanged while the grid is queried
+     * @param boxes
+     * @param cell_size side of a square cell, <= 0 to use the median box side
+     */
+    void build(const BoxArray &boxes, float cell_size = 0);
+
+    /**
+     * for each query box, find the indexed boxes that overlap it after growing it by radius on every side.
+     * overlap follows the +1 pixel convention of compute_iou(), so every pair with a non-zero iou is returned
+     * @param queries
+     * @param radius gating radius in pixels
+     * @param output
+     */
+    void query(const BoxArray &queries, float radius, CandidatePairs &output) const;
+
+    size_t size() const
+    {
+        return m_boxes ? m_boxes->size() : 0;
+    }
+
+  protected:
+    void _cell_range(float x1, float y1, float x2, float y2, int &cx1, int &cy1, int &cx2, int &cy2) const;
+
+  protected:
+    const BoxArray *m_boxes = nullptr;
+    float m_origin_x = 0;
+    float m_origin_y = 0;
+    float m_cell_size = 1;
+    int m_num_cols = 0;
+    int m_num_rows = 0;
+
+    // box indices of cell c are m_cell_items[m_cell_offsets[c]] .. m_cell_items[m_cell_offsets[c + 1] - 1]
+    std::vector<int> m_cell_offsets;
+    std::vector<int> m_cell_items;
+
+    // last query that visited each box, to report a box spanning several cells once
+    mutable std::vector<int> m_visited;
+};
+
+} // namespace RedoxiTrack
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+#include <atomic>
+#include <memory>
+
+namespace RedoxiTrack
+{
+
+/**
+ * bounded lock-free ring between one producer thread and one consumer thread.
+ * every slot carries a sequence number which tells whether it holds an item of the current lap, so push
+ * and pop only touch the slot and their own index. the producer may also pop, to drop the oldest item
+ * of a full ring, pops claim the item by a compare-exchange on the head so the two can not take the same one.
+ * T must be default constructible and movable
+ */
+template <class T>
+class SpscRing
+{
+  public:
+    /**
+     * @param capacity raised to 2, with one slot a full and an empty slot would have the same sequence number
+     */
+    explicit SpscRing(size_t capacity)
+        : m_capacity(capacity > 2 ? capacity : 2), m_slots(new Slot[m_capacity])
+    {
+        for (size_t i = 0; i < m_capacity; i++)
+            m_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    /**
+     * number of items in the ring, exact only on the producer or the consumer thread when the other is idle
+     */
+    size_t size() const
+    {
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        size_t head = m_head.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * producer only, the item is moved in on success and left untouched otherwise
+     * @param item
+     * @return false if the ring is full, or its oldest slot is still being read by a pop
+     */
+    bool try_push(T &item)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        Slot &slot = m_slots[tail % m_capacity];
+        if (slot.seq.load(std::memory_order_acquire) != tail)
+            return false;
+        slot.value = std::move(item);
+        slot.seq.store(tail + 1, std::memory_order_release);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * consumer, or the producer dropping the oldest item
+     * @param output
+     * @return false if the ring is empty
+     */
+    bool try_pop(T &output)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        while (true) {
+            Slot &slot = m_slots[head % m_capacity];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq == head + 1) {
+                // the slot holds the item of this lap, whoever moves the head owns it
+                if (m_head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel,
+                                                 std::memory_order_relaxed)) {
+                    output = std::move(slot.value);
+                    slot.value = T();
+                    // free for the next lap of the producer
+                    slot.seq.store(head + m_capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (seq < head + 1)
+                return false;
+            else
+                // another pop took this item and moved on
+                head = m_head.load(std::memory_order_relaxed);
+        }
+    }
+
+  protected:
+    struct alignas(64) Slot {
+        std::atomic<size_t> seq{0};
+        T value;
+    };
+
+    const size_t m_capacity;
+    std::unique_ptr<Slot[]> m_slots;
+
+    // on their own cache lines, the producer writes the tail and the consumer the head
+    alignas(64) std::atomic<size_t> m_tail{0};
+    alignas(64) std::atomic<size_t> m_head{0};
+};
+
+} // namespace RedoxiTrack
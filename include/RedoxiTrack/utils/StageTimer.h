@@ -0,0 +1,100 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+#include <chrono>
+
+namespace RedoxiTrack
+{
+
+/**
+ * accumulates wall time spent in each stage of track(), used for profiling.
+ * trackers only touch it through StageTimer::Scope, which is a no-op when no timer is attached
+ */
+class REDOXI_TRACK_API StageTimer
+{
+  public:
+    enum Stage {
+        MotionPrediction = 0, // kalman / optical flow prediction of all targets
+        CostMatrix,           // building iou / appearance / gating cost matrices
+        Assignment,           // lapjv_match / hungarian_match
+        NumStages
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * measure the time from construction to stop() or destruction, and add it to the timer
+     */
+    class Scope
+    {
+      public:
+        Scope(StageTimer *timer, Stage stage)
+            : m_timer(timer), m_stage(stage)
+        {
+            if (m_timer)
+                m_start = Clock::now();
+        }
+        ~Scope()
+        {
+            stop();
+        }
+
+        void stop()
+        {
+            if (m_timer) {
+                m_timer->add(m_stage, std::chrono::duration<double>(Clock::now() - m_start).count());
+                m_timer = nullptr;
+            }
+        }
+
+      protected:
+        StageTimer *m_timer = nullptr;
+        Stage m_stage;
+        Clock::time_point m_start;
+    };
+
+  public:
+    /**
+     * clear all accumulated time, usually called before each track()
+     */
+    void reset()
+    {
+        for (int i = 0; i < NumStages; i++)
+            m_seconds[i] = 0;
+    }
+
+    void add(Stage stage, double seconds)
+    {
+        m_seconds[stage] += seconds;
+    }
+
+    /**
+     * get accumulated time of a stage in seconds
+     * @param stage
+     * @return
+     */
+    double get(Stage stage) const
+    {
+        return m_seconds[stage];
+    }
+
+    static const char *get_stage_name(Stage stage)
+    {
+        switch (stage) {
+        case MotionPrediction:
+            return "motion_prediction";
+        case CostMatrix:
+            return "cost_matrix";
+        case Assignment:
+            return "assignment";
+        default:
+            return "unknown";
+        }
+    }
+
+  protected:
+    double m_seconds[NumStages] = {0};
+};
+using StageTimerPtr = std::shared_ptr<StageTimer>;
+
+} // namespace RedoxiTrack
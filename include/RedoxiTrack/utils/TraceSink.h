@@ -0,0 +1,153 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+#include <cstdint>
+
+// trace checkpoints are compiled into the trackers only when REDOXI_TRACK_WITH_TRACE is 1,
+// otherwise every trace call is removed by the compiler
+#ifndef REDOXI_TRACK_WITH_TRACE
+#    define REDOXI_TRACK_WITH_TRACE 0
+#endif
+
+namespace RedoxiTrack
+{
+
+/**
+ * one fixed-size entry of the trace ring buffer
+ */
+struct TraceRecord {
+    int32_t m_frame_number;
+    uint16_t m_checkpoint; // TraceSink::Checkpoint
+    uint16_t m_kind;       // TraceSink::RecordKind
+    int32_t m_a;           // path id, detection index, matched source, unmatched index or cost row
+    int32_t m_b;           // activated flag, detection confidence x1000, matched target or cost column
+    float m_value[4];      // bbox (x, y, w, h), or cost in m_value[0]
+};
+
+/**
+ * binary ring buffer of tracker checkpoints, used to debug association after an incident.
+ * recording is disabled at runtime by default, when the buffer is full the oldest records are overwritten.
+ * a sink must only be written by one tracker thread at a time.
+ */
+class REDOXI_TRACK_API TraceSink
+{
+  public:
+    /**
+     * checkpoints of the tracking pipeline, numbered as in the original BoT-SORT debug dumps
+     */
+    enum Checkpoint {
+        TrackedTargets = 1,
+        LostTargets = 2,
+        RemovedTargets = 3,
+        HighScoreDetections = 4,
+        Unconfirmed = 5,
+        TargetPool = 6,
+        TargetPoolPredicted = 7,
+        FirstIouDistance = 8,
+        FuseScoreDistance = 9,
+        FirstAppearanceDistance = 10,
+        FirstMatched = 11,
+        FirstUnmatchedTrack = 12,
+        FirstUnmatchedDetection = 13,
+        LowScoreDetections = 14,
+        SecondIouDistance = 15,
+        SecondMatched = 16,
+        SecondUnmatchedTrack = 17,
+        SecondUnmatchedDetection = 18,
+        FinalDistance = 19,
+        ThirdMatched = 22,
+        ThirdUnmatchedTrack = 23,
+        ThirdUnmatchedDetection = 24,
+        Activated = 25,
+        Refind = 26,
+        Lost = 27,
+        Removed = 28,
+        BeforeDedupTracked = 29,
+        BeforeDedupLost = 30,
+        AfterDedupLost = 31,
+        Output = 32
+    };
+
+    enum RecordKind {
+        Target = 0,
+        Detection,
+        Match,
+        Index,
+        Cost
+    };
+
+  public:
+    /**
+     * @param capacity number of records kept in the ring buffer
+     */
+    explicit TraceSink(size_t capacity = 1 << 16);
+
+    void set_enabled(bool enabled)
+    {
+        m_enabled = enabled;
+    }
+    bool is_enabled() const
+    {
+        return m_enabled;
+    }
+
+    /**
+     * frame number stamped on all following records
+     * @param frame_number
+     */
+    void set_frame_number(int frame_number)
+    {
+        m_frame_number = frame_number;
+    }
+
+    void record_target(int checkpoint, int path_id, const BBOX &bbox, int flag);
+    void record_detection(int checkpoint, int index, const BBOX &bbox, float confidence);
+    void record_match(int checkpoint, int source, int target);
+    void record_index(int checkpoint, int index);
+    void record_cost(int checkpoint, int row, int col, float value);
+
+    /**
+     * drop all records
+     */
+    void clear();
+
+    size_t size() const;
+    size_t capacity() const
+    {
+        return m_records.size();
+    }
+
+    /**
+     * copy the records, oldest first
+     * @return
+     */
+    std::vector<TraceRecord> snapshot() const;
+
+    /**
+     * write records to a binary file: 8 bytes magic "RXTRACE1", uint32 record size, uint32 reserved,
+     * uint64 record count, followed by the records oldest first
+     * @param path
+     * @return false if the file can not be written
+     */
+    bool dump(const std::string &path) const;
+
+    /**
+     * write records as csv text: frame,checkpoint,kind,a,b,v0,v1,v2,v3
+     * @param os
+     */
+    void dump_text(std::ostream &os) const;
+
+    static const char *get_checkpoint_name(int checkpoint);
+
+  protected:
+    void _push(int checkpoint, int kind, int a, int b, float v0, float v1 = 0, float v2 = 0, float v3 = 0);
+
+  protected:
+    std::vector<TraceRecord> m_records;
+    uint64_t m_next = 0; // total number of records ever pushed
+    int m_frame_number = INIT_TRACKING_FRAME;
+    bool m_enabled = false;
+};
+using TraceSinkPtr = std::shared_ptr<TraceSink>;
+
+} // namespace RedoxiTrack
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "RedoxiTrack/RedoxiTrackConfig.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace RedoxiTrack
+{
+
+/**
+ * fixed set of worker threads, each with its own task queue. a worker runs the tasks of its queue in
+ * submission order and, when it is empty, steals the newest task of another worker, so the threads stay
+ * busy without contending on one shared queue. the queues are short and guarded by their own mutex.
+ * tasks must not throw, catch inside the task instead
+ */
+class REDOXI_TRACK_API WorkStealingPool
+{
+  public:
+    using Task = std::function<void()>;
+
+    WorkStealingPool(){};
+    virtual ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    /**
+     * start the worker threads, the pool must be stopped
+     * @param num_threads <= 0 to use one thread per hardware thread
+     */
+    void start(int num_threads);
+
+    /**
+     * run the tasks already submitted, then join the threads
+     */
+    void stop();
+
+    int get_num_threads() const
+    {
+        return (int)m_threads.size();
+    }
+
+    /**
+     * queue a task. from a worker of this pool it goes to the worker's own queue,
+     * from other threads the queues are used in turn
+     * @param task
+     */
+    void submit(Task task);
+
+    /**
+     * run fn(begin, end) over [0, num_items) in tiles of grain items, on the pool and on the calling thread,
+     * and return when every tile is done. called from a worker of the pool it can not deadlock, tiles that
+     * no other worker picks up are run by the caller. fn must not throw
+     * @param num_items
+     * @param grain items per tile
+     * @param fn
+     */
+    void parallel_for(size_t num_items, size_t grain, const std::function<void(size_t, size_t)> &fn);
+
+  protected:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // take a task from the front of the own queue, or from the back of another one
+    bool _take(size_t index, Task &task);
+
+    void _worker_loop(size_t index);
+
+  protected:
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+
+    // queued and not yet taken, the workers sleep while it is 0
+    std::atomic<size_t> m_num_queued{0};
+    std::atomic<size_t> m_next_worker{0};
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+};
+using WorkStealingPoolPtr = std::shared_ptr<WorkStealingPool>;
+
+/**
+ * one task running in the background, on a WorkStealingPool or on its own thread, and joined later.
+ * a task no worker has picked up yet is run by join() itself, so a worker of the pool can join it without
+ * deadlock, and it is dropped by reset() or the destructor
+ */
+class REDOXI_TRACK_API AsyncTask
+{
+  public:
+    AsyncTask(){};
+    virtual ~AsyncTask();
+
+    AsyncTask(const AsyncTask &) = delete;
+    AsyncTask &operator=(const AsyncTask &) = delete;
+
+    /**
+     * start a task, a previous one is reset() first
+     * @param pool runs the task, nullptr or a stopped pool to start a thread for it
+     * @param task
+     */
+    void start(WorkStealingPool *pool, WorkStealingPool::Task task);
+
+    /**
+     * true from start() until join() or reset()
+     */
+    bool valid() const
+    {
+        return m_state != nullptr;
+    }
+
+    /**
+     * wait until the task is done, rethrow its exception
+     */
+    void join();
+
+    /**
+     * drop the task if it has not started, wait for it otherwise, its exception is ignored
+     */
+    void reset();
+
+  protected:
+    struct State {
+        // set by whoever runs the task, the pool, the thread or join()
+        std::atomic<bool> claimed{false};
+        WorkStealingPool::Task task;
+        std::promise<void> done;
+    };
+
+    // run the task if nobody has, true if this call ran it
+    static bool _run(const std::shared_ptr<State> &state);
+
+  protected:
+    std::shared_ptr<State> m_state;
+    std::future<void> m_done;
+    // the thread without a pool
+    std::future<void> m_thread;
+};
+
+} // namespace RedoxiTrack
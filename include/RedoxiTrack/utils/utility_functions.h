@@ -4,10 +4,15 @@
 #include "RedoxiTrack/detection/Detection.h"
 #include "RedoxiTrack/external/Hungarian.h"
 #include "RedoxiTrack/external/lapjv.h"
+#include "RedoxiTrack/utils/BoxArray.h"
+#include "RedoxiTrack/utils/CostMatrix.h"
+#include "RedoxiTrack/utils/KalmanFilter.h"
+#include "RedoxiTrack/utils/SpatialGrid.h"
 
 namespace RedoxiTrack
 {
-REDOXI_TRACK_API void copy_kalmanFilter(const cv::KalmanFilter &from, cv::KalmanFilter &to);
+// the filter is stored inline, this is a plain copy
+REDOXI_TRACK_API void copy_kalmanFilter(const KalmanFilter &from, KalmanFilter &to);
 
 REDOXI_TRACK_API float median(std::vector<float> &v, const float empty_output = -9999);
 REDOXI_TRACK_API float compute_iou(const Detection &source, const Detection &target);
@@ -18,6 +23,39 @@ REDOXI_TRACK_API void compute_pairwise_iou(const std::vector<DetectionPtr> &sour
                                            const std::vector<DetectionPtr> &target,
                                            fMATRIX *out_distance);
 
+// output[i * output_stride + j] = IOU of source[i] and target[j], or 1 - IOU if output_distance is set.
+// gives the same values as compute_iou(), rows are computed with AVX2 or NEON when the library is built for them
+// (REDOXI_TRACK_WITH_AVX2, REDOXI_TRACK_WITH_NEON)
+REDOXI_TRACK_API void compute_pairwise_iou(const BoxArray &source, const BoxArray &target,
+                                           float *output, size_t output_stride, bool output_distance = false);
+
+// rows first .. last - 1 of the above, output still points to row 0. tiles of rows can be computed in parallel
+REDOXI_TRACK_API void compute_pairwise_iou_rows(const BoxArray &source, size_t first, size_t last,
+                                                const BoxArray &target, float *output, size_t output_stride,
+                                                bool output_distance = false);
+
+// same as above, output is resized to source.size() x target.size()
+REDOXI_TRACK_API void compute_pairwise_iou(const BoxArray &source, const BoxArray &target,
+                                           CostMatrix &output, bool output_distance = false);
+
+// same as above but only the pairs listed in candidates are computed, the other elements are set to
+// 0 (or 1 for distance). exact when candidates hold every overlapping pair, see SpatialGrid::query()
+REDOXI_TRACK_API void compute_pairwise_iou(const BoxArray &source, const BoxArray &target,
+                                           const CandidatePairs &candidates, CostMatrix &output,
+                                           bool output_distance = false);
+
+// the pairs (i, j) with matrix(i, j) <= max_value, in row order. with within set only its pairs are tested,
+// e.g. to gate the candidates of a distance matrix that was only computed for them
+REDOXI_TRACK_API void select_pairs(const CostMatrix &matrix, float max_value, const CandidatePairs *within,
+                                   CandidatePairs &output);
+
+// output[i][j] = squared mahalanobis distance of measurements[i] to the gaussian (means[j], covariances[j]).
+// each covariance is factorised once, then the distances of all measurements are computed as a batch
+REDOXI_TRACK_API void compute_pairwise_mahalanobis(const std::vector<KalmanFilter::MeasureVector> &measurements,
+                                                   const std::vector<KalmanFilter::MeasureVector> &means,
+                                                   const std::vector<KalmanFilter::MeasureMatrix> &covariances,
+                                                   CostMatrix &output);
+
 // return (u,v) means source[u] matches to target[v]
 REDOXI_TRACK_API std::vector<std::pair<int, int>>
     match_detecion_by_iou(const std::vector<DetectionPtr> &source, const std::vector<DetectionPtr> &target);
@@ -38,6 +76,30 @@ REDOXI_TRACK_API void lapjv_match(const std::vector<std::vector<float>> &matrix_
                                   std::vector<int> &output_unmatched_source,
                                   std::vector<int> &output_unmatched_target);
 
+// same as above, source_length and target_length are the rows and cols of the matrix, which is read in place
+REDOXI_TRACK_API void hungarian_match(const CostMatrix &matrix_source2target, const float thresh,
+                                      std::vector<std::pair<int, int>> &output_matched_pair,
+                                      std::vector<int> &output_unmatched_source,
+                                      std::vector<int> &output_unmatched_target);
+
+REDOXI_TRACK_API void lapjv_match(const CostMatrix &matrix_source2target, const float thresh,
+                                  std::vector<std::pair<int, int>> &output_matched_pair,
+                                  std::vector<int> &output_unmatched_source,
+                                  std::vector<int> &output_unmatched_target);
+
+// same as above, but only pairs with cost <= thresh connect a source and a target.
+// the resulting bipartite graph is split into connected components and each one is solved on its own,
+// so a wide scene becomes many small problems instead of one large one
+REDOXI_TRACK_API void hungarian_match_sparse(const CostMatrix &matrix_source2target, const float thresh,
+                                             std::vector<std::pair<int, int>> &output_matched_pair,
+                                             std::vector<int> &output_unmatched_source,
+                                             std::vector<int> &output_unmatched_target);
+
+REDOXI_TRACK_API void lapjv_match_sparse(const CostMatrix &matrix_source2target, const float thresh,
+                                         std::vector<std::pair<int, int>> &output_matched_pair,
+                                         std::vector<int> &output_unmatched_source,
+                                         std::vector<int> &output_unmatched_target);
+
 REDOXI_TRACK_API std::vector<POINT> generate_uniform_keypoints(const BBOX &bbox, int pts_width, int pts_height, float margin = 0.25);
 
 REDOXI_TRACK_API BBOX predict_bbox_by_keypoints(const BBOX &bbox,
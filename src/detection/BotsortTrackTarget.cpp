@@ -6,15 +6,23 @@
 
 namespace RedoxiTrack {
     DetectionPtr BotsortTrackTarget::clone() const {
+        return clone(true);
+    }
+
+    void BotsortTrackTarget::copy_to(Detection &target) const {
+        copy_to(target, true);
+    }
+
+    DetectionPtr BotsortTrackTarget::clone(bool with_detection) const {
         auto output = std::make_shared<BotsortTrackTarget>();
-        copy_to(*output);
+        copy_to(*output, with_detection);
         return output;
     }
 
-    void BotsortTrackTarget::copy_to(Detection &target) const {
+    void BotsortTrackTarget::copy_to(Detection &target, bool with_detection) const {
         auto p =dynamic_cast<BotsortTrackTarget*>(&target);
         assert_throw(p, "failed to convert Detection to BotsortTrackTarget");
-        TrackTarget::copy_to(target);
+        TrackTarget::copy_to(target, with_detection);
         p->m_optical_target = m_optical_target;
         p->m_kalman_target = m_kalman_target;
         p->m_is_activated = m_is_activated;
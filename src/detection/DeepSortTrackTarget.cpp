@@ -6,15 +6,23 @@
 
 namespace RedoxiTrack {
     DetectionPtr DeepSortTrackTarget::clone() const {
+        return clone(true);
+    }
+
+    void DeepSortTrackTarget::copy_to(Detection &target) const {
+        copy_to(target, true);
+    }
+
+    DetectionPtr DeepSortTrackTarget::clone(bool with_detection) const {
         auto output = std::make_shared<DeepSortTrackTarget>();
-        copy_to(*output);
+        copy_to(*output, with_detection);
         return output;
     }
 
-    void DeepSortTrackTarget::copy_to(Detection &target) const {
+    void DeepSortTrackTarget::copy_to(Detection &target, bool with_detection) const {
         auto p =dynamic_cast<DeepSortTrackTarget*>(&target);
         assert_throw(p, "failed to convert Detection to DeepSortTrackTarget");
-        TrackTarget::copy_to(target);
+        TrackTarget::copy_to(target, with_detection);
         p->m_optical_target = m_optical_target;
         p->m_kalman_target = m_kalman_target;
     }
@@ -0,0 +1,12 @@
+#include "RedoxiTrack/detection/IDObject.h"
+#include <atomic>
+
+namespace RedoxiTrack
+{
+    int64_t IDObject::generate_id()
+    {
+        // only uniqueness is needed, no ordering with other memory
+        static std::atomic<int64_t> next_id(0);
+        return next_id.fetch_add(1, std::memory_order_relaxed);
+    }
+}
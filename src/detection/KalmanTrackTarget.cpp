@@ -9,19 +9,27 @@ namespace RedoxiTrack{
     void KalmanTrackTarget::print() {
         TrackTarget::print();
         std::cout<<"kf state "<<std::endl;
-        std::cout<<m_kf.statePost<<std::endl;
+        std::cout<<m_kf.state_post.transpose()<<std::endl;
     }
 
     DetectionPtr KalmanTrackTarget::clone() const {
+        return clone(true);
+    }
+
+    void KalmanTrackTarget::copy_to(Detection &target) const {
+        copy_to(target, true);
+    }
+
+    DetectionPtr KalmanTrackTarget::clone(bool with_detection) const {
         auto output = std::make_shared<KalmanTrackTarget>();
-        copy_to(*output);
+        copy_to(*output, with_detection);
         return output;
     }
 
-    void KalmanTrackTarget::copy_to(Detection &target) const {
+    void KalmanTrackTarget::copy_to(Detection &target, bool with_detection) const {
         auto p = dynamic_cast<KalmanTrackTarget*>(&target);
         assert_throw(p, "failed to convert Detection to Kalman!");
-        TrackTarget::copy_to(target);
+        TrackTarget::copy_to(target, with_detection);
         copy_kalmanFilter(m_kf, p->m_kf);
         p->m_can_be_update = m_can_be_update;
     }
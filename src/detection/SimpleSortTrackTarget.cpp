@@ -6,15 +6,23 @@
 
 namespace RedoxiTrack {
     DetectionPtr SimpleSortTrackTarget::clone() const {
+        return clone(true);
+    }
+
+    void SimpleSortTrackTarget::copy_to(Detection &target) const {
+        copy_to(target, true);
+    }
+
+    DetectionPtr SimpleSortTrackTarget::clone(bool with_detection) const {
         auto output = std::make_shared<SimpleSortTrackTarget>();
-        copy_to(*output);
+        copy_to(*output, with_detection);
         return output;
     }
 
-    void SimpleSortTrackTarget::copy_to(Detection &target) const {
+    void SimpleSortTrackTarget::copy_to(Detection &target, bool with_detection) const {
         auto p =dynamic_cast<SimpleSortTrackTarget*>(&target);
         assert_throw(p, "failed to convert Detection to SimpleSortTrackTarget");
-        TrackTarget::copy_to(target);
+        TrackTarget::copy_to(target, with_detection);
         p->m_kalman_target = m_kalman_target;
     }
 
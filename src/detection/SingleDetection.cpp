@@ -29,6 +29,12 @@ namespace RedoxiTrack
 
     void SingleDetection::set_feature(const fVECTOR& x){
         m_feature = x;
+        m_packed_feature.clear();
+    }
+
+    void SingleDetection::set_packed_feature(const PackedFeatures& x){
+        assert_throw(x.size() == 1 && x.dim == m_feature.size(), "packed feature does not match the feature");
+        m_packed_feature = x;
     }
 
     void SingleDetection::set_confidence(const float& conf){
@@ -56,6 +62,7 @@ namespace RedoxiTrack
         assert_throw(p, "Failed convert Detection to SingleDetection");
         Detection::copy_to(to);
         p->m_feature = m_feature;
+        p->m_packed_feature = m_packed_feature;
         p->m_confidence = m_confidence;
         p->m_quality = m_quality;
         p->m_bbox = m_bbox;
@@ -37,7 +37,10 @@ namespace RedoxiTrack
         if(m_detection)
         {
             if(with_detection) {
-                if (_target.m_detection)
+                if (_target.m_detection == m_detection) {
+                    // shared with a clone made without detection, nothing to copy
+                }
+                else if (_target.m_detection)
                     m_detection->copy_to(*_target.m_detection);
                 else
                     _target.m_detection = m_detection->clone();
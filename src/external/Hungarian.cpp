@@ -29,32 +29,38 @@ namespace RedoxiTrack{
 
         unsigned int nCols = DistMatrix[0].size();
         float *distMatrixIn = new float[nRows * nCols];
-        int *assignment = new int[nRows];
 
-        // Fill in the distMatrixIn. Mind the index is "i + nRows * j".
-        // Here the cost matrix of size MxN is defined as a single precision array of N*M elements.
-        // In the solving functions matrices are seen to be saved MATLAB-internally in row-order.
-        // (i.e. the matrix [1 2; 3 4] will be stored as a vector [1 3 2 4], NOT [1 2 3 4]).
+        // pack the rows into one row-major array
         for (unsigned int i = 0; i < nRows; i++)
             for (unsigned int j = 0; j < nCols; j++)
-                distMatrixIn[i + nRows * j] = DistMatrix[i][j];
+                distMatrixIn[i * nCols + j] = DistMatrix[i][j];
+
+        cost = Solve(distMatrixIn, nRows, nCols, nCols, Assignment);
 
-        // call solving function
-        assignmentoptimal(assignment, &cost, distMatrixIn, nRows, nCols);
+        delete[] distMatrixIn;
+        return cost;
+    }
 
+    float HungarianAlgorithm::Solve(const float *DistMatrix, int nRows, int nCols, size_t rowStride, vector<int> &Assignment)
+    {
+        float cost = 0.0f;
         Assignment.clear();
-        for (unsigned int r = 0; r < nRows; r++)
-            Assignment.push_back(assignment[r]);
+        if (nRows == 0)
+            return cost;
 
-        delete[] distMatrixIn;
-        delete[] assignment;
+        Assignment.assign(nRows, -1);
+        if (nCols <= 0)
+            return cost;
+
+        // call solving function, it reads the row-major input straight into its column-major working copy
+        assignmentoptimal(Assignment.data(), &cost, DistMatrix, rowStride, nRows, nCols);
         return cost;
     }
 
 //********************************************************//
 // Solve optimal solution for assignment problem using Munkres algorithm, also known as Hungarian Algorithm.
 //********************************************************//
-    void HungarianAlgorithm::assignmentoptimal(int *assignment, float *cost, float *distMatrixIn, int nOfRows, int nOfColumns)
+    void HungarianAlgorithm::assignmentoptimal(int *assignment, float *cost, const float *distMatrixIn, size_t rowStride, int nOfRows, int nOfColumns)
     {
         float *distMatrix, *distMatrixTemp, *distMatrixEnd, *columnEnd, value, minValue;
         bool *coveredColumns, *coveredRows, *starMatrix, *newStarMatrix, *primeMatrix;
@@ -64,6 +70,8 @@ namespace RedoxiTrack{
         *cost = 0;
         for (row = 0; row < nOfRows; row++)
             assignment[row] = -1;
+        if (nOfRows <= 0 || nOfColumns <= 0)
+            return;
 
         /* generate working copy of distance Matrix */
         /* check if all matrix elements are positive */
@@ -71,11 +79,17 @@ namespace RedoxiTrack{
         distMatrix = (float *)malloc(nOfElements * sizeof(float));
         distMatrixEnd = distMatrix + nOfElements;
 
-        for (row = 0; row < nOfElements; row++) {
-            value = distMatrixIn[row];
-            if (value < 0)
-                cerr << "All matrix elements have to be non-negative." << endl;
-            distMatrix[row] = value;
+        // Mind the index of the working copy is "row + nOfRows * col",
+        // matrices are seen to be saved MATLAB-internally in column-order.
+        // (i.e. the matrix [1 2; 3 4] will be stored as a vector [1 3 2 4], NOT [1 2 3 4]).
+        for (row = 0; row < nOfRows; row++) {
+            const float *rowIn = distMatrixIn + row * rowStride;
+            for (col = 0; col < nOfColumns; col++) {
+                value = rowIn[col];
+                if (value < 0)
+                    cerr << "All matrix elements have to be non-negative." << endl;
+                distMatrix[row + nOfRows * col] = value;
+            }
         }
 
         /* memory allocation */
@@ -158,7 +172,7 @@ namespace RedoxiTrack{
         step2b(assignment, distMatrix, starMatrix, newStarMatrix, primeMatrix, coveredColumns, coveredRows, nOfRows, nOfColumns, minDim);
 
         /* compute cost and remove invalid assignments */
-        computeassignmentcost(assignment, cost, distMatrixIn, nOfRows);
+        computeassignmentcost(assignment, cost, distMatrixIn, rowStride, nOfRows);
 
         /* free allocated memory */
         free(distMatrix);
@@ -189,14 +203,14 @@ namespace RedoxiTrack{
     }
 
 /********************************************************/
-    void HungarianAlgorithm::computeassignmentcost(int *assignment, float *cost, float *distMatrix, int nOfRows)
+    void HungarianAlgorithm::computeassignmentcost(int *assignment, float *cost, const float *distMatrix, size_t rowStride, int nOfRows)
     {
         int row, col;
 
         for (row = 0; row < nOfRows; row++) {
             col = assignment[row];
             if (col >= 0)
-                *cost += distMatrix[row + nOfRows * col];
+                *cost += distMatrix[row * rowStride + col];
         }
     }
 
@@ -1,12 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include "RedoxiTrack/external/lapjv.h"
 
 /** Column-reduction and reduction transfer for a dense cost matrix.
  */
-int_t _ccrrt_dense(const uint_t n, cost_t *cost[],
+template <typename CostRows>
+int_t _ccrrt_dense(const uint_t n, const CostRows &cost,
                      int_t *free_rows, int_t *x, int_t *y, cost_t *v)
 {
     int_t n_free_rows;
@@ -71,8 +73,9 @@ int_t _ccrrt_dense(const uint_t n, cost_t *cost[],
 
 /** Augmenting row reduction for a dense cost matrix.
  */
+template <typename CostRows>
 int_t _carr_dense(
-    const uint_t n, cost_t *cost[],
+    const uint_t n, const CostRows &cost,
     const uint_t n_free_rows,
     int_t *free_rows, int_t *x, int_t *y, cost_t *v)
 {
@@ -165,7 +168,8 @@ uint_t _find_dense(const uint_t n, uint_t lo, cost_t *d, int_t *cols, int_t *y)
 
 // Scan all columns in TODO starting from arbitrary column in SCAN
 // and try to decrease d of the TODO columns using the SCAN column.
-int_t _scan_dense(const uint_t n, cost_t *cost[],
+template <typename CostRows>
+int_t _scan_dense(const uint_t n, const CostRows &cost,
                     uint_t *plo, uint_t*phi,
                     cost_t *d, int_t *cols, int_t *pred,
                     int_t *y, cost_t *v)
@@ -209,8 +213,9 @@ int_t _scan_dense(const uint_t n, cost_t *cost[],
  *
  * \return The closest free column index.
  */
+template <typename CostRows>
 int_t find_path_dense(
-    const uint_t n, cost_t *cost[],
+    const uint_t n, const CostRows &cost,
     const int_t start_i,
     int_t *y, cost_t *v,
     int_t *pred)
@@ -274,8 +279,9 @@ int_t find_path_dense(
 
 /** Augment for a dense cost matrix.
  */
+template <typename CostRows>
 int_t _ca_dense(
-    const uint_t n, cost_t *cost[],
+    const uint_t n, const CostRows &cost,
     const uint_t n_free_rows,
     int_t *free_rows, int_t *x, int_t *y, cost_t *v)
 {
@@ -312,8 +318,9 @@ int_t _ca_dense(
 
 /** Solve dense sparse LAP.
  */
-int lapjv_internal(
-    const uint_t n, cost_t *cost[],
+template <typename CostRows>
+int _lapjv_dense(
+    const uint_t n, const CostRows &cost,
     int_t *x, int_t *y)
 {
     int ret;
@@ -334,4 +341,194 @@ int lapjv_internal(
     FREE(v);
     FREE(free_rows);
     return ret;
-}
\ No newline at end of file
+}
+
+/** Row access into a flat row-major float matrix, cost[i][j] reads data[i * stride + j].
+ */
+struct _flat_rows {
+    const float *data;
+    uint_t stride;
+    const float *operator[](uint_t i) const
+    {
+        return data + (size_t)i * stride;
+    }
+};
+
+int lapjv_internal(
+    const uint_t n, cost_t *cost[],
+    int_t *x, int_t *y)
+{
+    return _lapjv_dense(n, cost, x, y);
+}
+
+int lapjv_internal_flat(
+    const uint_t n, const float *cost, const uint_t stride,
+    int_t *x, int_t *y)
+{
+    _flat_rows rows = {cost, stride};
+    return _lapjv_dense(n, rows, x, y);
+}
+
+
+/** Shortest augmenting path solver for a rectangular n_rows x n_cols problem where every row
+ * may stay unassigned at cost thresh, see lapjv_rectangular() in lapjv.h.
+ *
+ * Each row owns a virtual "unassigned" column that only this row can reach, its potential is always 0,
+ * so it is handled as one extra candidate per row in the tree instead of as n_rows dense columns.
+ * A row parked on its virtual column can never be reached again by an alternating path,
+ * so it is final.
+ * Rows whose cheapest column is still free are assigned greedily first, as in the column reduction of JV,
+ * which leaves only the contested rows for the augmenting path search.
+ */
+int lapjv_rectangular(
+    const uint_t n_rows, const uint_t n_cols,
+    const float *cost, const uint_t stride, const float thresh,
+    int_t *x, int_t *y)
+{
+    cost_t *u, *v, *shortest;
+    int_t *path, *remaining, *tree_rows, *free_rows;
+    boolean *scanned;
+
+    for (uint_t i = 0; i < n_rows; i++)
+        x[i] = -1;
+    for (uint_t j = 0; j < n_cols; j++)
+        y[j] = -1;
+    if (n_rows == 0)
+        return 0;
+
+    NEW(u, cost_t, n_rows);
+    NEW(tree_rows, int_t, n_rows);
+    NEW(free_rows, int_t, n_rows);
+    // keep at least one element so that the column arrays are valid when n_cols is 0
+    NEW(v, cost_t, n_cols + 1);
+    NEW(shortest, cost_t, n_cols + 1);
+    NEW(path, int_t, n_cols + 1);
+    NEW(remaining, int_t, n_cols + 1);
+    NEW(scanned, boolean, n_cols + 1);
+    for (uint_t j = 0; j < n_cols; j++)
+        v[j] = 0;
+
+    // row reduction, u[i] is the cheapest way to serve row i, which keeps all reduced costs non-negative
+    uint_t n_free_rows = 0;
+    for (uint_t i = 0; i < n_rows; i++) {
+        const float *cost_i = cost + (size_t)i * stride;
+        cost_t min_cost = thresh;
+        int_t min_j = -1;
+        for (uint_t j = 0; j < n_cols; j++) {
+            if (cost_i[j] < min_cost) {
+                min_cost = cost_i[j];
+                min_j = j;
+            }
+        }
+        u[i] = min_cost;
+        if (min_j != -1 && y[min_j] == -1) {
+            x[i] = min_j;
+            y[min_j] = i;
+        } else {
+            free_rows[n_free_rows++] = i;
+        }
+    }
+
+    const cost_t inf = INFINITY;
+    for (uint_t f = 0; f < n_free_rows; f++) {
+        const int_t cur_row = free_rows[f];
+        uint_t n_remaining = n_cols;
+        uint_t n_tree_rows = 0;
+        for (uint_t k = 0; k < n_cols; k++) {
+            // reversed, so that ties go to the lower column index
+            remaining[k] = n_cols - k - 1;
+            shortest[k] = inf;
+            scanned[k] = FALSE;
+        }
+
+        cost_t min_val = 0;
+        cost_t dummy_cost = inf;
+        int_t dummy_row = -1;
+        int_t sink = -1;
+        int_t i = cur_row;
+        while (sink == -1) {
+            tree_rows[n_tree_rows++] = i;
+
+            // leaving row i unassigned
+            const cost_t d = min_val + thresh - u[i];
+            if (d < dummy_cost) {
+                dummy_cost = d;
+                dummy_row = i;
+            }
+
+            int_t index = -1;
+            cost_t lowest = inf;
+            const float *cost_i = cost + (size_t)i * stride;
+            for (uint_t k = 0; k < n_remaining; k++) {
+                const int_t j = remaining[k];
+                const float c = cost_i[j];
+                // a pair above thresh is never better than leaving both unassigned
+                if (c <= thresh) {
+                    const cost_t r = min_val + c - u[i] - v[j];
+                    if (r < shortest[j]) {
+                        path[j] = i;
+                        shortest[j] = r;
+                    }
+                }
+                if (shortest[j] < lowest || (shortest[j] == lowest && y[j] == -1)) {
+                    lowest = shortest[j];
+                    index = k;
+                }
+            }
+
+            // prefer a real free column over staying unassigned on a tie
+            if (index == -1 || dummy_cost < lowest ||
+                (dummy_cost == lowest && y[remaining[index]] != -1)) {
+                min_val = dummy_cost;
+                break;
+            }
+
+            min_val = lowest;
+            const int_t j = remaining[index];
+            scanned[j] = TRUE;
+            remaining[index] = remaining[--n_remaining];
+            if (y[j] == -1)
+                sink = j;
+            else
+                i = y[j];
+        }
+
+        // update potentials, every tree row except cur_row was reached through its assigned column
+        u[cur_row] += min_val;
+        for (uint_t k = 1; k < n_tree_rows; k++) {
+            const int_t r = tree_rows[k];
+            u[r] += min_val - shortest[x[r]];
+        }
+        for (uint_t j = 0; j < n_cols; j++) {
+            if (scanned[j])
+                v[j] -= min_val - shortest[j];
+        }
+
+        // augment along the alternating path
+        int_t j = sink;
+        if (sink == -1) {
+            i = dummy_row;
+            j = x[i];
+            x[i] = -1;
+            if (i == cur_row)
+                continue;
+        }
+        while (1) {
+            i = path[j];
+            y[j] = i;
+            SWAP_INDICES(j, x[i]);
+            if (i == cur_row)
+                break;
+        }
+    }
+
+    FREE(u);
+    FREE(tree_rows);
+    FREE(free_rows);
+    FREE(v);
+    FREE(shortest);
+    FREE(path);
+    FREE(remaining);
+    FREE(scanned);
+    return 0;
+}
@@ -41,9 +41,7 @@ namespace RedoxiTrack {
         assert_throw(m_frame_number <= frame_number, "frame number less than m frame number");
 
         int delta_frame_number = frame_number - m_frame_number;
-        for (auto p : targets) {
-            _motion_predict(delta_frame_number, p, true);
-        }
+        _motion_predict(delta_frame_number, targets, true);
 
         _update_frame_number(frame_number);
     }
@@ -53,16 +51,16 @@ namespace RedoxiTrack {
         auto& kf = n_single_kalman_target->get_kf();
         // assert_throw(n_single_kalman_target->m_can_be_update, "failed kalman target can not be update, please predict before update");
         if (!n_single_kalman_target->m_can_be_update) {
-            kf.statePost.copyTo(kf.statePre);
-            kf.errorCovPost.copyTo(kf.errorCovPre);
-            kf.processNoiseCov.at<float>(0, 0) = std::pow(1.0 / 20.0 * kf.statePost.at<float>(2, 0) * delta_frame_number, 2);
-            kf.processNoiseCov.at<float>(1, 1) = std::pow(1.0 / 20.0 * kf.statePost.at<float>(3, 0) * delta_frame_number, 2);
-            kf.processNoiseCov.at<float>(2, 2) = std::pow(1.0 / 20.0 * kf.statePost.at<float>(2, 0) * delta_frame_number, 2);
-            kf.processNoiseCov.at<float>(3, 3) = std::pow(1.0 / 20.0 * kf.statePost.at<float>(3, 0) * delta_frame_number, 2);
-            kf.processNoiseCov.at<float>(4, 4) = std::pow(1.0 / 160.0 * kf.statePost.at<float>(2, 0) * delta_frame_number, 2);
-            kf.processNoiseCov.at<float>(5, 5) = std::pow(1.0 / 160.0 * kf.statePost.at<float>(3, 0) * delta_frame_number, 2);
-            kf.processNoiseCov.at<float>(6, 6) = std::pow(1.0 / 160.0 * kf.statePost.at<float>(2, 0) * delta_frame_number, 2);
-            kf.processNoiseCov.at<float>(7, 7) = std::pow(1.0 / 160.0 * kf.statePost.at<float>(3, 0) * delta_frame_number, 2);
+            kf.state_pre = kf.state_post;
+            kf.error_cov_pre = kf.error_cov_post;
+            kf.process_noise_cov(0, 0) = std::pow(1.0 / 20.0 * kf.state_post(2) * delta_frame_number, 2);
+            kf.process_noise_cov(1, 1) = std::pow(1.0 / 20.0 * kf.state_post(3) * delta_frame_number, 2);
+            kf.process_noise_cov(2, 2) = std::pow(1.0 / 20.0 * kf.state_post(2) * delta_frame_number, 2);
+            kf.process_noise_cov(3, 3) = std::pow(1.0 / 20.0 * kf.state_post(3) * delta_frame_number, 2);
+            kf.process_noise_cov(4, 4) = std::pow(1.0 / 160.0 * kf.state_post(2) * delta_frame_number, 2);
+            kf.process_noise_cov(5, 5) = std::pow(1.0 / 160.0 * kf.state_post(3) * delta_frame_number, 2);
+            kf.process_noise_cov(6, 6) = std::pow(1.0 / 160.0 * kf.state_post(2) * delta_frame_number, 2);
+            kf.process_noise_cov(7, 7) = std::pow(1.0 / 160.0 * kf.state_post(3) * delta_frame_number, 2);
         }
         get_motion_prediction()->update(n_single_kalman_target->get_kf(), bbox);
         BBOX n_temp_bbox;
@@ -4,108 +4,95 @@
 #include "RedoxiTrack/tracker/BotsortMotionPrediction.h"
 
 namespace RedoxiTrack{
-    void BotsortMotionPrediction::init(cv::KalmanFilter &kf, const BBOX &bbox) {
+    void BotsortMotionPrediction::init(KalmanFilter &kf, const BBOX &bbox) {
         m_stateNum = 8;
         m_measureNum = 4;
-        m_update_measurement = cv::Mat::zeros(m_measureNum, 1, CV_32F);
         std::vector<float> n_xcycwh;
         _bbox2xcycwh(bbox, n_xcycwh);
-        m_update_measurement.at<float>(0, 0) = n_xcycwh[0];
-        m_update_measurement.at<float>(1, 0) = n_xcycwh[1];
-        m_update_measurement.at<float>(2, 0) = n_xcycwh[2];
-        m_update_measurement.at<float>(3, 0) = n_xcycwh[3];
+        m_update_measurement << n_xcycwh[0], n_xcycwh[1], n_xcycwh[2], n_xcycwh[3];
 
         // state space: xc(center x), yc(center y), w(width), h(height), vxc, vyc, vw, vh
-        kf = cv::KalmanFilter(m_stateNum, m_measureNum, 0);
+        kf = KalmanFilter();
         // A
-        kf.transitionMatrix = (cv::Mat_<float>(m_stateNum, m_stateNum) <<   1, 0, 0, 0, 1, 0, 0, 0,
-                                                                            0, 1, 0, 0, 0, 1, 0, 0,
-                                                                            0, 0, 1, 0, 0, 0, 1, 0,
-                                                                            0, 0, 0, 1, 0, 0, 0, 1,
-                                                                            0, 0, 0, 0, 1, 0, 0, 0,
-                                                                            0, 0, 0, 0, 0, 1, 0, 0,
-                                                                            0, 0, 0, 0, 0, 0, 1, 0,
-                                                                            0, 0, 0, 0, 0, 0, 0, 1);
+        kf.transition_matrix.setIdentity();
+        kf.transition_matrix.topRightCorner<4, 4>().setIdentity();
         // H
-        kf.measurementMatrix = (cv::Mat_<float>(m_measureNum, m_stateNum) <<1, 0, 0, 0, 0, 0, 0, 0,
-                                                                            0, 1, 0, 0, 0, 0, 0, 0,
-                                                                            0, 0, 1, 0, 0, 0, 0, 0,
-                                                                            0, 0, 0, 1, 0, 0, 0, 0);
+        kf.measurement_matrix.setIdentity();
         // posteriori error estimate covariance matrix (P(k)): P(k)=(I-K(k)*H)*P'(k)
-        kf.errorCovPost = (cv::Mat_<float>(m_stateNum, m_stateNum) <<   std::pow(2 * m_std_weight_position * n_xcycwh[2], 2), 0, 0, 0, 0, 0, 0, 0,
-                                                                        0, std::pow(2 * m_std_weight_position * n_xcycwh[3], 2), 0, 0, 0, 0, 0, 0,
-                                                                        0, 0, std::pow(2 * m_std_weight_position * n_xcycwh[2], 2), 0, 0, 0, 0, 0,
-                                                                        0, 0, 0, std::pow(2 * m_std_weight_position * n_xcycwh[3], 2), 0, 0, 0, 0,
-                                                                        0, 0, 0, 0, std::pow(10 * m_std_weight_velocity * n_xcycwh[2], 2), 0, 0, 0,
-                                                                        0, 0, 0, 0, 0, std::pow(10 * m_std_weight_velocity * n_xcycwh[3], 2), 0, 0,
-                                                                        0, 0, 0, 0, 0, 0, std::pow(10 * m_std_weight_velocity * n_xcycwh[2], 2), 0,
-                                                                        0, 0, 0, 0, 0, 0, 0, std::pow(10 * m_std_weight_velocity * n_xcycwh[3], 2));
-        kf.processNoiseCov = cv::Mat_<float>::zeros(m_stateNum, m_stateNum);
-        kf.measurementNoiseCov = cv::Mat_<float>::zeros(m_measureNum, m_measureNum);
+        kf.error_cov_post.setZero();
+        kf.error_cov_post.diagonal() << std::pow(2 * m_std_weight_position * n_xcycwh[2], 2),
+                                        std::pow(2 * m_std_weight_position * n_xcycwh[3], 2),
+                                        std::pow(2 * m_std_weight_position * n_xcycwh[2], 2),
+                                        std::pow(2 * m_std_weight_position * n_xcycwh[3], 2),
+                                        std::pow(10 * m_std_weight_velocity * n_xcycwh[2], 2),
+                                        std::pow(10 * m_std_weight_velocity * n_xcycwh[3], 2),
+                                        std::pow(10 * m_std_weight_velocity * n_xcycwh[2], 2),
+                                        std::pow(10 * m_std_weight_velocity * n_xcycwh[3], 2);
+        kf.process_noise_cov.setZero();
+        kf.measurement_noise_cov.setZero();
         // initialize state vector with bounding box in [xc,yc,w,h] style
-        kf.statePost.at<float>(0, 0) = n_xcycwh[0];
-        kf.statePost.at<float>(1, 0) = n_xcycwh[1];
-        kf.statePost.at<float>(2, 0) = n_xcycwh[2];
-        kf.statePost.at<float>(3, 0) = n_xcycwh[3];
+        kf.state_post.head<4>() = m_update_measurement;
     }
 
-    void BotsortMotionPrediction::predict(cv::KalmanFilter &kf, BBOX &output_bbox, int delta_frame_number, const bool flag) {
+    void BotsortMotionPrediction::predict(KalmanFilter &kf, BBOX &output_bbox, int delta_frame_number, const bool flag) {
+        _prepare_predict(kf, delta_frame_number, flag);
+        _state2bbox(kf.predict(), output_bbox);
+    }
+
+    void BotsortMotionPrediction::update(KalmanFilter &kf, const BBOX &bbox) {
+        _prepare_update(kf, bbox, m_update_measurement);
+        kf.correct(m_update_measurement);
+    }
+
+    void BotsortMotionPrediction::get_bbox_state(KalmanFilter &kf, BBOX &output_bbox) {
+        _state2bbox(kf.state_post, output_bbox);
+    }
+
+    void BotsortMotionPrediction::_prepare_predict(KalmanFilter &kf, int delta_frame_number, bool flag) {
         // init Q matrix using height
         //Uncertainty is related to the height of the bbox
-        kf.processNoiseCov.at<float>(0, 0) = std::pow(m_std_weight_position * kf.statePost.at<float>(2, 0) * delta_frame_number, 2);
-        kf.processNoiseCov.at<float>(1, 1) = std::pow(m_std_weight_position * kf.statePost.at<float>(3, 0) * delta_frame_number, 2);
-        kf.processNoiseCov.at<float>(2, 2) = std::pow(m_std_weight_position * kf.statePost.at<float>(2, 0) * delta_frame_number, 2);
-        kf.processNoiseCov.at<float>(3, 3) = std::pow(m_std_weight_position * kf.statePost.at<float>(3, 0) * delta_frame_number, 2);
-        kf.processNoiseCov.at<float>(4, 4) = std::pow(m_std_weight_velocity * kf.statePost.at<float>(2, 0) * delta_frame_number, 2);
-        kf.processNoiseCov.at<float>(5, 5) = std::pow(m_std_weight_velocity * kf.statePost.at<float>(3, 0) * delta_frame_number, 2);
-        kf.processNoiseCov.at<float>(6, 6) = std::pow(m_std_weight_velocity * kf.statePost.at<float>(2, 0) * delta_frame_number, 2);
-        kf.processNoiseCov.at<float>(7, 7) = std::pow(m_std_weight_velocity * kf.statePost.at<float>(3, 0) * delta_frame_number, 2);
+        kf.process_noise_cov(0, 0) = std::pow(m_std_weight_position * kf.state_post(2) * delta_frame_number, 2);
+        kf.process_noise_cov(1, 1) = std::pow(m_std_weight_position * kf.state_post(3) * delta_frame_number, 2);
+        kf.process_noise_cov(2, 2) = std::pow(m_std_weight_position * kf.state_post(2) * delta_frame_number, 2);
+        kf.process_noise_cov(3, 3) = std::pow(m_std_weight_position * kf.state_post(3) * delta_frame_number, 2);
+        kf.process_noise_cov(4, 4) = std::pow(m_std_weight_velocity * kf.state_post(2) * delta_frame_number, 2);
+        kf.process_noise_cov(5, 5) = std::pow(m_std_weight_velocity * kf.state_post(3) * delta_frame_number, 2);
+        kf.process_noise_cov(6, 6) = std::pow(m_std_weight_velocity * kf.state_post(2) * delta_frame_number, 2);
+        kf.process_noise_cov(7, 7) = std::pow(m_std_weight_velocity * kf.state_post(3) * delta_frame_number, 2);
         if (flag) {
-            kf.statePost.at<float>(6, 0) = 0;
-            kf.statePost.at<float>(7, 0) = 0;
+            kf.state_post(6) = 0;
+            kf.state_post(7) = 0;
         }
-
-        cv::Mat p = kf.predict();
-        _xcycwh2bbox(p.at<float>(0, 0), p.at<float>(1, 0),
-                          p.at<float>(2, 0), p.at<float>(3, 0),
-                          output_bbox);
     }
 
-    void BotsortMotionPrediction::update(cv::KalmanFilter &kf, const BBOX &bbox) {
-//        cv::Mat measurement = cv::Mat::zeros(m_measureNum, 1, CV_32F);
+    void BotsortMotionPrediction::_prepare_update(KalmanFilter &kf, const BBOX &bbox,
+                                                  KalmanFilter::MeasureVector &output_measurement) {
         // measurement
         std::vector<float> n_xcycwh;
         _bbox2xcycwh(bbox, n_xcycwh);
-        m_update_measurement.at<float>(0, 0) = n_xcycwh[0];
-        m_update_measurement.at<float>(1, 0) = n_xcycwh[1];
-        m_update_measurement.at<float>(2, 0) = n_xcycwh[2];
-        m_update_measurement.at<float>(3, 0) = n_xcycwh[3];
+        output_measurement << n_xcycwh[0], n_xcycwh[1], n_xcycwh[2], n_xcycwh[3];
         // init R matrix using height
-        kf.measurementNoiseCov.at<float>(0, 0) = std::pow(m_std_weight_position*kf.statePre.at<float>(2, 0), 2);
-        kf.measurementNoiseCov.at<float>(1, 1) = std::pow(m_std_weight_position*kf.statePre.at<float>(3, 0), 2);
-        kf.measurementNoiseCov.at<float>(2, 2) = std::pow(m_std_weight_position*kf.statePre.at<float>(2, 0), 2);
-        kf.measurementNoiseCov.at<float>(3, 3) = std::pow(m_std_weight_position*kf.statePre.at<float>(3, 0), 2);
-
-        // update
-        kf.correct(m_update_measurement);
+        kf.measurement_noise_cov(0, 0) = std::pow(m_std_weight_position*kf.state_pre(2), 2);
+        kf.measurement_noise_cov(1, 1) = std::pow(m_std_weight_position*kf.state_pre(3), 2);
+        kf.measurement_noise_cov(2, 2) = std::pow(m_std_weight_position*kf.state_pre(2), 2);
+        kf.measurement_noise_cov(3, 3) = std::pow(m_std_weight_position*kf.state_pre(3), 2);
     }
 
-    void BotsortMotionPrediction::get_bbox_state(cv::KalmanFilter &kf, BBOX &output_bbox) {
-        const cv::Mat &s = kf.statePost;
-        _xcycwh2bbox(s.at<float>(0, 0), s.at<float>(1, 0),
-                          s.at<float>(2, 0), s.at<float>(3, 0),
-                          output_bbox);
+    void BotsortMotionPrediction::_state2bbox(const KalmanFilter::StateVector &state, BBOX &output_bbox) const {
+        _xcycwh2bbox(state(0), state(1), state(2), state(3), output_bbox);
     }
 
-    void BotsortMotionPrediction::project_state2measurement(cv::KalmanFilter &kf, cv::Mat &output_mean,
-                                                            cv::Mat &output_covariance) const {
-        cv::Mat_<float> innovation_cov = (cv::Mat_<float>(m_measureNum, m_measureNum) <<   std::pow(m_std_weight_position*kf.statePre.at<float>(2, 0), 2), 0, 0, 0,
-                                                                                0, std::pow(m_std_weight_position*kf.statePre.at<float>(3, 0), 2), 0, 0,
-                                                                                0, 0, std::pow(m_std_weight_position*kf.statePre.at<float>(2, 0), 2), 0,
-                                                                                0, 0, 0, std::pow(m_std_weight_position*kf.statePre.at<float>(3, 0), 2));
+    void BotsortMotionPrediction::project_state2measurement(KalmanFilter &kf, KalmanFilter::MeasureVector &output_mean,
+                                                            KalmanFilter::MeasureMatrix &output_covariance) const {
+        KalmanFilter::MeasureMatrix innovation_cov = KalmanFilter::MeasureMatrix::Zero();
+        innovation_cov.diagonal() << std::pow(m_std_weight_position*kf.state_pre(2), 2),
+                                     std::pow(m_std_weight_position*kf.state_pre(3), 2),
+                                     std::pow(m_std_weight_position*kf.state_pre(2), 2),
+                                     std::pow(m_std_weight_position*kf.state_pre(3), 2);
 
-        output_mean = kf.measurementMatrix * kf.statePre;
-        output_covariance = kf.measurementMatrix * kf.errorCovPre * kf.measurementMatrix.t() + innovation_cov;
+        output_mean.noalias() = kf.measurement_matrix * kf.state_pre;
+        output_covariance.noalias() = kf.measurement_matrix * kf.error_cov_pre * kf.measurement_matrix.transpose();
+        output_covariance += innovation_cov;
     }
 
     void BotsortMotionPrediction::_bbox2xcycwh(const BBOX &bbox, std::vector<float> &output) {
@@ -3,11 +3,11 @@
 //
 #include "RedoxiTrack/tracker/BotsortTracker.h"
 #include <algorithm>
+#include <set>
+#include <tuple>
 #include "RedoxiTrack/utils/utility_functions.h"
 #define MAX_COST_MATRIX_NUM 9999
 
-#define DEBUG 1
-
 namespace RedoxiTrack{
     void BotsortTracker::init(const TrackerParam &param) {
         m_param = param.clone();
@@ -26,8 +26,16 @@ namespace RedoxiTrack{
         m_optical_flow_tracker->add_event_handler(m_optical_flow_handler);
         m_kalman_tracker->add_event_handler(m_kalman_handler);
 
+        m_use_appearance = p->m_use_reid_feature;
         m_feature_traits = std::make_shared<CosineFeature>();
+        if (m_use_appearance && !p->m_feature_projection_file.empty()) {
+            auto projection = std::make_shared<FeatureProjection>();
+            projection->load(p->m_feature_projection_file);
+            m_feature_traits->set_projection(projection);
+        }
         m_detection_comparision = std::make_shared<DefaultDetectionTraits>(this);
+        m_feature_gallery.init(p->m_gallery_size, p->m_gallery_max_tracks);
+        m_reid_index = FeatureIndex(p->m_reid_index_neighbors);
     }
 
     const TrackerParam *BotsortTracker::get_tracker_param() const {
@@ -51,9 +59,18 @@ namespace RedoxiTrack{
                                 const std::vector<DetectionPtr> &detections,
                                 int frame_number) {
         m_id2target.clear();
+        m_feature_gallery.clear();
+        m_long_lost_targets.clear();
+        m_reid_index.clear();
 
         _update_frame_number(frame_number);
 
+        // features enter the tracker in their projected form, see FeatureTraits::set_projection()
+        if (m_use_appearance) {
+            _project_features(detections, m_feature_traits.get());
+            _pack_features(detections, m_feature_traits.get());
+        }
+
         auto p_param = dynamic_cast<BotsortTrackerParam*>(m_param.get());
 
         std::vector<DetectionPtr> new_detections;
@@ -112,62 +129,26 @@ namespace RedoxiTrack{
         m_removed_targets.clear();
         // 重置m_tracked_targets
         m_tracked_targets.clear();
+        m_long_lost_targets.clear();
+        m_reid_index.clear();
+        m_feature_gallery.clear();
     }
 
     void BotsortTracker::track(const cv::Mat &img, const std::vector<DetectionPtr> &detections, int frame_number) {
         assert_throw(m_frame_number != INIT_TRACKING_FRAME, "m frame number is INIT_TRACKING_FRAME");
         assert_throw(m_frame_number <= frame_number, "m frame number less than frame number");
 
-        #if DEBUG
-        std::cout << "--------------------------------- frame id " << frame_number + 1 << " ---------------------------------" << std::endl;
-
-        std::cout << "1. self.tracked_stracks" << std::endl;
-        for (auto &p: m_tracked_targets) {
-            // auto& single_botsort_target = p.second;
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.second.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            // std::cout << std::endl;
-            // std::cout << p.second->get_feature() << std::endl;
+        // features enter the tracker in their projected form, see FeatureTraits::set_projection()
+        if (m_use_appearance) {
+            _project_features(detections, m_feature_traits.get());
+            _pack_features(detections, m_feature_traits.get());
         }
-        std::cout << "2. self.lost_stracks" << std::endl;
-        for (auto &p: m_lost_targets) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.second.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            // std::cout << std::endl;
-            // std::cout << single_botsort_target->get_feature() << std::endl;
-        }
-        std::cout << "3. self.removed_stracks" << std::endl;
-        for (auto &p: m_removed_targets) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.second.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            // std::cout << std::endl;
-            // std::cout << single_botsort_target->get_feature() << std::endl;
-        }
-        #endif
+
+        if (_is_tracing())
+            m_trace_sink->set_frame_number(frame_number);
+        _trace_targets(TraceSink::TrackedTargets, m_tracked_targets);
+        _trace_targets(TraceSink::LostTargets, m_lost_targets);
+        _trace_targets(TraceSink::RemovedTargets, m_removed_targets);
 
         std::vector<TrackTargetPtr> activated;
         std::vector<TrackTargetPtr> refind;
@@ -191,29 +172,15 @@ namespace RedoxiTrack{
                 detections_high.push_back(det);
             }
             else {
-                // low detection not update track object's feature
-                auto single_detection_ptr = dynamic_pointer_cast<SingleDetection>(det);
-                fVECTOR x;
-                single_detection_ptr->set_feature(x);
+                // low detection not update track object's feature, drop it, which releases its buffer.
+                // detections without a feature are skipped, e.g. in motion only mode
+                if (det->has_feature())
+                    dyncast_with_check<SingleDetection>(det.get())->set_feature(fVECTOR());
                 detections_low.push_back(det);
             }
         }
 
-        #if DEBUG
-        std::cout << "4. HIGH SCORE DETECTIONS" << std::endl;
-        for (auto &p: detections_high) {
-            auto& single_botsort_target = p;
-            std::cout << single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            // std::cout << std::endl;
-            // std::cout << single_botsort_target->get_feature() << std::endl;
-        }
-        #endif
+        _trace_detections(TraceSink::HighScoreDetections, detections_high);
 
         // Add newly detected tracklets to tracked_stracks
         std::vector<TrackTargetPtr> tracked_targets;  // targets not include lost None close targets
@@ -240,41 +207,11 @@ namespace RedoxiTrack{
             kalman_target_pool.push_back(single_botsort_target->m_kalman_target);
         }
 
-        #if DEBUG
-        std::cout << "5. unconfirmed" << std::endl;
-        for (auto &p: unconfirmed) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            // std::cout << std::endl;
-            // std::cout << single_botsort_target->get_feature() << std::endl;
-        }
-
-        std::cout << "6. strack_pool" << std::endl;
-        for (auto &p: target_pool) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            // std::cout << std::endl;
-            // std::cout << single_botsort_target->get_feature() << std::endl;
-        }
-        #endif
+        _trace_targets(TraceSink::Unconfirmed, unconfirmed);
+        _trace_targets(TraceSink::TargetPool, target_pool);
 
         // kalman target predict first
+        StageTimer::Scope predict_timer(m_stage_timer.get(), StageTimer::MotionPrediction);
         if (p_param->m_use_optical_before_track) {
             _motion_predict(img, target_pool, frame_number);
         }
@@ -290,61 +227,20 @@ namespace RedoxiTrack{
                 botsort_target->set_bbox(kalman_target->get_bbox());
             }
         }
+        predict_timer.stop();
         _update_frame_number(frame_number);
 
-        #if DEBUG
-        std::cout << "7. after multi_predict strack_pool" << std::endl;
-        for (auto &p: target_pool) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            std::cout << std::endl;
-            // std::cout << single_botsort_target->get_feature() << std::endl;
-        }
-        #endif
+        _trace_targets(TraceSink::TargetPoolPredicted, target_pool);
 
         std::vector<std::pair<int, int>> matched_pair;
         std::vector<int> unmatched_detection_now;
         std::vector<int> unmatched_detection_predict;
         _match_maha_distance(detections_high, target_pool, p_param->m_match_thresh, matched_pair, unmatched_detection_now, unmatched_detection_predict);
 
-        #if DEBUG
-        std::cout << "11. first matched" << std::endl;
-        for (auto& match : matched_pair) {
-            std::cout << match.first << "," << match.second << std::endl;
-        }
-        std::cout << "12. first u_track" << std::endl;
-        for (auto& match : unmatched_detection_predict) {
-            std::cout << match << ",";
-        }
-        std::cout << std::endl;
-        std::cout << "13. first u_detection" << std::endl;
-        for (auto& match : unmatched_detection_now) {
-            std::cout << match << ",";
-        }
-        std::cout << std::endl;
-
-        std::cout << "14. low score detections" << std::endl;
-        for (auto &p: detections_low) {
-            auto single_botsort_target = p;
-            std::cout << single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            // std::cout << std::endl;
-            // std::cout << single_botsort_target->get_feature() << std::endl;
-        }
-        #endif
+        _trace_matches(TraceSink::FirstMatched, matched_pair);
+        _trace_indices(TraceSink::FirstUnmatchedTrack, unmatched_detection_predict);
+        _trace_indices(TraceSink::FirstUnmatchedDetection, unmatched_detection_now);
+        _trace_detections(TraceSink::LowScoreDetections, detections_low);
 
         // update tracker state and traklet feature
         // update matched detection_now and detection_predict
@@ -365,22 +261,9 @@ namespace RedoxiTrack{
         std::vector<int> unmatched_iou_detection_predict;
         _match_iou_distance(detections_low, first_unmatched_track, 0.5, second_matched_pair, unmatched_iou_detection_now, unmatched_iou_detection_predict);
 
-        #if DEBUG
-        std::cout << "16. second matched" << std::endl;
-        for (auto& match : second_matched_pair) {
-            std::cout << match.first << "," << match.second << std::endl;
-        }
-        std::cout << "17. second u_track" << std::endl;
-        for (auto& match : unmatched_iou_detection_predict) {
-            std::cout << match << ",";
-        }
-        std::cout << std::endl;
-        std::cout << "18. second u_detection" << std::endl;
-        for (auto& match : unmatched_iou_detection_now) {
-            std::cout << match << ",";
-        }
-        std::cout << std::endl;
-        #endif
+        _trace_matches(TraceSink::SecondMatched, second_matched_pair);
+        _trace_indices(TraceSink::SecondUnmatchedTrack, unmatched_iou_detection_predict);
+        _trace_indices(TraceSink::SecondUnmatchedDetection, unmatched_iou_detection_now);
 
         // update matched track targets
         for (size_t i = 0; i < second_matched_pair.size(); i++) {
@@ -409,22 +292,9 @@ namespace RedoxiTrack{
         std::vector<int> unmatched_track_third;
         _match_maha_distance(unmatched_first_detections, unconfirmed, 0.7, matched_third_pair, unmatched_detection_third, unmatched_track_third);
 
-        #if DEBUG
-        std::cout << "22. third matched" << std::endl;
-        for (auto& match : matched_third_pair) {
-            std::cout << match.first << "," << match.second << std::endl;
-        }
-        std::cout << "23. third u_track" << std::endl;
-        for (auto& match : unmatched_track_third) {
-            std::cout << match << ",";
-        }
-        std::cout << std::endl;
-        std::cout << "24. third u_detection" << std::endl;
-        for (auto& match : unmatched_detection_third) {
-            std::cout << match << ",";
-        }
-        std::cout << std::endl;
-        #endif
+        _trace_matches(TraceSink::ThirdMatched, matched_third_pair);
+        _trace_indices(TraceSink::ThirdUnmatchedTrack, unmatched_track_third);
+        _trace_indices(TraceSink::ThirdUnmatchedDetection, unmatched_detection_third);
 
         // update matched track targets
         for (size_t i = 0; i < matched_third_pair.size(); i++) {
@@ -440,7 +310,10 @@ namespace RedoxiTrack{
                 removed.push_back(single_botsort_target);
         }
 
-        // STEP4 : init new tracker
+        // STEP4 : high score detections still unmatched take back long lost targets by appearance,
+        // the others start new targets
+        if (m_use_appearance && p_param->m_max_time_reid > 0)
+            _reidentify_long_lost(unmatched_first_detections, unmatched_detection_third, frame_number, activated, refind);
         for(auto p : unmatched_detection_third){
             if (unmatched_first_detections[p]->get_confidence() < p_param->m_new_track_thresh)
                 continue;
@@ -460,6 +333,8 @@ namespace RedoxiTrack{
         }
 
         // STEP5 : update state
+        if (m_use_appearance && p_param->m_max_time_reid > 0)
+            _update_long_lost(removed);
         for (auto & l : m_lost_targets) {
             if (m_frame_number - l.second->get_end_frame_number() > p_param->m_max_time_lost) {
                 l.second->set_path_state(TrackPathStateBitmask::Close);
@@ -468,68 +343,10 @@ namespace RedoxiTrack{
             }
         }
 
-        #if DEBUG
-        std::cout << "25. activated_starcks" << std::endl;
-        for (auto &p: activated) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            // std::cout << std::endl;
-            // std::cout << single_botsort_target->get_feature() << std::endl;
-        }
-        std::cout << "26. refind_stracks" << std::endl;
-        for (auto &p: refind) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            // std::cout << std::endl;
-            // std::cout << single_botsort_target->get_feature() << std::endl;
-        }
-        std::cout << "27. lost_stracks" << std::endl;
-        for (auto &p: lost) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            // std::cout << std::endl;
-            // std::cout << single_botsort_target->get_feature() << std::endl;
-        }
-        std::cout << "28. removed_stracks" << std::endl;
-        for (auto &p: removed) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            // std::cout << std::endl;
-            // std::cout << single_botsort_target->get_feature() << std::endl;
-        }
-        #endif
+        _trace_targets(TraceSink::Activated, activated);
+        _trace_targets(TraceSink::Refind, refind);
+        _trace_targets(TraceSink::Lost, lost);
+        _trace_targets(TraceSink::Removed, removed);
 
         // STEP6 : merge
         std::vector<int> del_id;
@@ -574,41 +391,10 @@ namespace RedoxiTrack{
             }
         }
 
-        # if DEBUG
-        std::cout << "29. before _remove_duplicate_targets m_tracked_targets" << std::endl;
-        for (auto &p: m_tracked_targets) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.second.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-        }
-        std::cout << "30. before _remove_duplicate_targets m_lost_targets" << std::endl;
-        for (auto &p: m_lost_targets) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.second.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-        }
-        #endif
+        _trace_targets(TraceSink::BeforeDedupTracked, m_tracked_targets);
+        _trace_targets(TraceSink::BeforeDedupLost, m_lost_targets);
         _remove_duplicate_targets();
-        #if DEBUG
-        std::cout << "31. after _remove_duplicate_targets m_lost_targets" << std::endl;
-        for (auto &p: m_lost_targets) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.second.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-        }
-        #endif
+        _trace_targets(TraceSink::AfterDedupLost, m_lost_targets);
         // 在remove targets调用完之后再加到m_removed_targets中
         _remove_targets(removed);
 
@@ -616,23 +402,7 @@ namespace RedoxiTrack{
             m_removed_targets[target->get_path_id()] = target;
         }
 
-        #if DEBUG
-        std::cout << "32. output" << std::endl;
-        for (auto &p: m_tracked_targets) {
-            auto single_botsort_target = dyncast_with_check<BotsortTrackTarget>(p.second.get());
-            std::cout <<single_botsort_target->get_path_id() << "," <<
-                        single_botsort_target->get_bbox().x << "," <<
-                        single_botsort_target->get_bbox().y << "," <<
-                        single_botsort_target->get_bbox().width << "," <<
-                        single_botsort_target->get_bbox().height << "," <<
-                        single_botsort_target->m_is_activated << std::endl;
-            // for (int i = 0; i < 128; i++) {
-            //     std::cout << single_botsort_target->get_feature()(i, 0) << ",";
-            // }
-            // std::cout << std::endl;
-            // std::cout << p.second->get_feature() << std::endl;
-        }
-        #endif
+        _trace_targets(TraceSink::Output, m_tracked_targets);
     }
 
     void BotsortTracker::track(const cv::Mat &img, int frame_number) {
@@ -676,13 +446,20 @@ namespace RedoxiTrack{
         _update_frame_number(frame_number);
     }
 
+    void BotsortTracker::submit_frame(const cv::Mat &img, int frame_number) {
+        // _motion_predict() joins it through m_optical_flow_tracker->track(), without it the flow is not used
+        auto p_param = dynamic_cast<BotsortTrackerParam*>(m_param.get());
+        if (!p_param->m_use_optical_before_track)
+            return;
+        m_optical_flow_tracker->set_thread_pool(m_thread_pool);
+        m_optical_flow_tracker->submit_frame(img, frame_number);
+    }
+
     void BotsortTracker::_motion_predict(const cv::Mat &img, std::vector<TrackTargetPtr> &target_pool,
                                          int frame_number) {
         assert_throw(m_frame_number != INIT_TRACKING_FRAME, "m frame number is INIT_TRACKING_FRAME");
         assert_throw(m_frame_number <= frame_number, "frame number less than m frame number");
 
-        auto p_param = dynamic_cast<BotsortTrackerParam*>(m_param.get());
-
         m_optical_flow_handler->clear();
         m_optical_flow_tracker->track(img, frame_number);
 
@@ -703,10 +480,8 @@ namespace RedoxiTrack{
             m_kalman_tracker->KalmanTracker::update_kalman(single_kalman_target, single_optical_target->get_bbox());
 
             single_botsort_target->set_bbox(single_kalman_target->get_bbox());
-            if (p_param->m_use_reid_feature) {
-                if (p->get_feature().size() != 0)
-                    _update_features(single_botsort_target, p->get_feature());
-            }
+            if (m_use_appearance && p->has_feature())
+                _update_features(single_botsort_target, p->get_feature());
 
         }
         m_kalman_tracker->pop_tracking_state();
@@ -718,7 +493,19 @@ namespace RedoxiTrack{
         fVECTOR new_feature;
         m_feature_traits->linear_combine(&new_feature, target->get_feature(), features,
                                          p->m_alpha_smooth_features,(1 - p->m_alpha_smooth_features));
-        target->set_feature(new_feature);
+        target->set_feature(new_feature);        _pack_feature(*target, *m_feature_traits, false);
+    }
+
+    void BotsortTracker::_update_gallery(const TrackTargetPtr &target, const Detection &source) {
+        if (m_feature_gallery.get_capacity() == 0 || !source.has_feature())
+            return;
+        if (auto packed = _get_packed_feature(source, *m_feature_traits)) {
+            m_feature_gallery.add(target->get_path_id(), *packed);
+            return;
+        }
+        fVECTOR x = source.feature_view();
+        m_feature_traits->normalize(x);
+        m_feature_gallery.add(target->get_path_id(), x);
     }
 
     void BotsortTracker::_bbox2xcycwh(const BBOX &bbox, cv::Mat &output) {
@@ -744,6 +531,9 @@ namespace RedoxiTrack{
         //     m_optical_flow_tracker->delete_target(single_botsort_target->m_kalman_target->get_path_id());
         // }
         m_id2target.erase(path_id);
+        m_long_lost_targets.erase(path_id);
+        m_reid_index.remove(path_id);
+        m_feature_gallery.remove(path_id);
     }
 
     void BotsortTracker::delete_all_targets() {
@@ -758,6 +548,21 @@ namespace RedoxiTrack{
             (*iter)->evt_target_created_before(this, event_data);
         }
 
+        // features are stored in the form compared by m_feature_traits, see _compute_appearance_distance().
+        // motion only targets keep none, so that snapshots do not copy them
+        if (!m_use_appearance) {
+            if (target->has_feature())
+                target->set_feature(fVECTOR());
+        }
+        else if (target->has_feature()) {
+            fVECTOR feature = target->get_feature();
+            m_feature_traits->project(feature);
+            m_feature_traits->normalize(feature);
+            target->set_feature(feature);
+            _pack_feature(*target, *m_feature_traits, false);
+            _update_gallery(target, *target);
+        }
+
         m_id2target[target->get_path_id()] = target;
         m_tracked_targets[target->get_path_id()] = target;
 
@@ -799,55 +604,34 @@ namespace RedoxiTrack{
                                               std::vector<std::pair<int, int>> &output_matched_pair,
                                               std::vector<int> &output_unmatched_source,
                                               std::vector<int> &output_unmatched_target) {
+        StageTimer::Scope cost_timer(m_stage_timer.get(), StageTimer::CostMatrix);
         // calculate iou distance
         size_t n_det_now = sources.size();
         size_t n_det_predict = targets.size();
-        std::vector<std::vector<float>> dist_matrix_iou(n_det_now, std::vector<float>(n_det_predict, 0));
-        std::vector<std::vector<int>> dist_matrix_iou_mask(n_det_now, std::vector<int>(n_det_predict, 0));
+        CostMatrix &dist_matrix_iou = m_iou_cost;
+        CostMatrix &dist_matrix_now2prev = m_match_cost;
 
         auto p_param = dynamic_cast<BotsortTrackerParam*>(m_param.get());
 
-        #if DEBUG
-        std::cout << "ious_dists" << std::endl;
-        #endif
-        for (size_t i = 0; i < sources.size(); i++) {
-            for (size_t j = 0; j < targets.size(); j++) {
-                auto bbox_after_predict = targets[j]->get_bbox();
-                auto bbox_now = sources[i]->get_bbox();
-                auto iou = compute_iou(bbox_now, bbox_after_predict);
-                dist_matrix_iou[i][j] = 1 - iou;
-                #if DEBUG
-                std::cout << dist_matrix_iou[i][j] << ",";
-                #endif
-                if (dist_matrix_iou[i][j] > p_param->m_proximity_thresh) {
-                    dist_matrix_iou_mask[i][j] = 1;
-                }
-            }
-            #if DEBUG
-            std::cout << std::endl;
-            #endif
-        }
-
-        // fuse confidence and iou
-        if (p_param->m_fuse_score)
-            _fuse_score(dist_matrix_iou, sources);
-
-        // calculate embedding distance
-        std::vector<std::vector<float>> dist_matrix_now2prev(n_det_now, std::vector<float>(n_det_predict, 0));
+        m_source_boxes.assign(sources);
+        m_target_boxes.assign(targets);
+        // pairs without overlap keep distance 1, which is also their final cost as long as
+        // m_proximity_thresh < 1 rules out matching them by appearance
+        bool use_candidates = p_param->m_proximity_thresh < 1 && _find_candidates();
+        _compute_iou_distance(use_candidates, dist_matrix_iou);
+        _trace_cost_matrix(TraceSink::FirstIouDistance, dist_matrix_iou);
 
         bool sources_targets_feature_empty = true;
         //judge targets sources has feature or not
-        if (p_param->m_use_reid_feature) {
+        if (m_use_appearance) {
             for (size_t i = 0; i < sources.size(); i++) {
-                auto feature = sources[i]->get_feature();
-                if(feature.size()!=0){
+                if (sources[i]->has_feature()) {
                     sources_targets_feature_empty = false;
                     break;
                 }
             }
             for (size_t i = 0; i < targets.size(); i++) {
-                auto feature = targets[i]->get_feature();
-                if(feature.size()!=0){
+                if (targets[i]->has_feature()) {
                     sources_targets_feature_empty = false;
                     break;
                 }
@@ -855,35 +639,71 @@ namespace RedoxiTrack{
         }
 
 
-        // no id feature, match by iou distance
+        // no id feature, match by iou distance, the iou matrix is used as is
+        const CostMatrix *final_cost = &dist_matrix_now2prev;
         if(sources_targets_feature_empty){
-            dist_matrix_now2prev = dist_matrix_iou;
+            // fuse confidence and iou
+            if (p_param->m_fuse_score)
+                _fuse_score(dist_matrix_iou, sources);
+            final_cost = &dist_matrix_iou;
         }
         else {
-            auto p_param = dynamic_cast<BotsortTrackerParam *>(m_param.get());
+            bool tracing = _is_tracing();
+            // pairs that are too far apart by iou are not matched by appearance, so the appearance distance
+            // is only computed for the pairs that pass the proximity gate, the others cost 1.
+            // this reads the iou distance before it is fused with the confidence
+            bool gated = p_param->m_proximity_thresh < 1;
+            if (gated) {
+                select_pairs(dist_matrix_iou, p_param->m_proximity_thresh, use_candidates ? &m_candidates : nullptr,
+                             m_gated_pairs);
+                dist_matrix_now2prev.assign(n_det_now, n_det_predict, 1.0f);
+            } else
+                dist_matrix_now2prev.resize(n_det_now, n_det_predict);
+
+            // calculate embedding distance, with the gate only the gated pairs are compared and traced
+            _compute_appearance_distance(*m_detection_comparision, sources, targets, gated ? &m_gated_pairs : nullptr,
+                                         m_appearance_cost);
+            const float appearance_thresh = p_param->m_appearance_thresh;
+            _parallel_rows(n_det_now, n_det_predict, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; i++) {
+                    float *cost_row = dist_matrix_now2prev.row(i);
+                    const float *appearance_row = m_appearance_cost.row(i);
+                    if (gated) {
+                        for (int k = m_gated_pairs.offsets[i]; k < m_gated_pairs.offsets[i + 1]; k++) {
+                            int j = m_gated_pairs.targets[k];
+                            cost_row[j] = appearance_row[j] > appearance_thresh ? 1.0f : appearance_row[j];
+                        }
+                    } else {
+                        for (size_t j = 0; j < n_det_predict; j++)
+                            cost_row[j] = appearance_row[j] > appearance_thresh ? 1.0f : appearance_row[j];
+                    }
+                }
+            });
+            if (tracing) {
+                for (size_t i = 0; i < n_det_now; i++) {
+                    size_t k_begin = gated ? m_gated_pairs.offsets[i] : 0;
+                    size_t k_end = gated ? m_gated_pairs.offsets[i + 1] : n_det_predict;
+                    for (size_t k = k_begin; k < k_end; k++) {
+                        size_t j = gated ? m_gated_pairs.targets[k] : k;
+                        m_trace_sink->record_cost(TraceSink::FirstAppearanceDistance, (int)i, (int)j,
+                                                  m_appearance_cost(i, j));
+                    }
+                }
+            }
 
-            #if DEBUG
-            std::cout << "cosine dists between strack_pool and HIGH SCORE DETECTIONS" << std::endl;
-            #endif
+            // fuse confidence and iou
+            if (p_param->m_fuse_score)
+                _fuse_score(dist_matrix_iou, sources);
 
             // get distance matrix by combine iou distance and cosine distance
-            for (size_t i = 0; i < sources.size(); i++) {
-                for (size_t j = 0; j < targets.size(); j++) {
-                    auto cosine_dis = m_detection_comparision->compute_detection_distance(targets[j].get(), sources[i].get());
-                    dist_matrix_now2prev[i][j] = cosine_dis > p_param->m_appearance_thresh? 1.0 : cosine_dis;
-                    if (dist_matrix_iou_mask[i][j] == 1) {
-                        dist_matrix_now2prev[i][j] = 1.0;
-                    }
-
-                    dist_matrix_now2prev[i][j] = min(dist_matrix_iou[i][j], dist_matrix_now2prev[i][j]);
-                    #if DEBUG
-                    std::cout << cosine_dis << ",";
-                    #endif
+            _parallel_rows(n_det_now, n_det_predict, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; i++) {
+                    const float *iou_row = dist_matrix_iou.row(i);
+                    float *cost_row = dist_matrix_now2prev.row(i);
+                    for (size_t j = 0; j < n_det_predict; j++)
+                        cost_row[j] = min(iou_row[j], cost_row[j]);
                 }
-                #if DEBUG
-                std::cout << std::endl;
-                #endif
-            }
+            });
 
             // python版本暂时没用到这个
             // // calculate maha distance
@@ -913,21 +733,16 @@ namespace RedoxiTrack{
             // }
         }
 
+        cost_timer.stop();
+
         // match
-        std::cout << "before lapjv match" << std::endl;
-        lapjv_match(dist_matrix_now2prev, n_det_now, n_det_predict, match_thresh,
-                        output_matched_pair,
-                        output_unmatched_source, output_unmatched_target);
-
-        #if DEBUG
-        std::cout << "feature dists" << std::endl;
-        for (size_t i = 0; i < sources.size(); i++) {
-            for (size_t j = 0; j < targets.size(); j++) {
-                std::cout << dist_matrix_now2prev[i][j] << ",";
-            }
-            std::cout << std::endl;
-        }
-        #endif
+        StageTimer::Scope assign_timer(m_stage_timer.get(), StageTimer::Assignment);
+        lapjv_match_sparse(*final_cost, match_thresh,
+                           output_matched_pair,
+                           output_unmatched_source, output_unmatched_target);
+        assign_timer.stop();
+
+        _trace_cost_matrix(TraceSink::FinalDistance, *final_cost);
     }
 
     void BotsortTracker::_match_iou_distance(const std::vector<DetectionPtr> &sources,
@@ -936,50 +751,105 @@ namespace RedoxiTrack{
                                              std::vector<std::pair<int, int>> &output_matched_pair,
                                              std::vector<int> &output_unmatched_source,
                                              std::vector<int> &output_unmatched_target) {
-        auto n_det_now = sources.size();
-        auto n_det_predict = targets.size();
-        std::vector<std::vector<float>> dist_matrix_now2prev(n_det_now, std::vector<float>(n_det_predict, 0));
-
-        #if DEBUG
-        std::cout << "15. ious_dists between u_track and low score detections" << std::endl;
-        #endif
-        for (size_t i = 0; i < sources.size(); i++) {
-            for (size_t j = 0; j < targets.size(); j++) {
-                auto bbox_after_predict = targets[j]->get_bbox();
-                auto bbox_now = sources[i]->get_bbox();
-                auto iou = compute_iou(bbox_now, bbox_after_predict);
-                dist_matrix_now2prev[i][j] = 1 - iou;
-                #if DEBUG
-                std::cout << dist_matrix_now2prev[i][j] << ",";
-                #endif
-            }
-            #if DEBUG
-            std::cout << std::endl;
-            #endif
+        StageTimer::Scope cost_timer(m_stage_timer.get(), StageTimer::CostMatrix);
+        CostMatrix &dist_matrix_now2prev = m_match_cost;
+
+        m_source_boxes.assign(sources);
+        m_target_boxes.assign(targets);
+        _compute_iou_distance(_find_candidates(), dist_matrix_now2prev);
+        _trace_cost_matrix(TraceSink::SecondIouDistance, dist_matrix_now2prev);
+        cost_timer.stop();
+
+        StageTimer::Scope assign_timer(m_stage_timer.get(), StageTimer::Assignment);
+        lapjv_match_sparse(dist_matrix_now2prev, match_thresh, output_matched_pair,
+                           output_unmatched_source, output_unmatched_target);
+    }
+
+    bool BotsortTracker::_find_candidates() {
+        auto p_param = dynamic_cast<BotsortTrackerParam*>(m_param.get());
+        size_t n_pairs = m_source_boxes.size() * m_target_boxes.size();
+        if (!p_param->m_use_spatial_index || n_pairs == 0 || n_pairs < (size_t)std::max(p_param->m_spatial_index_min_pairs, 0))
+            return false;
+        m_spatial_grid.build(m_target_boxes);
+        m_spatial_grid.query(m_source_boxes, p_param->m_spatial_index_radius, m_candidates);
+        return true;
+    }
+
+    void BotsortTracker::_compute_iou_distance(bool use_candidates, CostMatrix &output) {
+        if (use_candidates) {
+            compute_pairwise_iou(m_source_boxes, m_target_boxes, m_candidates, output, true);
+            return;
         }
-        lapjv_match(dist_matrix_now2prev, n_det_now, n_det_predict, match_thresh, output_matched_pair,
-                        output_unmatched_source, output_unmatched_target);
+        output.resize(m_source_boxes.size(), m_target_boxes.size());
+        _parallel_rows(m_source_boxes.size(), m_target_boxes.size(), [&](size_t first, size_t last) {
+            compute_pairwise_iou_rows(m_source_boxes, first, last, m_target_boxes, output.data(), output.stride(),
+                                      true);
+        });
     }
 
-    void BotsortTracker::_fuse_score(std::vector<std::vector<float>>& dist_matrix_iou,
+    void BotsortTracker::_fuse_score(CostMatrix &dist_matrix_iou,
                                     const std::vector<DetectionPtr> &detections) {
-        if (dist_matrix_iou.size() == 0) return;
-        #if DEBUG
-        std::cout << "fuse_score ious_dists" << std::endl;
-        #endif
-        for (size_t i = 0; i < dist_matrix_iou.size(); i++) {
-            for (size_t j = 0; j < dist_matrix_iou[0].size(); j++) {
-                dist_matrix_iou[i][j] = 1 - (1 - dist_matrix_iou[i][j]) * detections[i]->get_confidence();
-                #if DEBUG
-                std::cout << dist_matrix_iou[i][j] << ",";
-                #endif
+        if (dist_matrix_iou.empty()) return;
+        const int cols = dist_matrix_iou.cols();
+        _parallel_rows(dist_matrix_iou.rows(), cols, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                float *iou_row = dist_matrix_iou.row(i);
+                float confidence = detections[i]->get_confidence();
+                for (int j = 0; j < cols; j++) {
+                    iou_row[j] = 1 - (1 - iou_row[j]) * confidence;
+                }
             }
-            #if DEBUG
-            std::cout << std::endl;
-            #endif
+        });
+        _trace_cost_matrix(TraceSink::FuseScoreDistance, dist_matrix_iou);
+    }
+
+    void BotsortTracker::_trace_targets(int checkpoint, const std::map<int, TrackTargetPtr> &targets) {
+        if (!_is_tracing())
+            return;
+        for (auto &p: targets) {
+            auto target = dynamic_cast<BotsortTrackTarget *>(p.second.get());
+            m_trace_sink->record_target(checkpoint, p.first, p.second->get_bbox(), target ? target->m_is_activated : 0);
+        }
+    }
+
+    void BotsortTracker::_trace_targets(int checkpoint, const std::vector<TrackTargetPtr> &targets) {
+        if (!_is_tracing())
+            return;
+        for (auto &p: targets) {
+            auto target = dynamic_cast<BotsortTrackTarget *>(p.get());
+            m_trace_sink->record_target(checkpoint, p->get_path_id(), p->get_bbox(), target ? target->m_is_activated : 0);
         }
     }
 
+    void BotsortTracker::_trace_detections(int checkpoint, const std::vector<DetectionPtr> &detections) {
+        if (!_is_tracing())
+            return;
+        for (size_t i = 0; i < detections.size(); i++)
+            m_trace_sink->record_detection(checkpoint, (int)i, detections[i]->get_bbox(), detections[i]->get_confidence());
+    }
+
+    void BotsortTracker::_trace_matches(int checkpoint, const std::vector<std::pair<int, int>> &matched_pair) {
+        if (!_is_tracing())
+            return;
+        for (auto &p: matched_pair)
+            m_trace_sink->record_match(checkpoint, p.first, p.second);
+    }
+
+    void BotsortTracker::_trace_indices(int checkpoint, const std::vector<int> &indices) {
+        if (!_is_tracing())
+            return;
+        for (auto idx: indices)
+            m_trace_sink->record_index(checkpoint, idx);
+    }
+
+    void BotsortTracker::_trace_cost_matrix(int checkpoint, const CostMatrix &cost_matrix) {
+        if (!_is_tracing())
+            return;
+        for (int i = 0; i < cost_matrix.rows(); i++)
+            for (int j = 0; j < cost_matrix.cols(); j++)
+                m_trace_sink->record_cost(checkpoint, i, j, cost_matrix(i, j));
+    }
+
     void BotsortTracker::_remove_duplicate_targets() {
         std::vector<TrackTargetPtr> targetsa;
         std::vector<TrackTargetPtr> targetsb;
@@ -998,15 +868,16 @@ namespace RedoxiTrack{
         // calculate iou distance
         auto n_a = targetsa.size();
         auto n_b = targetsb.size();
-        std::vector<std::vector<float>> dist_matrix_iou(n_a, std::vector<float>(n_b, 0));
+        CostMatrix &dist_matrix_iou = m_iou_cost;
+        m_source_boxes.assign(targetsa);
+        m_target_boxes.assign(targetsb);
+        // duplicates overlap by definition, the other pairs are left at distance 1
+        _compute_iou_distance(_find_candidates(), dist_matrix_iou);
 
         for (size_t i = 0; i < n_a; i++) {
+            const float *iou_row = dist_matrix_iou.row(i);
             for (size_t j = 0; j < n_b; j++) {
-                auto bbox_a = targetsa[i]->get_bbox();
-                auto bbox_b = targetsb[j]->get_bbox();
-                auto iou = compute_iou(bbox_a, bbox_b);
-                dist_matrix_iou[i][j] = 1 - iou;
-                if (dist_matrix_iou[i][j] < 0.15) {
+                if (iou_row[j] < 0.15) {
                     auto timea = targetsa[i]->get_end_frame_number() - targetsa[i]->get_start_frame_number();
                     auto timeb = targetsb[j]->get_end_frame_number() - targetsb[j]->get_start_frame_number();
 
@@ -1051,6 +922,13 @@ namespace RedoxiTrack{
         }
     }
 
+    void BotsortTracker::_compute_feature_distance(const Detection *const *a, size_t size_a, const Detection *const *b,
+                                                   size_t size_b, const CandidatePairs *candidates, CostMatrix &output) {
+        auto p_param = dynamic_cast<BotsortTrackerParam*>(m_param.get());
+        _compute_target_feature_distance(*m_feature_traits, &m_feature_gallery, p_param->m_gallery_query_mode, a, size_a,
+                                         b, size_b, candidates, output);
+    }
+
     void BotsortTracker::_remove_targets(vector<TrackTargetPtr>& removed) {
         std::vector<int> delete_id;
         std::vector<int> kalman_delete_id;
@@ -1082,6 +960,7 @@ namespace RedoxiTrack{
             }
             m_id2target.erase(p);
             m_removed_targets.erase(p);
+            m_feature_gallery.remove(p);
 
             for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
                 (*iter)->evt_target_closed_after(this, event_data);
@@ -1096,6 +975,146 @@ namespace RedoxiTrack{
         }
     }
 
+    void BotsortTracker::_update_long_lost(std::vector<TrackTargetPtr> &removed) {
+        auto p_param = dynamic_cast<BotsortTrackerParam*>(m_param.get());
+
+        std::vector<int> expired;
+        for (auto &l : m_long_lost_targets) {
+            if (m_frame_number - l.second->get_end_frame_number() > p_param->m_max_time_lost + p_param->m_max_time_reid)
+                expired.push_back(l.first);
+        }
+        for (int tid : expired) {
+            auto target = m_long_lost_targets[tid];
+            target->set_path_state(TrackPathStateBitmask::Close);
+            dynamic_cast<BotsortTrackTarget*>(target.get())->m_kalman_target->set_path_state(TrackPathStateBitmask::Close);
+            removed.push_back(target);
+            m_long_lost_targets.erase(tid);
+            m_reid_index.remove(tid);
+        }
+
+        // lost targets without feature can not be re-identified and are closed as usual
+        std::vector<int> long_lost;
+        for (auto &l : m_lost_targets) {
+            if (m_frame_number - l.second->get_end_frame_number() > p_param->m_max_time_lost && l.second->has_feature())
+                long_lost.push_back(l.first);
+        }
+        for (int tid : long_lost) {
+            auto target = m_lost_targets[tid];
+            fVECTOR feature = target->get_feature();
+            feature.normalize();
+            m_reid_index.add(tid, feature);
+            m_long_lost_targets[tid] = target;
+            m_lost_targets.erase(tid);
+            _detach_motion_targets(target);
+        }
+    }
+
+    void BotsortTracker::_detach_motion_targets(const TrackTargetPtr &target) {
+        auto botsort_target = dyncast_with_check<BotsortTrackTarget>(target.get());
+        m_kalman_tracker->delete_target(botsort_target->m_kalman_target->get_path_id());
+        m_optical_flow_tracker->delete_target(botsort_target->m_optical_target->get_path_id());
+    }
+
+    void BotsortTracker::_attach_motion_targets(const TrackTargetPtr &target) {
+        auto botsort_target = dyncast_with_check<BotsortTrackTarget>(target.get());
+        m_kalman_tracker->add_target(botsort_target->m_kalman_target);
+        m_optical_flow_tracker->add_target(botsort_target->m_optical_target);
+    }
+
+    void BotsortTracker::_reidentify_long_lost(const std::vector<DetectionPtr> &detections, std::vector<int> &unmatched,
+                                               int frame_number, std::vector<TrackTargetPtr> &activated,
+                                               std::vector<TrackTargetPtr> &refind) {
+        if (m_long_lost_targets.empty() || unmatched.empty())
+            return;
+        auto p_param = dynamic_cast<BotsortTrackerParam*>(m_param.get());
+        // the index compares float features like CosineFeature, other comparisons go through all long lost targets,
+        // which also compares packed features by their packed form
+        PackedFeatures::Precision precision;
+        bool use_index = dynamic_cast<DefaultDetectionTraits*>(m_detection_comparision.get()) &&
+                         dynamic_cast<CosineFeature*>(m_feature_traits.get()) &&
+                         !m_feature_traits->get_packed_precision(precision);
+
+        // (distance, detection, path id) of the pairs close enough, matched greedily from the closest
+        std::vector<std::tuple<float, int, int>> pairs;
+        std::vector<int> queries;
+        for (int k : unmatched) {
+            if (detections[k]->get_confidence() >= p_param->m_new_track_thresh && detections[k]->has_feature())
+                queries.push_back(k);
+        }
+        if (use_index) {
+            std::vector<std::pair<float, int>> found;
+            fVECTOR query;
+            for (int k : queries) {
+                query = detections[k]->feature_view();
+                query.normalize();
+                m_reid_index.search(query, p_param->m_reid_num_neighbors, p_param->m_reid_index_ef, found);
+                for (auto &f : found) {
+                    if (f.first <= p_param->m_reid_thresh)
+                        pairs.emplace_back(f.first, k, f.second);
+                }
+            }
+        }
+        else if (!queries.empty()) {
+            // all queries against all long lost targets in one batch
+            m_source_ptrs.resize(queries.size());
+            for (size_t i = 0; i < queries.size(); i++)
+                m_source_ptrs[i] = detections[queries[i]].get();
+            std::vector<int> path_ids;
+            m_target_ptrs.clear();
+            for (auto &t : m_long_lost_targets) {
+                path_ids.push_back(t.first);
+                m_target_ptrs.push_back(t.second.get());
+            }
+            m_detection_comparision->compute_distance_matrix(m_source_ptrs.data(), m_source_ptrs.size(),
+                                                             m_target_ptrs.data(), m_target_ptrs.size(),
+                                                             m_appearance_cost);
+            for (size_t i = 0; i < queries.size(); i++) {
+                const float *row = m_appearance_cost.row(i);
+                for (size_t j = 0; j < path_ids.size(); j++) {
+                    if (row[j] <= p_param->m_reid_thresh)
+                        pairs.emplace_back(row[j], queries[i], path_ids[j]);
+                }
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+
+        std::set<int> matched;
+        for (auto &p : pairs) {
+            int k = std::get<1>(p);
+            int tid = std::get<2>(p);
+            if (matched.count(k) != 0 || m_long_lost_targets.count(tid) == 0)
+                continue;
+            TrackTargetPtr target = m_long_lost_targets[tid];
+            m_long_lost_targets.erase(tid);
+            m_reid_index.remove(tid);
+
+            // the motion state is too old to be corrected, restart it at the detection,
+            // as if it had been predicted there
+            auto botsort_target = dyncast_with_check<BotsortTrackTarget>(target.get());
+            auto kalman_target = dyncast_with_check<KalmanTrackTarget>(botsort_target->m_kalman_target.get());
+            auto &kf = kalman_target->get_kf();
+            m_kalman_tracker->get_motion_prediction()->init(kf, detections[k]->get_bbox());
+            kf.state_pre = kf.state_post;
+            kf.error_cov_pre = kf.error_cov_post;
+            kalman_target->m_can_be_update = true;
+            _attach_motion_targets(target);
+            _update_target(target, detections[k], frame_number, true, activated, refind);
+            matched.insert(k);
+
+            // rejected by an event handler, the target stays long lost
+            if (target->get_path_state() != TrackPathStateBitmask::Open) {
+                fVECTOR feature = target->get_feature();
+                feature.normalize();
+                m_reid_index.add(tid, feature);
+                m_long_lost_targets[tid] = target;
+                _detach_motion_targets(target);
+            }
+        }
+
+        auto is_matched = [&](int k) { return matched.count(k) != 0; };
+        unmatched.erase(std::remove_if(unmatched.begin(), unmatched.end(), is_matched), unmatched.end());
+    }
+
     void BotsortTracker::_update_target(TrackTargetPtr &botsort_target_ptr, const DetectionPtr& det, const int &frame_number, bool add_refind,
                                         std::vector<TrackTargetPtr>& activated, std::vector<TrackTargetPtr>& refind) {
         // type conversion
@@ -1141,10 +1160,9 @@ namespace RedoxiTrack{
             single_botsort_target->m_is_activated = true;
             single_kalman_target->set_end_frame_number(frame_number);
 
-            auto p_param = dynamic_cast<BotsortTrackerParam*>(m_param.get());
-            if (p_param->m_use_reid_feature) {
-                if (single_detection->get_feature().size() != 0)
-                    _update_features(single_botsort_target, single_detection->get_feature());
+            if (m_use_appearance && single_detection->has_feature()) {
+                _update_features(single_botsort_target, single_detection->get_feature());
+                _update_gallery(single_botsort_target, *single_detection);
             }
 
             //optical tracker update
@@ -1175,6 +1193,18 @@ namespace RedoxiTrack{
         m_kalman_tracker->push_tracking_state();
     }
 
+    void BotsortTracker::_tracking_state_fill(TrackerTrackingState &state) {
+        if (m_use_appearance) {
+            TrackerBase::_tracking_state_fill(state);
+            return;
+        }
+        state.m_id2target = m_id2target;
+        state.m_id2target_clone.clear();
+        for (auto &p : m_id2target)
+            state.m_id2target_clone[p.first] = dynamic_pointer_cast<TrackTarget>(p.second->clone(false));
+        state.m_frame_number = m_frame_number;
+    }
+
     void BotsortTracker::pop_tracking_state(bool apply) {
         assert_throw(m_state_stack.size()>0, "failed pop tracking state, m_state_stack is empty");
         auto x = m_state_stack.back();
@@ -1229,6 +1259,9 @@ namespace RedoxiTrack{
     }
 
     void BotsortTracker::set_feature_traits(const FeatureTraitsPtr& p) {
+        // the projection configured by the param stays in effect
+        if (m_feature_traits && !p->get_projection())
+            p->set_projection(m_feature_traits->get_projection());
         m_feature_traits = p;
     }
 
@@ -1242,4 +1275,17 @@ namespace RedoxiTrack{
 
     BotsortTracker::DefaultDetectionTraits::DefaultDetectionTraits(BotsortTracker *p): m_tracker(p) {
     }
+
+    void BotsortTracker::DefaultDetectionTraits::compute_distance_matrix(const Detection *const *a, size_t size_a,
+                                                                         const Detection *const *b, size_t size_b,
+                                                                         CostMatrix &output) {
+        m_tracker->_compute_feature_distance(a, size_a, b, size_b, nullptr, output);
+    }
+
+    void BotsortTracker::DefaultDetectionTraits::compute_distance_matrix(const Detection *const *a, size_t size_a,
+                                                                         const Detection *const *b, size_t size_b,
+                                                                         const CandidatePairs &candidates,
+                                                                         CostMatrix &output) {
+        m_tracker->_compute_feature_distance(a, size_a, b, size_b, &candidates, output);
+    }
 }
\ No newline at end of file
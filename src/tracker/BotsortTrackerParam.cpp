@@ -14,15 +14,27 @@ namespace RedoxiTrack{
             m->m_new_track_thresh = m_new_track_thresh;
             m->m_keep_track_buffer = m_keep_track_buffer;
             m->m_max_time_lost = m_max_time_lost;
+            m->m_max_time_reid = m_max_time_reid;
+            m->m_reid_thresh = m_reid_thresh;
+            m->m_reid_index_neighbors = m_reid_index_neighbors;
+            m->m_reid_index_ef = m_reid_index_ef;
+            m->m_reid_num_neighbors = m_reid_num_neighbors;
             m->m_match_thresh = m_match_thresh;
             m->m_aspect_ratio_thresh = m_aspect_ratio_thresh;
             m->m_min_box_area = m_min_box_area;
             m->m_proximity_thresh = m_proximity_thresh;
             m->m_appearance_thresh = m_appearance_thresh;
             m->m_alpha_smooth_features = m_alpha_smooth_features;
+            m->m_feature_projection_file = m_feature_projection_file;
+            m->m_gallery_size = m_gallery_size;
+            m->m_gallery_max_tracks = m_gallery_max_tracks;
+            m->m_gallery_query_mode = m_gallery_query_mode;
             m->m_use_optical_before_track = m_use_optical_before_track;
             m->m_fuse_score = m_fuse_score;
             m->m_use_reid_feature = m_use_reid_feature;
+            m->m_use_spatial_index = m_use_spatial_index;
+            m->m_spatial_index_radius = m_spatial_index_radius;
+            m->m_spatial_index_min_pairs = m_spatial_index_min_pairs;
             m_optical_param.copy_to(m->m_optical_param);
             m_kalman_param.copy_to(m->m_kalman_param);
         }
@@ -4,104 +4,98 @@
 #include "RedoxiTrack/tracker/DeepSortMotionPrediction.h"
 
 namespace RedoxiTrack{
-    void DeepSortMotionPrediction::init(cv::KalmanFilter &kf, const BBOX &bbox) {
+    void DeepSortMotionPrediction::init(KalmanFilter &kf, const BBOX &bbox) {
         m_stateNum = 8;
         m_measureNum = 4;
-        m_update_measurement = cv::Mat::zeros(m_measureNum, 1, CV_32F);
+        m_update_measurement.setZero();
         // state space: x, y, a(aspect ratio), h(height), vx, vy, va, vh
-        kf = cv::KalmanFilter(m_stateNum, m_measureNum, 0);
+        kf = KalmanFilter();
         std::vector<float> n_xyah;
         _bbox2xyah(bbox, n_xyah);
 
-        kf.transitionMatrix = (cv::Mat_<float>(m_stateNum, m_stateNum) <<   1, 0, 0, 0, 1, 0, 0, 0,
-                                                                            0, 1, 0, 0, 0, 1, 0, 0,
-                                                                            0, 0, 1, 0, 0, 0, 1, 0,
-                                                                            0, 0, 0, 1, 0, 0, 0, 1,
-                                                                            0, 0, 0, 0, 1, 0, 0, 0,
-                                                                            0, 0, 0, 0, 0, 1, 0, 0,
-                                                                            0, 0, 0, 0, 0, 0, 1, 0,
-                                                                            0, 0, 0, 0, 0, 0, 0, 1);
-
-        kf.measurementMatrix = (cv::Mat_<float>(m_measureNum, m_stateNum) <<1, 0, 0, 0, 0, 0, 0, 0,
-                                                                            0, 1, 0, 0, 0, 0, 0, 0,
-                                                                            0, 0, 1, 0, 0, 0, 0, 0,
-                                                                            0, 0, 0, 1, 0, 0, 0, 0);
-
-        kf.errorCovPost = (cv::Mat_<float>(m_stateNum, m_stateNum) <<   std::pow(2*m_std_weight_position*n_xyah[3], 2), 0, 0, 0, 0, 0, 0, 0,
-                                                                        0, std::pow(2*m_std_weight_position*n_xyah[3], 2), 0, 0, 0, 0, 0, 0,
-                                                                        0, 0, 1, 0, 0, 0, 0, 0,
-                                                                        0, 0, 0, std::pow(2*m_std_weight_position*n_xyah[3], 2), 0, 0, 0, 0,
-                                                                        0, 0, 0, 0, std::pow(10*m_std_weight_velocity*n_xyah[3], 2), 0, 0, 0,
-                                                                        0, 0, 0, 0, 0, std::pow(10*m_std_weight_velocity*n_xyah[3], 2), 0, 0,
-                                                                        0, 0, 0, 0, 0, 0, std::pow(1e-5, 2), 0,
-                                                                        0, 0, 0, 0, 0, 0, 0, std::pow(10*m_std_weight_velocity*n_xyah[3], 2));
-        kf.processNoiseCov = cv::Mat_<float>::zeros(m_stateNum, m_stateNum);
-        kf.measurementNoiseCov = cv::Mat_<float>::zeros(m_measureNum, m_measureNum);
+        kf.transition_matrix.setIdentity();
+        kf.transition_matrix.topRightCorner<4, 4>().setIdentity();
+
+        kf.measurement_matrix.setIdentity();
+
+        kf.error_cov_post.setZero();
+        kf.error_cov_post.diagonal() << std::pow(2*m_std_weight_position*n_xyah[3], 2),
+                                        std::pow(2*m_std_weight_position*n_xyah[3], 2),
+                                        1,
+                                        std::pow(2*m_std_weight_position*n_xyah[3], 2),
+                                        std::pow(10*m_std_weight_velocity*n_xyah[3], 2),
+                                        std::pow(10*m_std_weight_velocity*n_xyah[3], 2),
+                                        std::pow(1e-5, 2),
+                                        std::pow(10*m_std_weight_velocity*n_xyah[3], 2);
+        kf.process_noise_cov.setZero();
+        kf.measurement_noise_cov.setZero();
         // initialize state vector with bounding box in [x,y,a,h] styl
-        kf.statePost.at<float>(0, 0) = n_xyah[0];
-        kf.statePost.at<float>(1, 0) = n_xyah[1];
-        kf.statePost.at<float>(2, 0) = n_xyah[2];
-        kf.statePost.at<float>(3, 0) = n_xyah[3];
+        kf.state_post(0) = n_xyah[0];
+        kf.state_post(1) = n_xyah[1];
+        kf.state_post(2) = n_xyah[2];
+        kf.state_post(3) = n_xyah[3];
     }
 
-    void DeepSortMotionPrediction::predict(cv::KalmanFilter &kf, BBOX &output_bbox, int delta_frame_number, const bool flag) {
+    void DeepSortMotionPrediction::predict(KalmanFilter &kf, BBOX &output_bbox, int delta_frame_number, const bool flag) {
+        _prepare_predict(kf, delta_frame_number, flag);
+        _state2bbox(kf.predict(), output_bbox);
+    }
+
+    void DeepSortMotionPrediction::update(KalmanFilter &kf, const BBOX &bbox) {
+        _prepare_update(kf, bbox, m_update_measurement);
+        kf.correct(m_update_measurement);
+    }
+
+    void DeepSortMotionPrediction::get_bbox_state(KalmanFilter &kf, BBOX &output_bbox) {
+        _state2bbox(kf.state_post, output_bbox);
+    }
+
+    void DeepSortMotionPrediction::_prepare_predict(KalmanFilter &kf, int delta_frame_number, bool flag) {
         // init Q matrix using height
         //Uncertainty is related to the height of the bbox
         //reference to deepsort code:https://github.com/ifzhang/FairMOT/blob/master/src/lib/tracking_utils/kalman_filter.py
-        auto pose_cov = m_std_weight_position*kf.statePost.at<float>(3, 0) * delta_frame_number;
-        auto velocity_cov = m_std_weight_velocity*kf.statePost.at<float>(3, 0) * delta_frame_number;
-        kf.processNoiseCov.at<float>(0, 0) = std::pow(pose_cov, 2);
-        kf.processNoiseCov.at<float>(1, 1) = std::pow(pose_cov, 2);
-        kf.processNoiseCov.at<float>(2, 2) = 1;
-        kf.processNoiseCov.at<float>(3, 3) = std::pow(pose_cov, 2);
-        kf.processNoiseCov.at<float>(4, 4) = std::pow(velocity_cov, 2);
-        kf.processNoiseCov.at<float>(5, 5) = std::pow(velocity_cov, 2);
-        kf.processNoiseCov.at<float>(6, 6) = std::pow(1e-5, 2);
-        kf.processNoiseCov.at<float>(7, 7) = std::pow(velocity_cov, 2);
+        auto pose_cov = m_std_weight_position*kf.state_post(3) * delta_frame_number;
+        auto velocity_cov = m_std_weight_velocity*kf.state_post(3) * delta_frame_number;
+        kf.process_noise_cov(0, 0) = std::pow(pose_cov, 2);
+        kf.process_noise_cov(1, 1) = std::pow(pose_cov, 2);
+        kf.process_noise_cov(2, 2) = 1;
+        kf.process_noise_cov(3, 3) = std::pow(pose_cov, 2);
+        kf.process_noise_cov(4, 4) = std::pow(velocity_cov, 2);
+        kf.process_noise_cov(5, 5) = std::pow(velocity_cov, 2);
+        kf.process_noise_cov(6, 6) = std::pow(1e-5, 2);
+        kf.process_noise_cov(7, 7) = std::pow(velocity_cov, 2);
         if (flag)
-            kf.statePost.at<float>(7, 0) = 0;
-
-        cv::Mat p = kf.predict();
-        _xyah2bbox(p.at<float>(0, 0), p.at<float>(1, 0),
-                          p.at<float>(2, 0), p.at<float>(3, 0),
-                          output_bbox);
+            kf.state_post(7) = 0;
     }
 
-    void DeepSortMotionPrediction::update(cv::KalmanFilter &kf, const BBOX &bbox) {
-//        cv::Mat measurement = cv::Mat::zeros(m_measureNum, 1, CV_32F);
+    void DeepSortMotionPrediction::_prepare_update(KalmanFilter &kf, const BBOX &bbox,
+                                                  KalmanFilter::MeasureVector &output_measurement) {
         // measurement
         std::vector<float> n_xyah;
         _bbox2xyah(bbox, n_xyah);
-        m_update_measurement.at<float>(0, 0) = n_xyah[0];
-        m_update_measurement.at<float>(1, 0) = n_xyah[1];
-        m_update_measurement.at<float>(2, 0) = n_xyah[2];
-        m_update_measurement.at<float>(3, 0) = n_xyah[3];
+        output_measurement << n_xyah[0], n_xyah[1], n_xyah[2], n_xyah[3];
         // init R matrix using height
-        kf.measurementNoiseCov.at<float>(0, 0) = std::pow(m_std_weight_position*kf.statePre.at<float>(3, 0), 2);
-        kf.measurementNoiseCov.at<float>(1, 1) = std::pow(m_std_weight_position*kf.statePre.at<float>(3, 0), 2);
-        kf.measurementNoiseCov.at<float>(2, 2) = 1.0/30;
-        kf.measurementNoiseCov.at<float>(3, 3) = std::pow(m_std_weight_position*kf.statePre.at<float>(3, 0), 2);
-
-        // update
-        kf.correct(m_update_measurement);
+        kf.measurement_noise_cov(0, 0) = std::pow(m_std_weight_position*kf.state_pre(3), 2);
+        kf.measurement_noise_cov(1, 1) = std::pow(m_std_weight_position*kf.state_pre(3), 2);
+        kf.measurement_noise_cov(2, 2) = 1.0/30;
+        kf.measurement_noise_cov(3, 3) = std::pow(m_std_weight_position*kf.state_pre(3), 2);
     }
 
-    void DeepSortMotionPrediction::get_bbox_state(cv::KalmanFilter &kf, BBOX &output_bbox) {
-        const cv::Mat &s = kf.statePost;
-        _xyah2bbox(s.at<float>(0, 0), s.at<float>(1, 0),
-                          s.at<float>(2, 0), s.at<float>(3, 0),
-                          output_bbox);
+    void DeepSortMotionPrediction::_state2bbox(const KalmanFilter::StateVector &state, BBOX &output_bbox) const {
+        _xyah2bbox(state(0), state(1), state(2), state(3), output_bbox);
     }
 
-    void DeepSortMotionPrediction::project_state2measurement(cv::KalmanFilter &kf, cv::Mat &output_mean,
-                                                            cv::Mat &output_covariance) const {
-        cv::Mat_<float> innovation_cov = (cv::Mat_<float>(m_measureNum, m_measureNum) <<   std::pow(m_std_weight_position*kf.statePre.at<float>(3, 0), 2), 0, 0, 0,
-                                                                                0, std::pow(m_std_weight_position*kf.statePre.at<float>(3, 0), 2), 0, 0,
-                                                                                0, 0, std::pow(1e-1, 2), 0,
-                                                                                0, 0, 0, std::pow(m_std_weight_position*kf.statePre.at<float>(3, 0), 2));
-
-        output_mean = kf.measurementMatrix * kf.statePre;
-        output_covariance = kf.measurementMatrix * kf.errorCovPre * kf.measurementMatrix.t() + innovation_cov;
+    void DeepSortMotionPrediction::project_state2measurement(KalmanFilter &kf, KalmanFilter::MeasureVector &output_mean,
+                                                             KalmanFilter::MeasureMatrix &output_covariance) const {
+        KalmanFilter::MeasureMatrix innovation_cov = KalmanFilter::MeasureMatrix::Zero();
+        innovation_cov.diagonal() << std::pow(m_std_weight_position*kf.state_pre(3), 2),
+                                     std::pow(m_std_weight_position*kf.state_pre(3), 2),
+                                     std::pow(1e-1, 2),
+                                     std::pow(m_std_weight_position*kf.state_pre(3), 2);
+
+        output_mean.noalias() = kf.measurement_matrix * kf.state_pre;
+        output_covariance.noalias() = kf.measurement_matrix * kf.error_cov_pre * kf.measurement_matrix.transpose();
+        output_covariance += innovation_cov;
     }
 
     void DeepSortMotionPrediction::_bbox2xyah(const BBOX &bbox, std::vector<float> &output) {
@@ -29,7 +29,13 @@ void DeepSortTracker::init(const TrackerParam &param)
     m_kalman_tracker->add_event_handler(m_kalman_handler);
 
     m_feature_traits = std::make_shared<CosineFeature>();
+    if (!p->m_feature_projection_file.empty()) {
+        auto projection = std::make_shared<FeatureProjection>();
+        projection->load(p->m_feature_projection_file);
+        m_feature_traits->set_projection(projection);
+    }
     m_detection_comparision = std::make_shared<DefaultDetectionTraits>(this);
+    m_feature_gallery.init(p->m_gallery_size, p->m_gallery_max_tracks);
 }
 
 const TrackerParam *DeepSortTracker::get_tracker_param() const
@@ -58,9 +64,15 @@ void DeepSortTracker::begin_track(const cv::Mat &img,
                                   int frame_number)
 {
     m_id2target.clear();
+    m_feature_gallery.clear();
 
     _update_frame_number(frame_number);
 
+    // features enter the tracker in their projected form, see
+    // FeatureTraits::set_projection()
+    _project_features(detections, m_feature_traits.get());
+    _pack_features(detections, m_feature_traits.get());
+
     m_optical_flow_handler->clear();
     m_optical_flow_tracker->begin_track(img, detections, frame_number);
     m_kalman_handler->clear();
@@ -100,6 +112,7 @@ void DeepSortTracker::finish_track()
             (*iter)->evt_target_closed_after(this, event_data);
         }
     }
+    m_feature_gallery.clear();
     m_frame_number = INIT_TRACKING_FRAME;
     m_path_id_for_generate_unique_id = 0;
 }
@@ -113,11 +126,18 @@ void DeepSortTracker::track(const cv::Mat &img,
     assert_throw(m_frame_number <= frame_number,
                  "m frame number less than frame number");
 
+    // features enter the tracker in their projected form, see
+    // FeatureTraits::set_projection()
+    _project_features(detections, m_feature_traits.get());
+    _pack_features(detections, m_feature_traits.get());
+
     // delete removed tracker
     _remove_targets(frame_number);
 
     std::vector<TrackTargetPtr> targets;
     auto p_param = dynamic_cast<DeepSortTrackerParam *>(m_param.get());
+    StageTimer::Scope predict_timer(m_stage_timer.get(),
+                                    StageTimer::MotionPrediction);
     if (p_param->m_use_optical_before_track) {
         _motion_predict(img, m_id2target, frame_number);
         for (auto &p : m_id2target) {
@@ -138,6 +158,7 @@ void DeepSortTracker::track(const cv::Mat &img,
             single_deepsort_target->set_bbox(kalman_target->get_bbox());
         }
     }
+    predict_timer.stop();
     _update_frame_number(frame_number);
 
     // second embedding and maha matching
@@ -199,6 +220,16 @@ void DeepSortTracker::track(const cv::Mat &img,
     }
 }
 
+void DeepSortTracker::submit_frame(const cv::Mat &img, int frame_number)
+{
+    // _motion_predict() joins it through m_optical_flow_tracker->track(), without it the flow is not used
+    auto p_param = dynamic_cast<DeepSortTrackerParam *>(m_param.get());
+    if (!p_param->m_use_optical_before_track)
+        return;
+    m_optical_flow_tracker->set_thread_pool(m_thread_pool);
+    m_optical_flow_tracker->submit_frame(img, frame_number);
+}
+
 void DeepSortTracker::track(const cv::Mat &img, int frame_number)
 {
     assert_throw(m_frame_number != INIT_TRACKING_FRAME,
@@ -293,15 +324,29 @@ void DeepSortTracker::_update_features(DeepSortTrackTargetPtr &target,
                                      features, p->m_alpha_smooth_features,
                                      (1 - p->m_alpha_smooth_features));
     target->set_feature(new_feature);
+    _pack_feature(*target, *m_feature_traits, false);
+}
+
+void DeepSortTracker::_update_gallery(const TrackTargetPtr &target,
+                                      const Detection &source)
+{
+    if (m_feature_gallery.get_capacity() == 0 || !source.has_feature())
+        return;
+    if (auto packed = _get_packed_feature(source, *m_feature_traits)) {
+        m_feature_gallery.add(target->get_path_id(), *packed);
+        return;
+    }
+    fVECTOR x = source.feature_view();
+    m_feature_traits->normalize(x);
+    m_feature_gallery.add(target->get_path_id(), x);
 }
 
-void DeepSortTracker::_bbox2xyah(const BBOX &bbox, cv::Mat &output)
+void DeepSortTracker::_bbox2xyah(const BBOX &bbox, KalmanFilter::MeasureVector &output)
 {
-    output = cv::Mat::zeros(4, 1, CV_32F);
-    output.at<float>(0, 0) = bbox.x + bbox.width / 2.0;
-    output.at<float>(1, 0) = bbox.y + bbox.height / 2.0;
-    output.at<float>(2, 0) = bbox.width / bbox.height;
-    output.at<float>(3, 0) = bbox.height;
+    output(0) = bbox.x + bbox.width / 2.0;
+    output(1) = bbox.y + bbox.height / 2.0;
+    output(2) = bbox.width / bbox.height;
+    output(3) = bbox.height;
 }
 
 const std::map<int, TrackTargetPtr> &
@@ -318,6 +363,7 @@ TrackTargetPtr DeepSortTracker::get_open_target(int path_id) const
 void DeepSortTracker::delete_target(int path_id)
 {
     m_id2target.erase(path_id);
+    m_feature_gallery.remove(path_id);
 }
 
 void DeepSortTracker::delete_all_targets()
@@ -335,6 +381,17 @@ void DeepSortTracker::add_target(const TrackTargetPtr &target)
         (*iter)->evt_target_created_before(this, event_data);
     }
 
+    // features are stored in the form compared by m_feature_traits, see
+    // _compute_appearance_distance()
+    if (target->has_feature()) {
+        fVECTOR feature = target->get_feature();
+        m_feature_traits->project(feature);
+        m_feature_traits->normalize(feature);
+        target->set_feature(feature);
+        _pack_feature(*target, *m_feature_traits, false);
+        _update_gallery(target, *target);
+    }
+
     m_id2target[target->get_path_id()] = target;
 
     for (auto iter = m_event_handlers.begin(); iter != m_event_handlers.end();
@@ -385,24 +442,23 @@ void DeepSortTracker::_match_maha_distance(
     std::vector<int> &output_unmatched_source,
     std::vector<int> &output_unmatched_target)
 {
+    StageTimer::Scope cost_timer(m_stage_timer.get(), StageTimer::CostMatrix);
     // calculate embedding distance
     auto n_det_now = sources.size();
     auto n_det_predict = targets.size();
-    std::vector<std::vector<float>> dist_matrix_now2prev(
-        n_det_now, std::vector<float>(n_det_predict, 0));
+    CostMatrix &dist_matrix_now2prev = m_cost_matrix;
+    dist_matrix_now2prev.resize(n_det_now, n_det_predict);
 
     bool sources_targets_feature_empty = true;
     // judge targets sources has feature or not
     for (size_t i = 0; i < sources.size(); i++) {
-        auto feature = sources[i]->get_feature();
-        if (feature.size() != 0) {
+        if (sources[i]->has_feature()) {
             sources_targets_feature_empty = false;
             break;
         }
     }
     for (size_t i = 0; i < targets.size(); i++) {
-        auto feature = targets[i]->get_feature();
-        if (feature.size() != 0) {
+        if (targets[i]->has_feature()) {
             sources_targets_feature_empty = false;
             break;
         }
@@ -414,55 +470,85 @@ void DeepSortTracker::_match_maha_distance(
         for (unsigned int i = 0; i < n_det_predict; i++)
             output_unmatched_target.push_back(i);
     } else {
-        for (size_t i = 0; i < sources.size(); i++) {
-            for (size_t j = 0; j < targets.size(); j++) {
-                dist_matrix_now2prev[i][j] =
-                    m_detection_comparision->compute_detection_distance(
-                        targets[j].get(), sources[i].get());
-            }
-        }
-
-        // calculate maha distance
+        // gate by maha distance first, pairs outside the gate do not use
+        // their appearance distance
         auto p_param = dynamic_cast<DeepSortTrackerParam *>(m_param.get());
-        auto n_kalman_target = m_kalman_tracker->get_all_targets();
-        for (size_t i = 0; i < sources.size(); i++) {
-            for (size_t j = 0; j < targets.size(); j++) {
-                auto single_id = targets[j]->get_path_id();
-                cv::Mat kalman_mean, kalman_covariance;
-                KalmanTrackTargetPtr n_single_kalman_target =
-                    dynamic_pointer_cast<KalmanTrackTarget>(
-                        n_kalman_target[single_id]);
-                m_kalman_tracker->get_motion_prediction()
-                    ->project_state2measurement(
-                        n_single_kalman_target->get_kf(), kalman_mean,
-                        kalman_covariance);
-                BBOX n_det_bbox = sources[i]->get_bbox();
-
-                // maha distance
-                cv::Mat det_mean;
-                _bbox2xyah(n_det_bbox, det_mean);
-                cv::Mat invert_kalman_covariance;
-                cv::invert(kalman_covariance, invert_kalman_covariance,
-                           cv::DECOMP_SVD);
-                double gating_dist =
-                    std::pow(cv::Mahalanobis(det_mean, kalman_mean,
-                                             invert_kalman_covariance),
-                             2);
-                if (gating_dist > p_param->get_gating_threshold())
-                    dist_matrix_now2prev[i][j] = MAX_COST_MATRIX_NUM;
-                dist_matrix_now2prev[i][j] =
-                    p_param->m_gating_dist_lambda * dist_matrix_now2prev[i][j] +
-                    (1 - p_param->m_gating_dist_lambda) * gating_dist;
+        _compute_gating_distance(sources, targets, m_gating_matrix);
+        const float gating_threshold = p_param->get_gating_threshold();
+        const float lambda = p_param->m_gating_dist_lambda;
+        select_pairs(m_gating_matrix, gating_threshold, nullptr, m_gated_pairs);
+        _compute_appearance_distance(*m_detection_comparision, sources,
+                                     targets, &m_gated_pairs,
+                                     m_appearance_matrix);
+        _parallel_rows(n_det_now, n_det_predict, [&](size_t first,
+                                                     size_t last) {
+            for (size_t i = first; i < last; i++) {
+                const float *gating_row = m_gating_matrix.row(i);
+                const float *appearance_row = m_appearance_matrix.row(i);
+                float *cost_row = dist_matrix_now2prev.row(i);
+                for (size_t j = 0; j < n_det_predict; j++) {
+                    float gating_dist = gating_row[j];
+                    float appearance_dist = gating_dist <= gating_threshold
+                                                ? appearance_row[j]
+                                                : MAX_COST_MATRIX_NUM;
+                    cost_row[j] =
+                        lambda * appearance_dist + (1 - lambda) * gating_dist;
+                }
             }
-        }
+        });
+
+        cost_timer.stop();
 
         // match
-        hungarian_match(dist_matrix_now2prev, n_det_now, n_det_predict,
-                        p_param->m_max_gating_distance, output_matched_pair,
-                        output_unmatched_source, output_unmatched_target);
+        StageTimer::Scope assign_timer(m_stage_timer.get(),
+                                       StageTimer::Assignment);
+        if (p_param->m_use_sparse_assignment)
+            hungarian_match_sparse(dist_matrix_now2prev,
+                                   p_param->m_max_gating_distance,
+                                   output_matched_pair, output_unmatched_source,
+                                   output_unmatched_target);
+        else
+            hungarian_match(dist_matrix_now2prev,
+                            p_param->m_max_gating_distance, output_matched_pair,
+                            output_unmatched_source, output_unmatched_target);
     }
 }
 
+void DeepSortTracker::_compute_feature_distance(
+    const Detection *const *a, size_t size_a, const Detection *const *b,
+    size_t size_b, const CandidatePairs *candidates, CostMatrix &output)
+{
+    auto p_param = dynamic_cast<DeepSortTrackerParam *>(m_param.get());
+    _compute_target_feature_distance(*m_feature_traits, &m_feature_gallery,
+                                     p_param->m_gallery_query_mode, a, size_a,
+                                     b, size_b, candidates, output);
+}
+
+void DeepSortTracker::_compute_gating_distance(
+    const std::vector<DetectionPtr> &sources,
+    const std::vector<TrackTargetPtr> &targets, CostMatrix &output)
+{
+    // one projection per target and one xyah measurement per source
+    m_source_measurements.resize(sources.size());
+    for (size_t i = 0; i < sources.size(); i++)
+        _bbox2xyah(sources[i]->get_bbox(), m_source_measurements[i]);
+
+    m_target_means.resize(targets.size());
+    m_target_covariances.resize(targets.size());
+    auto motion_prediction = m_kalman_tracker->get_motion_prediction();
+    for (size_t j = 0; j < targets.size(); j++) {
+        auto kalman_target = dynamic_cast<KalmanTrackTarget *>(
+            dynamic_cast<DeepSortTrackTarget *>(targets[j].get())
+                ->m_kalman_target.get());
+        motion_prediction->project_state2measurement(
+            kalman_target->get_kf(), m_target_means[j],
+            m_target_covariances[j]);
+    }
+
+    compute_pairwise_mahalanobis(m_source_measurements, m_target_means,
+                                 m_target_covariances, output);
+}
+
 void DeepSortTracker::_match_iou_distance(
     const std::vector<DetectionPtr> &sources,
     const std::vector<TrackTargetPtr> &targets,
@@ -470,22 +556,25 @@ void DeepSortTracker::_match_iou_distance(
     std::vector<int> &output_unmatched_source,
     std::vector<int> &output_unmatched_target)
 {
-    auto n_det_now = sources.size();
-    auto n_det_predict = targets.size();
-    std::vector<std::vector<float>> dist_matrix_now2prev(
-        n_det_now, std::vector<float>(n_det_predict, 0));
+    StageTimer::Scope cost_timer(m_stage_timer.get(), StageTimer::CostMatrix);
+    CostMatrix &dist_matrix_now2prev = m_cost_matrix;
 
-    for (size_t i = 0; i < sources.size(); i++) {
-        for (size_t j = 0; j < targets.size(); j++) {
-            auto bbox_after_predict = targets[j]->get_bbox();
-            auto bbox_now = sources[i]->get_bbox();
-            auto iou = compute_iou(bbox_now, bbox_after_predict);
-            dist_matrix_now2prev[i][j] = 1 - iou;
-        }
-    }
-    hungarian_match(dist_matrix_now2prev, n_det_now, n_det_predict,
-                    m_param->m_max_iou_distance, output_matched_pair,
-                    output_unmatched_source, output_unmatched_target);
+    m_source_boxes.assign(sources);
+    m_target_boxes.assign(targets);
+    compute_pairwise_iou(m_source_boxes, m_target_boxes, dist_matrix_now2prev,
+                         true);
+    cost_timer.stop();
+
+    StageTimer::Scope assign_timer(m_stage_timer.get(),
+                                   StageTimer::Assignment);
+    if (m_param->m_use_sparse_assignment)
+        hungarian_match_sparse(dist_matrix_now2prev,
+                               m_param->m_max_iou_distance, output_matched_pair,
+                               output_unmatched_source, output_unmatched_target);
+    else
+        hungarian_match(dist_matrix_now2prev, m_param->m_max_iou_distance,
+                        output_matched_pair, output_unmatched_source,
+                        output_unmatched_target);
 }
 
 void DeepSortTracker::_remove_targets(const int frame_number)
@@ -519,6 +608,7 @@ void DeepSortTracker::_remove_targets(const int frame_number)
         }
 
         m_id2target.erase(p);
+        m_feature_gallery.remove(p);
 
         for (auto iter = m_event_handlers.begin();
              iter != m_event_handlers.end(); iter++) {
@@ -567,6 +657,7 @@ void DeepSortTracker::_update_target(TrackTargetPtr &deepsort_target_ptr,
         single_kalman_target->set_end_frame_number(frame_number);
         _update_features(single_deepsort_target,
                          single_detection->get_feature());
+        _update_gallery(single_deepsort_target, *single_detection);
 
         // optical tracker update
         single_optical_target->set_bbox(single_deepsort_target->get_bbox());
@@ -666,6 +757,9 @@ int DeepSortTracker::KalmanEventHandler::evt_target_motion_predict_after(
 
 void DeepSortTracker::set_feature_traits(const FeatureTraitsPtr &p)
 {
+    // the projection configured by the param stays in effect
+    if (m_feature_traits && !p->get_projection())
+        p->set_projection(m_feature_traits->get_projection());
     m_feature_traits = p;
 }
 
@@ -685,4 +779,19 @@ DeepSortTracker::DefaultDetectionTraits::DefaultDetectionTraits(
     : m_tracker(p)
 {
 }
+
+void DeepSortTracker::DefaultDetectionTraits::compute_distance_matrix(
+    const Detection *const *a, size_t size_a, const Detection *const *b,
+    size_t size_b, CostMatrix &output)
+{
+    m_tracker->_compute_feature_distance(a, size_a, b, size_b, nullptr, output);
+}
+
+void DeepSortTracker::DefaultDetectionTraits::compute_distance_matrix(
+    const Detection *const *a, size_t size_a, const Detection *const *b,
+    size_t size_b, const CandidatePairs &candidates, CostMatrix &output)
+{
+    m_tracker->_compute_feature_distance(a, size_a, b, size_b, &candidates,
+                                         output);
+}
 } // namespace RedoxiTrack
\ No newline at end of file
@@ -14,6 +14,10 @@ void DeepSortTrackerParam::copy_to(TrackerParam &p) const
         m->m_max_gating_distance = m_max_gating_distance;
         m->m_base_gating_threshold = m_base_gating_threshold;
         m->m_alpha_smooth_features = m_alpha_smooth_features;
+        m->m_feature_projection_file = m_feature_projection_file;
+        m->m_gallery_size = m_gallery_size;
+        m->m_gallery_max_tracks = m_gallery_max_tracks;
+        m->m_gallery_query_mode = m_gallery_query_mode;
         m->m_gating_dist_lambda = m_gating_dist_lambda;
         m->m_duplicate_iou_dist = m_duplicate_iou_dist;
         m->m_use_optical_before_track = m_use_optical_before_track;
@@ -8,16 +8,47 @@
 namespace RedoxiTrack{
 
     double FeatureBasedDetTraits::compute_detection_distance(const Detection *a, const Detection *b) {
-        auto feature_a = a->get_feature();
-        auto feature_b = b->get_feature();
         auto feature_traits = get_feature_traits();
-        double dist;
-        double max_dist = feature_traits->max_distance();
-        if(feature_a.size() == 0 || feature_b.size() == 0){
-            dist = max_dist;
-        } else {
-            dist = feature_traits->distance(feature_a, feature_b);
+        if (!a->has_feature() || !b->has_feature())
+            return feature_traits->max_distance();
+        return feature_traits->distance(a->get_feature(), b->get_feature());
+    }
+
+    void DetectionTraits::compute_distance_matrix(const Detection *const *a, size_t size_a, const Detection *const *b,
+                                                  size_t size_b, CostMatrix &output) {
+        output.resize(size_a, size_b);
+        for (size_t i = 0; i < size_a; i++) {
+            float *row = output.row(i);
+            for (size_t j = 0; j < size_b; j++)
+                row[j] = compute_detection_distance(b[j], a[i]);
+        }
+    }
+
+    void DetectionTraits::compute_distance_matrix(const Detection *const *a, size_t size_a, const Detection *const *b,
+                                                  size_t size_b, const CandidatePairs &candidates, CostMatrix &output) {
+        assert_throw(candidates.num_sources() == (int)size_a, "candidate pairs do not match the sources");
+        output.resize(size_a, size_b);
+        for (size_t i = 0; i < size_a; i++) {
+            float *row = output.row(i);
+            for (int k = candidates.offsets[i]; k < candidates.offsets[i + 1]; k++)
+                row[candidates.targets[k]] = compute_detection_distance(b[candidates.targets[k]], a[i]);
         }
-        return dist;
+    }
+
+    void FeatureBasedDetTraits::compute_distance_matrix(const Detection *const *a, size_t size_a,
+                                                        const Detection *const *b, size_t size_b, CostMatrix &output) {
+        auto feature_traits = get_feature_traits();
+        m_features_a.assign(a, size_a, feature_traits.get());
+        m_features_b.assign(b, size_b, feature_traits.get());
+        feature_traits->compute_distance_matrix(m_features_a, m_features_b, output);
+    }
+
+    void FeatureBasedDetTraits::compute_distance_matrix(const Detection *const *a, size_t size_a,
+                                                        const Detection *const *b, size_t size_b,
+                                                        const CandidatePairs &candidates, CostMatrix &output) {
+        auto feature_traits = get_feature_traits();
+        m_features_a.assign(a, size_a, feature_traits.get());
+        m_features_b.assign(b, size_b, feature_traits.get());
+        feature_traits->compute_distance_matrix(m_features_a, m_features_b, candidates, output);
     }
 }
\ No newline at end of file
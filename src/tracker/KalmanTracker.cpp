@@ -39,13 +39,13 @@ namespace RedoxiTrack {
             TrackingEvent::TargetClosed event_data = TrackingEvent::TargetClosed();
             event_data.m_target = m_id2target[del_id];
             for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
-                auto res = (*iter)->evt_target_closed_before(this, event_data);
+                (*iter)->evt_target_closed_before(this, event_data);
             }
 
             m_id2target.erase(del_id);
 
             for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
-                auto res = (*iter)->evt_target_closed_after(this, event_data);
+                (*iter)->evt_target_closed_after(this, event_data);
             }
         }
         m_frame_number = INIT_TRACKING_FRAME;
@@ -62,15 +62,33 @@ namespace RedoxiTrack {
         n_single_kalman_target->m_can_be_update = false;
     }
 
+    void KalmanTracker::update_kalman(const std::vector<TrackTargetPtr> &targets, const std::vector<BBOX> &bboxes) {
+        assert_throw(targets.size() == bboxes.size(), "every target needs one bbox");
+        m_batch_filters.clear();
+        for (auto &target : targets) {
+            auto kalman_target = dynamic_cast<KalmanTrackTarget*>(target.get());
+            assert_throw(kalman_target->m_can_be_update, "failed kalman target can not be update, please predict before update");
+            m_batch_filters.push_back(&kalman_target->get_kf());
+        }
+        m_motion_predict->update(m_batch_filters, bboxes);
+        for (size_t i = 0; i < targets.size(); i++) {
+            auto kalman_target = static_cast<KalmanTrackTarget*>(targets[i].get());
+            BBOX n_temp_bbox;
+            m_motion_predict->get_bbox_state(kalman_target->get_kf(), n_temp_bbox);
+            kalman_target->set_bbox(n_temp_bbox);
+            kalman_target->m_can_be_update = false;
+        }
+    }
+
     void KalmanTracker::_kalman_predict(TrackTargetPtr &target, const int &delta_frame_number, BBOX &output_bbox) {
         auto kalman_target = dynamic_cast<KalmanTrackTarget*>(target.get());
 
         auto& kf = kalman_target->get_kf();
 
-        kf.transitionMatrix.at<float>(0,4) = delta_frame_number;
-        kf.transitionMatrix.at<float>(1,5) = delta_frame_number;
-        kf.transitionMatrix.at<float>(2,6) = delta_frame_number;
-        kf.transitionMatrix.at<float>(3,7) = delta_frame_number;
+        kf.transition_matrix(0, 4) = delta_frame_number;
+        kf.transition_matrix(1, 5) = delta_frame_number;
+        kf.transition_matrix(2, 6) = delta_frame_number;
+        kf.transition_matrix(3, 7) = delta_frame_number;
         // kalman filter predict m_id2target
 
         m_motion_predict->predict(kf, output_bbox, delta_frame_number,
@@ -91,21 +109,25 @@ namespace RedoxiTrack {
             TrackingEvent::TargetClosed event_data = TrackingEvent::TargetClosed();
             event_data.m_target = m_id2target[p];
             for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
-                auto res = (*iter)->evt_target_closed_before(this, event_data);
+                (*iter)->evt_target_closed_before(this, event_data);
             }
 
             m_id2target.erase(p);
 
             for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
-                auto res = (*iter)->evt_target_closed_after(this, event_data);
+                (*iter)->evt_target_closed_after(this, event_data);
             }
         }
 
         // first motion prediction
+        StageTimer::Scope predict_timer(m_stage_timer.get(), StageTimer::MotionPrediction);
         int delta_frame_number = frame_number - m_frame_number;
+        m_batch_targets.clear();
         for(auto &p: m_id2target) {
-            _motion_predict(delta_frame_number, p.second, false);
+            m_batch_targets.push_back(p.second);
         }
+        _motion_predict(delta_frame_number, m_batch_targets, false);
+        predict_timer.stop();
 
         _update_frame_number(frame_number);
 
@@ -124,52 +146,54 @@ namespace RedoxiTrack {
 //        std::map<int, KalmanTrackTargetPtr> kalman_track_target;
 //        _trans_target2kalman_target((*id2target_ptr), kalman_track_target);
         // calculate iou
-        auto n_det_predict = m_id2target.size();
-        auto n_det_now = detections.size();
+        StageTimer::Scope cost_timer(m_stage_timer.get(), StageTimer::CostMatrix);
         std::vector<KalmanTrackTargetPtr> targets; //all previous targets
         for (auto &p : m_id2target) {
             auto kalman_target = dynamic_pointer_cast<KalmanTrackTarget>(p.second);
             targets.push_back(kalman_target);
         }
-        std::vector<std::vector<float>> dist_matrix_now2prev(n_det_now, std::vector<float>(n_det_predict, 0));
+        CostMatrix &dist_matrix_now2prev = m_cost_matrix;
 
-        for (size_t i = 0; i < detections.size(); i++) {
-            for (size_t j = 0; j < targets.size(); j++) {
-                auto bbox_after_predict = targets[j]->get_bbox();
-                auto bbox_now = detections[i]->get_bbox();
-                auto iou = compute_iou(bbox_now, bbox_after_predict);
-                dist_matrix_now2prev[i][j] = 1 - iou;
-            }
-        }
+        m_source_boxes.assign(detections);
+        m_target_boxes.assign(targets);
+        compute_pairwise_iou(m_source_boxes, m_target_boxes, dist_matrix_now2prev, true);
 
         // match detection and target after predict
         std::vector<std::pair<int, int>> matched_pair;
         std::vector<int> unmatched_detection_now;
         std::vector<int> unmatched_detection_predict;
-        hungarian_match(dist_matrix_now2prev, n_det_now, n_det_predict, m_param->m_max_iou_distance, matched_pair,
+        cost_timer.stop();
+        StageTimer::Scope assign_timer(m_stage_timer.get(), StageTimer::Assignment);
+        hungarian_match(dist_matrix_now2prev, m_param->m_max_iou_distance, matched_pair,
                         unmatched_detection_now, unmatched_detection_predict);
+        assign_timer.stop();
 
         //update tracker state
-            // update matched detection_now and detection_predict
+            // update matched detection_now and detection_predict, all kalman filters in one batch
+            std::vector<TrackingEvent::TargetAssociation> association_events(matched_pair.size());
+            std::vector<TrackTargetPtr> matched_targets(matched_pair.size());
+            std::vector<BBOX> matched_bboxes(matched_pair.size());
             for (size_t i = 0; i < matched_pair.size(); i++) {
-                auto single_target = targets[matched_pair[i].second];
-                auto single_detection = detections[matched_pair[i].first];
-
-                TrackingEvent::TargetAssociation event_data = TrackingEvent::TargetAssociation();
-                event_data.m_detection = single_detection;
-                event_data.m_target = single_target;
+                auto &event_data = association_events[i];
+                event_data.m_detection = detections[matched_pair[i].first];
+                event_data.m_target = targets[matched_pair[i].second];
                 for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
-                    auto res = (*iter)->evt_target_association_before(this, event_data);
+                    (*iter)->evt_target_association_before(this, event_data);
                 }
+                matched_targets[i] = event_data.m_target;
+                matched_bboxes[i] = event_data.m_detection->get_bbox();
+            }
 
-                // update kalman filter
-                TrackTargetPtr temp_p = single_target;
-                update_kalman(temp_p, single_detection->get_bbox());
+            // update kalman filter
+            update_kalman(matched_targets, matched_bboxes);
+
+            for (size_t i = 0; i < matched_pair.size(); i++) {
+                auto &single_target = matched_targets[i];
                 single_target->set_path_state(TrackPathStateBitmask::Open);
                 single_target->set_end_frame_number(frame_number);
 
                 for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
-                    auto res = (*iter)->evt_target_association_after(this, event_data);
+                    (*iter)->evt_target_association_after(this, association_events[i]);
                 }
                 // update tracking decision
             }
@@ -191,10 +215,11 @@ namespace RedoxiTrack {
         assert_throw(m_frame_number <= frame_number, "frame number less than m frame number");
 
         int delta_frame_number = frame_number - m_frame_number;
+        m_batch_targets.clear();
         for (auto &p : m_id2target) {
-
-            _motion_predict(delta_frame_number, p.second, true);
+            m_batch_targets.push_back(p.second);
         }
+        _motion_predict(delta_frame_number, m_batch_targets, true);
 
         _update_frame_number(frame_number);
     }
@@ -210,13 +235,13 @@ namespace RedoxiTrack {
             TrackingEvent::TargetMotionPredict event_data = TrackingEvent::TargetMotionPredict();
             event_data.m_target = target;
             for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
-                auto res = (*iter)->evt_target_motion_predict_before(this, event_data);
+                (*iter)->evt_target_motion_predict_before(this, event_data);
             }
 
             target->set_bbox(single_target_predict_bbox);
 
             for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
-                auto res = (*iter)->evt_target_motion_predict_after(this, event_data);
+                (*iter)->evt_target_motion_predict_after(this, event_data);
             }
         }
         else{
@@ -224,6 +249,41 @@ namespace RedoxiTrack {
         }
     }
 
+    void KalmanTracker::_motion_predict(int delta_frame_number, const std::vector<TrackTargetPtr> &targets,
+                                        bool notify_event_handler) {
+        assert_throw(m_frame_number != INIT_TRACKING_FRAME, "m frame number is INIT_TRACKING_FRAME");
+        assert_throw(delta_frame_number >= 0, "frame number less than m frame number");
+
+        m_batch_filters.clear();
+        m_batch_flags.clear();
+        for (auto &target : targets) {
+            auto kalman_target = dynamic_cast<KalmanTrackTarget*>(target.get());
+            m_batch_filters.push_back(&kalman_target->get_kf());
+            m_batch_flags.push_back(kalman_target->get_path_state() == TrackPathStateBitmask::Lost);
+            kalman_target->m_can_be_update = true;
+        }
+        m_motion_predict->predict(m_batch_filters, m_batch_flags, m_batch_bboxes, delta_frame_number);
+
+        for (size_t i = 0; i < targets.size(); i++) {
+            if (notify_event_handler) {
+                TrackingEvent::TargetMotionPredict event_data = TrackingEvent::TargetMotionPredict();
+                event_data.m_target = targets[i];
+                for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
+                    (*iter)->evt_target_motion_predict_before(this, event_data);
+                }
+
+                targets[i]->set_bbox(m_batch_bboxes[i]);
+
+                for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
+                    (*iter)->evt_target_motion_predict_after(this, event_data);
+                }
+            }
+            else {
+                targets[i]->set_bbox(m_batch_bboxes[i]);
+            }
+        }
+    }
+
     const std::map<int, TrackTargetPtr> &KalmanTracker::get_all_open_targets() const {
         return m_id2target;
     }
@@ -237,13 +297,13 @@ namespace RedoxiTrack {
         event_data.m_detection = target->get_underlying_detection();
         event_data.m_target = target;
         for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
-            auto res = (*iter)->evt_target_created_before(this, event_data);
+            (*iter)->evt_target_created_before(this, event_data);
         }
 
         m_id2target[target->get_path_id()] = target;
 
         for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
-            auto res = (*iter)->evt_target_created_after(this, event_data);
+            (*iter)->evt_target_created_after(this, event_data);
         }
     }
 
@@ -0,0 +1,34 @@
+#include "RedoxiTrack/tracker/MotionPredictionByKalman.h"
+
+namespace RedoxiTrack{
+    void MotionPredictionByKalman::predict(const std::vector<KalmanFilter *> &kfs, const std::vector<bool> &flags,
+                                           std::vector<BBOX> &output_bboxes, int delta_frame_number) {
+        assert_throw(kfs.size() == flags.size(), "every kalmanFilter needs one flag");
+        output_bboxes.resize(kfs.size());
+        if (!_is_constant_velocity()) {
+            for (size_t i = 0; i < kfs.size(); i++)
+                predict(*kfs[i], output_bboxes[i], delta_frame_number, flags[i]);
+            return;
+        }
+
+        for (size_t i = 0; i < kfs.size(); i++)
+            _prepare_predict(*kfs[i], delta_frame_number, flags[i]);
+        m_batch.predict(kfs, delta_frame_number);
+        for (size_t i = 0; i < kfs.size(); i++)
+            _state2bbox(kfs[i]->state_pre, output_bboxes[i]);
+    }
+
+    void MotionPredictionByKalman::update(const std::vector<KalmanFilter *> &kfs, const std::vector<BBOX> &bboxes) {
+        assert_throw(kfs.size() == bboxes.size(), "every kalmanFilter needs one bbox");
+        if (!_is_constant_velocity()) {
+            for (size_t i = 0; i < kfs.size(); i++)
+                update(*kfs[i], bboxes[i]);
+            return;
+        }
+
+        m_batch_measurements.resize(kfs.size());
+        for (size_t i = 0; i < kfs.size(); i++)
+            _prepare_update(*kfs[i], bboxes[i], m_batch_measurements[i]);
+        m_batch.correct(kfs, m_batch_measurements);
+    }
+}
@@ -0,0 +1,193 @@
+#include "RedoxiTrack/tracker/MultiStreamTracker.h"
+
+namespace RedoxiTrack
+{
+
+MultiStreamTracker::~MultiStreamTracker()
+{
+    // let the queued frames finish, they point to the streams
+    m_pool.stop();
+}
+
+void MultiStreamTracker::init(int num_threads)
+{
+    m_pool.start(num_threads);
+}
+
+int MultiStreamTracker::add_stream(const TrackerBasePtr &tracker)
+{
+    assert_throw(tracker != nullptr, "the tracker of a stream must not be null");
+    std::unique_ptr<Stream> stream(new Stream());
+    stream->tracker = tracker;
+
+    std::lock_guard<std::mutex> lock(m_streams_mutex);
+    stream->id = (int)m_streams.size();
+    m_streams.push_back(std::move(stream));
+    return m_streams.back()->id;
+}
+
+int MultiStreamTracker::get_num_streams() const
+{
+    std::lock_guard<std::mutex> lock(m_streams_mutex);
+    return (int)m_streams.size();
+}
+
+TrackerBasePtr MultiStreamTracker::get_tracker(int stream_id) const
+{
+    return _get_stream(stream_id)->tracker;
+}
+
+void MultiStreamTracker::submit(int stream_id, const cv::Mat &img,
+                                const std::vector<DetectionPtr> &detections,
+                                int frame_number)
+{
+    Frame frame;
+    frame.img = img;
+    frame.detections = detections;
+    frame.frame_number = frame_number;
+    frame.submit_time = Clock::now();
+    _enqueue(_get_stream(stream_id), std::move(frame));
+}
+
+void MultiStreamTracker::submit_finish(int stream_id)
+{
+    Frame frame;
+    frame.finish = true;
+    frame.submit_time = Clock::now();
+    _enqueue(_get_stream(stream_id), std::move(frame));
+}
+
+void MultiStreamTracker::wait(int stream_id)
+{
+    Stream *stream = _get_stream(stream_id);
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(stream->mutex);
+        stream->idle.wait(lock, [stream]() { return !stream->scheduled; });
+        std::swap(error, stream->error);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void MultiStreamTracker::wait_all()
+{
+    std::exception_ptr first_error;
+    int num_streams = get_num_streams();
+    for (int i = 0; i < num_streams; i++) {
+        try {
+            wait(i);
+        } catch (...) {
+            if (!first_error)
+                first_error = std::current_exception();
+        }
+    }
+    if (first_error)
+        std::rethrow_exception(first_error);
+}
+
+StreamLatency MultiStreamTracker::get_stream_latency(int stream_id) const
+{
+    Stream *stream = _get_stream(stream_id);
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    StreamLatency output = stream->latency;
+    output.num_pending = stream->frames.size();
+    return output;
+}
+
+void MultiStreamTracker::reset_stream_latency(int stream_id)
+{
+    Stream *stream = _get_stream(stream_id);
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    stream->latency = StreamLatency();
+}
+
+MultiStreamTracker::Stream *MultiStreamTracker::_get_stream(int stream_id) const
+{
+    std::lock_guard<std::mutex> lock(m_streams_mutex);
+    assert_throw(stream_id >= 0 && stream_id < (int)m_streams.size(),
+                 "invalid stream id " + std::to_string(stream_id));
+    return m_streams[stream_id].get();
+}
+
+void MultiStreamTracker::_enqueue(Stream *stream, Frame &&frame)
+{
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->frames.push_back(std::move(frame));
+        if (!stream->scheduled) {
+            stream->scheduled = true;
+            schedule = true;
+        }
+    }
+    if (schedule)
+        m_pool.submit([this, stream]() { _run_stream(stream); });
+}
+
+void MultiStreamTracker::_run_stream(Stream *stream)
+{
+    Frame frame;
+    bool failed;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        frame = std::move(stream->frames.front());
+        stream->frames.pop_front();
+        failed = stream->error != nullptr;
+    }
+
+    // frames after a failure are skipped until wait() reports it
+    std::exception_ptr error;
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start;
+    if (!failed) {
+        try {
+            if (frame.finish) {
+                if (stream->started)
+                    stream->tracker->finish_track();
+                stream->started = false;
+            } else {
+                if (stream->started)
+                    stream->tracker->track(frame.img, frame.detections,
+                                           frame.frame_number);
+                else
+                    stream->tracker->begin_track(frame.img, frame.detections,
+                                                 frame.frame_number);
+                stream->started = true;
+                end = Clock::now();
+                if (m_frame_callback)
+                    m_frame_callback(stream->id, frame.frame_number,
+                                     *stream->tracker);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+
+    bool reschedule = false;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        if (error)
+            stream->error = error;
+        if (!failed && !error && !frame.finish) {
+            StreamLatency &latency = stream->latency;
+            double seconds =
+                std::chrono::duration<double>(end - frame.submit_time).count();
+            latency.num_frames++;
+            latency.last_latency = seconds;
+            latency.sum_latency += seconds;
+            latency.max_latency = std::max(latency.max_latency, seconds);
+            latency.sum_track_time +=
+                std::chrono::duration<double>(end - start).count();
+        }
+        reschedule = !stream->frames.empty();
+        stream->scheduled = reschedule;
+        if (!reschedule)
+            stream->idle.notify_all();
+    }
+    // behind the streams already queued on this worker
+    if (reschedule)
+        m_pool.submit([this, stream]() { _run_stream(stream); });
+}
+
+} // namespace RedoxiTrack
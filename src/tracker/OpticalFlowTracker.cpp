@@ -33,6 +33,7 @@ namespace RedoxiTrack
     OpticalFlowTracker::begin_track(const cv::Mat &img,
                                     const std::vector<DetectionPtr> &detections,
                                     int frame_number) {
+        _reset_pending_flow();
         m_id2target.clear();
         m_motion_predict->set_prev_image(img);
         _update_frame_number(frame_number);
@@ -43,6 +44,7 @@ namespace RedoxiTrack
     }
 
     void OpticalFlowTracker::finish_track() {
+        _reset_pending_flow();
         std::vector<int> delete_ids;
         for (auto &p : m_id2target) {
             delete_ids.push_back(p.first);
@@ -79,7 +81,9 @@ namespace RedoxiTrack
         }
 
         // first motion prediction
+        StageTimer::Scope predict_timer(m_stage_timer.get(), StageTimer::MotionPrediction);
         _motion_predict(img, frame_number, m_id2target);
+        predict_timer.stop();
 
         m_motion_predict->set_prev_image(img);
         _update_frame_number(frame_number);
@@ -97,29 +101,24 @@ namespace RedoxiTrack
             return;
         }
         // calculate iou
-        auto n_det_predict = m_id2target.size();
-        auto n_det_now = detections.size();
+        StageTimer::Scope cost_timer(m_stage_timer.get(), StageTimer::CostMatrix);
         std::vector<TrackTargetPtr> targets;
         for(auto& p : m_id2target)
             targets.push_back(p.second);
-        std::vector<std::vector<float>> dist_matrix_now2prev(n_det_now, std::vector<float>(n_det_predict, 0));
-
-        for(size_t i=0; i<detections.size(); i++)
-        {
-            for(size_t j=0; j<targets.size(); j++)
-            {
-                auto bbox_now = detections[i]->get_bbox();
-                auto bbox_after_predict = targets[j]->get_bbox();
-                auto iou = compute_iou(bbox_now, bbox_after_predict);
-                dist_matrix_now2prev[i][j] = 1-iou;
-            }
-        }
+        CostMatrix &dist_matrix_now2prev = m_cost_matrix;
+
+        m_source_boxes.assign(detections);
+        m_target_boxes.assign(targets);
+        compute_pairwise_iou(m_source_boxes, m_target_boxes, dist_matrix_now2prev, true);
 
         // match detection and target after predict
         std::vector<std::pair<int, int>> matched_pair;
         std::vector<int> unmatched_detection_now;
         std::vector<int> unmatched_detection_predict;
-        hungarian_match(dist_matrix_now2prev, n_det_now, n_det_predict, m_param->m_max_iou_distance, matched_pair, unmatched_detection_now, unmatched_detection_predict);
+        cost_timer.stop();
+        StageTimer::Scope assign_timer(m_stage_timer.get(), StageTimer::Assignment);
+        hungarian_match(dist_matrix_now2prev, m_param->m_max_iou_distance, matched_pair, unmatched_detection_now, unmatched_detection_predict);
+        assign_timer.stop();
 
         //update tracker state
             // update matched detection_now and detection_predict
@@ -184,6 +183,30 @@ namespace RedoxiTrack
     }
 
 
+    void OpticalFlowTracker::submit_frame(const cv::Mat &img, int frame_number) {
+        _reset_pending_flow();
+        if (m_frame_number == INIT_TRACKING_FRAME || frame_number <= m_frame_number || m_id2target.empty())
+            return;
+
+        // the boxes are final once the previous frame is tracked, so the keypoints are known before its detections
+        PendingFlow &flow = m_pending_flow;
+        flow.ids.clear();
+        flow.bboxes.clear();
+        for (auto &p: m_id2target) {
+            flow.ids.push_back(p.first);
+            flow.bboxes.push_back(p.second->get_bbox());
+        }
+        _generate_keypoints(flow.bboxes, flow.points);
+        flow.frame_number = frame_number;
+        flow.img = img;
+
+        // the previous image is not changed until the flow is joined or reset
+        OpticalFlowMotionPredictionPtr motion_predict = m_motion_predict;
+        m_flow_task.start(m_thread_pool.get(), [motion_predict, &flow]() {
+            motion_predict->predict_keypoint_location(flow.img, flow.points, flow.result);
+        });
+    }
+
     void OpticalFlowTracker::_motion_predict(const cv::Mat &img, int frame_number,
                                                          const std::map<int, TrackTargetPtr>& id2target){
         auto id2bbox_after_flow = _advance_bbox_with_motion_prediction(img, frame_number, id2target);
@@ -197,8 +220,10 @@ namespace RedoxiTrack
     std::map<int, BBOX> OpticalFlowTracker::_advance_bbox_with_motion_prediction(const cv::Mat& img, int frame_number,
                                                                                   const std::map<int, TrackTargetPtr>& id2target){
         assert_throw(m_frame_number < frame_number, "frame number less than m frame number");
-        if (id2target.empty())
+        if (id2target.empty()) {
+            _reset_pending_flow();
             return std::map<int, BBOX>();
+        }
         // extract id and bbox from m_id2target
         std::vector<int> pre_ids;
         std::vector<BBOX> pre_bbox;
@@ -207,29 +232,29 @@ namespace RedoxiTrack
             pre_bbox.push_back(p.second->get_bbox());
         }
 
-        // generate points based on bboxes
-        auto p_param = dynamic_cast<OpticalTrackerParam*>(m_param.get());
-        std::vector<POINT> points;
-        std::vector<POINT> temp_points;
-        for(int i = 0; i < pre_bbox.size(); i++){
-            temp_points = generate_uniform_keypoints(pre_bbox[i], p_param->m_pts_per_width, p_param->m_pts_per_height);
-            points.insert(points.end(), temp_points.begin(), temp_points.end());
+        // target i uses the keypoints at flow_index[i] of the flow
+        PendingFlow &flow = m_pending_flow;
+        std::vector<int> flow_index;
+        if (!_join_pending_flow(img, frame_number, pre_ids, pre_bbox, flow_index)) {
+            // generate points based on bboxes, and using lk flow predict new points
+            _generate_keypoints(pre_bbox, flow.points);
+            m_motion_predict->predict_keypoint_location(img, flow.points, flow.result);
+            flow_index.resize(pre_bbox.size());
+            for (size_t i = 0; i < flow_index.size(); i++)
+                flow_index[i] = (int)i;
         }
 
-        // using lk flow predict new points
-        OpticalFlowMotionPrediction::Result motion_prediction_result;
-        m_motion_predict->predict_keypoint_location(img, points, motion_prediction_result);
-
         // get new bbox based on new points
+        auto p_param = dynamic_cast<OpticalTrackerParam*>(m_param.get());
         std::vector<BBOX> cur_bbox;
         for(int i = 0; i < pre_bbox.size(); i++){
             int number_points = p_param->m_pts_per_height * p_param->m_pts_per_width;
-            int point_index = i * number_points;
+            int point_index = flow_index[i] * number_points;
             cur_bbox.push_back(predict_bbox_by_keypoints(pre_bbox[i],
-                                                         &points[0] + point_index,
-                                                         &motion_prediction_result.keypoints_predicted[0] + point_index,
+                                                         &flow.points[0] + point_index,
+                                                         &flow.result.keypoints_predicted[0] + point_index,
                                                          number_points,
-                                                         &motion_prediction_result.keypoints_valid[0] + point_index));
+                                                         &flow.result.keypoints_valid[0] + point_index));
         }
 
         // get output from new bboxes and ids
@@ -244,6 +269,48 @@ namespace RedoxiTrack
     }
 
 
+    void OpticalFlowTracker::_generate_keypoints(const std::vector<BBOX> &bboxes, std::vector<POINT> &output) const {
+        auto p_param = dynamic_cast<OpticalTrackerParam*>(m_param.get());
+        output.clear();
+        for (auto &bbox: bboxes) {
+            std::vector<POINT> temp_points = generate_uniform_keypoints(bbox, p_param->m_pts_per_width,
+                                                                        p_param->m_pts_per_height);
+            output.insert(output.end(), temp_points.begin(), temp_points.end());
+        }
+    }
+
+    bool OpticalFlowTracker::_join_pending_flow(const cv::Mat &img, int frame_number, const std::vector<int> &ids,
+                                                const std::vector<BBOX> &bboxes, std::vector<int> &output_index) {
+        if (!m_flow_task.valid())
+            return false;
+        PendingFlow &flow = m_pending_flow;
+        bool same_frame = flow.frame_number == frame_number && flow.img.data == img.data &&
+                          flow.img.rows == img.rows && flow.img.cols == img.cols;
+        m_flow_task.join();
+        flow.frame_number = INIT_TRACKING_FRAME;
+        flow.img = cv::Mat();
+        if (!same_frame)
+            return false;
+
+        // targets deleted since submit_frame() are skipped, new or moved ones need the synchronous flow
+        output_index.resize(ids.size());
+        size_t k = 0;
+        for (size_t i = 0; i < ids.size(); i++) {
+            while (k < flow.ids.size() && flow.ids[k] < ids[i])
+                k++;
+            if (k == flow.ids.size() || flow.ids[k] != ids[i] || flow.bboxes[k] != bboxes[i])
+                return false;
+            output_index[i] = (int)k;
+        }
+        return true;
+    }
+
+    void OpticalFlowTracker::_reset_pending_flow() {
+        m_flow_task.reset();
+        m_pending_flow.frame_number = INIT_TRACKING_FRAME;
+        m_pending_flow.img = cv::Mat();
+    }
+
     const TrackerParam *OpticalFlowTracker::get_tracker_param() const {
         return TrackerBase::get_tracker_param();
     }
@@ -257,8 +324,12 @@ namespace RedoxiTrack
     }
 
     void OpticalFlowTracker::delete_target(int path_id) {
+        // e.g. a long lost target of BotsortTracker, already taken out
+        auto it = m_id2target.find(path_id);
+        if (it == m_id2target.end())
+            return;
         TrackingEvent::TargetClosed event_data = TrackingEvent::TargetClosed();
-        event_data.m_target = m_id2target[path_id];
+        event_data.m_target = it->second;
         for(auto iter = m_event_handlers.begin(); iter != m_event_handlers.end(); iter++){
             (*iter)->evt_target_closed_before(this, event_data);
         }
@@ -319,6 +390,7 @@ namespace RedoxiTrack
     void OpticalFlowTracker::_tracking_state_recover(const TrackerTrackingState& state) {
         auto optical_state = dyncast_with_check<OpticalFlowTrackerTrackingSate>(&state);
         TrackerBase::_tracking_state_recover(state);
+        _reset_pending_flow();
         m_motion_predict->set_prev_image(optical_state->m_prev_img);
     }
 
@@ -14,6 +14,7 @@ void SimpleSortTrackerParam::copy_to(TrackerParam &p) const
         m->m_max_gating_distance = m_max_gating_distance;
         m->m_base_gating_threshold = m_base_gating_threshold;
         m->m_alpha_smooth_features = m_alpha_smooth_features;
+        m->m_feature_projection_file = m_feature_projection_file;
         m->m_gating_dist_lambda = m_gating_dist_lambda;
         m->m_duplicate_iou_dist = m_duplicate_iou_dist;
         m_kalman_param.copy_to(m->m_kalman_param);
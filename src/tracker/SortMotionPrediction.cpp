@@ -4,60 +4,58 @@
 #include "RedoxiTrack/tracker/SortMotionPrediction.h"
 
 namespace RedoxiTrack{
-    void SortMotionPrediction::init(cv::KalmanFilter &kf, const BBOX &bbox) {
+    void SortMotionPrediction::init(KalmanFilter &kf, const BBOX &bbox) {
         m_stateNum = 7;
         m_measureNum = 4;
-        m_update_measurement = cv::Mat::zeros(m_measureNum, 1, CV_32F);
-        kf = cv::KalmanFilter(m_stateNum, m_measureNum, 0);
+        m_update_measurement.setZero();
+        // the 7 states [cx,cy,s,r,vcx,vcy,vs] use the top left block of the 8 state filter,
+        // the last state has no transition, noise or covariance so it never couples with the others
+        kf = KalmanFilter();
 
-        kf.transitionMatrix = (cv::Mat_<float>(m_stateNum, m_stateNum) << 1, 0, 0, 0, 1, 0, 0,
-                0, 1, 0, 0, 0, 1, 0,
-                0, 0, 1, 0, 0, 0, 1,
-                0, 0, 0, 1, 0, 0, 0,
-                0, 0, 0, 0, 1, 0, 0,
-                0, 0, 0, 0, 0, 1, 0,
-                0, 0, 0, 0, 0, 0, 1);
+        kf.transition_matrix.setIdentity();
+        kf.transition_matrix.block<3, 3>(0, 4).setIdentity();
 
-        setIdentity(kf.measurementMatrix);
-        setIdentity(kf.processNoiseCov, cv::Scalar::all(1e-2));
-        setIdentity(kf.measurementNoiseCov, cv::Scalar::all(1e-1));
-        setIdentity(kf.errorCovPost, cv::Scalar::all(1));
+        kf.measurement_matrix.setIdentity();
+        kf.process_noise_cov.setZero();
+        kf.process_noise_cov.topLeftCorner<7, 7>().diagonal().setConstant(1e-2);
+        kf.measurement_noise_cov.setIdentity();
+        kf.measurement_noise_cov *= 1e-1;
+        kf.error_cov_post.setZero();
+        kf.error_cov_post.topLeftCorner<7, 7>().setIdentity();
 
         // initialize state vector with bounding box in [cx,cy,s,r] style
-        kf.statePost.at<float>(0, 0) = bbox.x + bbox.width / 2.f;
-        kf.statePost.at<float>(1, 0) = bbox.y + bbox.height / 2.f;
-        kf.statePost.at<float>(2, 0) = bbox.area();
-        kf.statePost.at<float>(3, 0) = (float)bbox.width / (float)bbox.height;
+        kf.state_post(0) = bbox.x + bbox.width / 2.f;
+        kf.state_post(1) = bbox.y + bbox.height / 2.f;
+        kf.state_post(2) = bbox.area();
+        kf.state_post(3) = (float)bbox.width / (float)bbox.height;
     }
 
-    void SortMotionPrediction::predict(cv::KalmanFilter &kf, BBOX &output_bbox, int delta_frame_number, const bool flag) {
-        cv::Mat p = kf.predict();
-        _get_rect_from_xysr(p.at<float>(0, 0), p.at<float>(1, 0),
-                                   p.at<float>(2, 0), p.at<float>(3, 0),
-                                   output_bbox);
+    void SortMotionPrediction::predict(KalmanFilter &kf, BBOX &output_bbox, int delta_frame_number, const bool flag) {
+        // KalmanTracker writes the frame step into A(3, 7), which would couple r with the unused state
+        kf.transition_matrix(3, 7) = 0;
+        const KalmanFilter::StateVector &p = kf.predict();
+        _get_rect_from_xysr(p(0), p(1), p(2), p(3), output_bbox);
     }
 
-    void SortMotionPrediction::update(cv::KalmanFilter &kf, const BBOX &bbox) {
+    void SortMotionPrediction::update(KalmanFilter &kf, const BBOX &bbox) {
         // measurement
-        m_update_measurement.at<float>(0, 0) = bbox.x + bbox.width / 2.f;
-        m_update_measurement.at<float>(1, 0) = bbox.y + bbox.height / 2.f;
-        m_update_measurement.at<float>(2, 0) = bbox.area();
-        m_update_measurement.at<float>(3, 0) = (float)bbox.width / (float)bbox.height;
+        m_update_measurement(0) = bbox.x + bbox.width / 2.f;
+        m_update_measurement(1) = bbox.y + bbox.height / 2.f;
+        m_update_measurement(2) = bbox.area();
+        m_update_measurement(3) = (float)bbox.width / (float)bbox.height;
         // update
         kf.correct(m_update_measurement);
     }
 
-    void SortMotionPrediction::get_bbox_state(cv::KalmanFilter &kf, BBOX &output_bbox) {
-        const cv::Mat &s = kf.statePost;
-        _get_rect_from_xysr(s.at<float>(0, 0), s.at<float>(1, 0),
-                             s.at<float>(2, 0), s.at<float>(3, 0),
-                             output_bbox);
+    void SortMotionPrediction::get_bbox_state(KalmanFilter &kf, BBOX &output_bbox) {
+        const KalmanFilter::StateVector &s = kf.state_post;
+        _get_rect_from_xysr(s(0), s(1), s(2), s(3), output_bbox);
     }
 
-    void SortMotionPrediction::project_state2measurement(cv::KalmanFilter &kf, cv::Mat &output_mean,
-                                                         cv::Mat &output_covariance) const {
-        output_mean = kf.measurementMatrix * kf.statePre;
-        output_covariance = kf.measurementMatrix * kf.errorCovPre * kf.measurementMatrix.t();
+    void SortMotionPrediction::project_state2measurement(KalmanFilter &kf, KalmanFilter::MeasureVector &output_mean,
+                                                         KalmanFilter::MeasureMatrix &output_covariance) const {
+        output_mean.noalias() = kf.measurement_matrix * kf.state_pre;
+        output_covariance.noalias() = kf.measurement_matrix * kf.error_cov_pre * kf.measurement_matrix.transpose();
     }
 
     void SortMotionPrediction::_get_rect_from_xysr(float cx, float cy, float s, float r, BBOX &output_bbox) {
@@ -1,6 +1,10 @@
 #include "RedoxiTrack/tracker/TrackerBase.h"
+#include "RedoxiTrack/detection/SingleDetection.h"
+#include "RedoxiTrack/utils/FeatureTraits.h"
 #include "RedoxiTrack/external/Hungarian.h"
 
+#include <algorithm>
+
 namespace RedoxiTrack
 {
 
@@ -56,6 +60,130 @@ void TrackerBase::_tracking_state_recover(const TrackerTrackingState &state)
     m_frame_number = state.m_frame_number;
 }
 
+void TrackerBase::_project_features(const std::vector<DetectionPtr> &detections, const FeatureTraits *traits)
+{
+    if (!traits || !traits->get_projection() || traits->get_projection()->empty())
+        return;
+    const FeatureProjection &projection = *traits->get_projection();
+
+    std::vector<SingleDetection *> projected;
+    for (auto &det : detections) {
+        if (det->has_feature() && det->feature_view().size() == projection.input_dim())
+            projected.push_back(dyncast_with_check<SingleDetection>(det.get(), "feature projection needs SingleDetection"));
+    }
+    if (projected.empty())
+        return;
+
+    m_projection_input.resize(projected.size(), projection.input_dim());
+    for (size_t i = 0; i < projected.size(); i++)
+        m_projection_input.row(i) = projected[i]->feature_view().transpose();
+    projection.project(m_projection_input, m_projection_output);
+    for (size_t i = 0; i < projected.size(); i++)
+        projected[i]->set_feature(m_projection_output.row(i).transpose());
+}
+
+void TrackerBase::_pack_features(const std::vector<DetectionPtr> &detections, const FeatureTraits *traits)
+{
+    if (!traits)
+        return;
+    for (auto &det : detections) {
+        if (_get_packed_feature(*det, *traits) == &m_pack_output)
+            dyncast_with_check<SingleDetection>(det.get(), "feature packing needs SingleDetection")
+                ->set_packed_feature(m_pack_output);
+    }
+}
+
+void TrackerBase::_pack_feature(SingleDetection &item, const FeatureTraits &traits, bool normalize)
+{
+    PackedFeatures::Precision precision;
+    if (!item.has_feature() || !traits.get_packed_precision(precision))
+        return;
+    m_pack_input = item.feature_view();
+    if (normalize)
+        traits.normalize(m_pack_input);
+    traits.pack_feature(m_pack_input, m_pack_output);
+    item.set_packed_feature(m_pack_output);
+}
+
+const PackedFeatures *TrackerBase::_get_packed_feature(const Detection &item, const FeatureTraits &traits)
+{
+    PackedFeatures::Precision precision;
+    if (!item.has_feature() || !traits.get_packed_precision(precision))
+        return nullptr;
+    const PackedFeatures *packed = item.packed_feature();
+    if (packed && packed->precision == precision && packed->dim == item.feature_view().size())
+        return packed;
+    m_pack_input = item.feature_view();
+    traits.normalize(m_pack_input);
+    traits.pack_feature(m_pack_input, m_pack_output);
+    return &m_pack_output;
+}
+
+void TrackerBase::_compute_appearance_distance(DetectionTraits &comparison, const std::vector<DetectionPtr> &sources,
+                                               const std::vector<TrackTargetPtr> &targets,
+                                               const CandidatePairs *candidates, CostMatrix &output)
+{
+    m_source_ptrs.resize(sources.size());
+    for (size_t i = 0; i < sources.size(); i++)
+        m_source_ptrs[i] = sources[i].get();
+    m_target_ptrs.resize(targets.size());
+    for (size_t j = 0; j < targets.size(); j++)
+        m_target_ptrs[j] = targets[j].get();
+
+    if (candidates)
+        comparison.compute_distance_matrix(m_source_ptrs.data(), sources.size(), m_target_ptrs.data(), targets.size(),
+                                           *candidates, output);
+    else
+        comparison.compute_distance_matrix(m_source_ptrs.data(), sources.size(), m_target_ptrs.data(), targets.size(),
+                                           output);
+}
+
+void TrackerBase::_compute_target_feature_distance(const FeatureTraits &traits, FeatureGallery *gallery,
+                                                   FeatureGallery::QueryMode mode, const Detection *const *a,
+                                                   size_t size_a, const Detection *const *b, size_t size_b,
+                                                   const CandidatePairs *candidates, CostMatrix &output)
+{
+    // the target features are already normalized by add_target(), and packed if traits compares packed features
+    m_source_features.assign(a, size_a, &traits);
+
+    // with galleries the smoothed features are only needed by targets that have no gallery,
+    // e.g. after theirs was dropped for a newer target
+    bool use_gallery = gallery && gallery->get_capacity() > 0;
+    bool all_in_gallery = use_gallery;
+    m_gallery_ids.resize(size_b);
+    for (size_t j = 0; use_gallery && j < size_b; j++) {
+        m_gallery_ids[j] = dyncast_with_check<TrackTarget>(b[j])->get_path_id();
+        all_in_gallery = all_in_gallery && gallery->contains(m_gallery_ids[j]);
+    }
+    if (all_in_gallery) {
+        if (candidates)
+            output.assign(size_a, size_b, traits.max_distance());
+        else
+            output.resize(size_a, size_b);
+    } else {
+        m_target_features.assign(b, size_b, &traits, false);
+        if (candidates)
+            traits.compute_distance_matrix(m_source_features, m_target_features, *candidates, output);
+        else
+            traits.compute_distance_matrix(m_source_features, m_target_features, output);
+    }
+    if (use_gallery)
+        gallery->compute_distance_matrix(m_source_features, m_gallery_ids, traits, mode, candidates, output);
+}
+
+void TrackerBase::_parallel_rows(size_t rows, size_t cols, const std::function<void(size_t, size_t)> &fn) const
+{
+    const size_t min_pairs = m_param ? (size_t)std::max(m_param->m_parallel_min_pairs, 0) : 0;
+    if (!m_thread_pool || m_thread_pool->get_num_threads() == 0 || rows < 2 || rows * cols < min_pairs) {
+        if (rows > 0)
+            fn(0, rows);
+        return;
+    }
+    // tiles of about 8k elements, enough work per tile to pay for the hand-over, several tiles per thread
+    const size_t tile_pairs = 8192;
+    m_thread_pool->parallel_for(rows, std::max<size_t>(1, tile_pairs / std::max<size_t>(cols, 1)), fn);
+}
+
 void TrackerBase::reset_tracking_state()
 {
     init(*m_param);
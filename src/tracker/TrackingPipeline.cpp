@@ -0,0 +1,244 @@
+#include "RedoxiTrack/tracker/TrackingPipeline.h"
+
+#include <algorithm>
+
+namespace RedoxiTrack
+{
+
+namespace
+{
+// spin a little, frames are usually a few milliseconds apart, then sleep in short steps
+void backoff(int &num_waits)
+{
+    if (num_waits++ < 64)
+        std::this_thread::yield();
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+} // namespace
+
+TrackingPipeline::~TrackingPipeline()
+{
+    if (m_threads.empty())
+        return;
+    m_aborted = true;
+    for (auto &t : m_threads)
+        t.join();
+}
+
+void TrackingPipeline::init(const TrackerBasePtr &tracker,
+                            const TrackingPipelineParam &param)
+{
+    assert_throw(!is_running(), "the pipeline is running");
+    assert_throw(tracker != nullptr, "the tracker of a pipeline must not be null");
+    m_tracker = tracker;
+    m_param = param;
+}
+
+void TrackingPipeline::start(const DecodeFunction &decode,
+                             const DetectFunction &detect,
+                             const SinkFunction &sink)
+{
+    assert_throw(m_threads.empty(), "the pipeline is already started");
+    assert_throw(m_tracker != nullptr, "the pipeline is not initialized");
+    assert_throw(decode && detect, "the decode and detect functions must be set");
+    m_decode = decode;
+    m_detect = detect;
+    m_sink = sink;
+
+    for (int i = 0; i < NumStages; i++) {
+        m_queues[i].reset(i == Decode ? nullptr
+                                      : new Ring(std::max(m_param.m_queue_capacity, 2)));
+        m_closed[i] = false;
+        m_counters[i].num_frames = 0;
+        m_counters[i].num_dropped = 0;
+        m_counters[i].max_queue_depth = 0;
+        m_counters[i].busy_time = 0;
+    }
+    m_stop_requested = false;
+    m_aborted = false;
+    m_error = nullptr;
+
+    m_start_time = Clock::now();
+    m_running = true;
+    m_threads.emplace_back(&TrackingPipeline::_run_stage, this, &TrackingPipeline::_decode_loop);
+    m_threads.emplace_back(&TrackingPipeline::_run_stage, this, &TrackingPipeline::_detect_loop);
+    m_threads.emplace_back(&TrackingPipeline::_run_stage, this, &TrackingPipeline::_track_loop);
+    m_threads.emplace_back(&TrackingPipeline::_run_stage, this, &TrackingPipeline::_sink_loop);
+}
+
+void TrackingPipeline::wait()
+{
+    for (auto &t : m_threads)
+        t.join();
+    m_threads.clear();
+    if (m_running) {
+        m_end_time = Clock::now();
+        m_running = false;
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_error_mutex);
+        std::swap(error, m_error);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void TrackingPipeline::stop()
+{
+    m_stop_requested = true;
+    wait();
+}
+
+PipelineStageStats TrackingPipeline::get_stage_stats(Stage stage) const
+{
+    PipelineStageStats output;
+    const StageCounters &counters = m_counters[stage];
+    output.num_frames = counters.num_frames;
+    output.num_dropped = counters.num_dropped;
+    output.max_queue_depth = counters.max_queue_depth;
+    output.busy_time = counters.busy_time * 1e-9;
+    if (m_queues[stage])
+        output.queue_depth = m_queues[stage]->size();
+    Clock::time_point end = m_running ? Clock::now() : m_end_time;
+    output.elapsed_time = std::chrono::duration<double>(end - m_start_time).count();
+    return output;
+}
+
+void TrackingPipeline::_decode_loop()
+{
+    int frame_number = 0;
+    while (!m_stop_requested && !m_aborted) {
+        PipelineFrame frame;
+        Clock::time_point start = Clock::now();
+        if (!m_decode(frame.img))
+            break;
+        _add_busy_time(Decode, start);
+        frame.frame_number = frame_number++;
+        m_counters[Decode].num_frames++;
+        if (!_push(Detect, frame))
+            break;
+    }
+    _close(Detect);
+}
+
+void TrackingPipeline::_detect_loop()
+{
+    PipelineFrame frame;
+    while (_pop(Detect, frame)) {
+        Clock::time_point start = Clock::now();
+        m_detect(frame);
+        _add_busy_time(Detect, start);
+        m_counters[Detect].num_frames++;
+        if (!_push(Track, frame))
+            break;
+    }
+    _close(Track);
+}
+
+void TrackingPipeline::_track_loop()
+{
+    bool started = false;
+    PipelineFrame frame;
+    while (_pop(Track, frame)) {
+        Clock::time_point start = Clock::now();
+        if (started)
+            m_tracker->track(frame.img, frame.detections, frame.frame_number);
+        else
+            m_tracker->begin_track(frame.img, frame.detections, frame.frame_number);
+        started = true;
+
+        // the tracker changes its targets on the next frame while the sink still reads these,
+        // the underlying detections are shared, they are not changed after their frame
+        for (auto &p : m_tracker->get_all_open_targets())
+            frame.targets[p.first] = std::dynamic_pointer_cast<TrackTarget>(p.second->clone(false));
+        _add_busy_time(Track, start);
+        m_counters[Track].num_frames++;
+        if (!_push(Sink, frame))
+            break;
+    }
+    if (started)
+        m_tracker->finish_track();
+    _close(Sink);
+}
+
+void TrackingPipeline::_sink_loop()
+{
+    PipelineFrame frame;
+    while (_pop(Sink, frame)) {
+        Clock::time_point start = Clock::now();
+        if (m_sink)
+            m_sink(frame);
+        _add_busy_time(Sink, start);
+        m_counters[Sink].num_frames++;
+    }
+}
+
+void TrackingPipeline::_run_stage(void (TrackingPipeline::*loop)())
+{
+    try {
+        (this->*loop)();
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(m_error_mutex);
+            if (!m_error)
+                m_error = std::current_exception();
+        }
+        m_aborted = true;
+    }
+}
+
+bool TrackingPipeline::_push(Stage stage, PipelineFrame &frame)
+{
+    Ring &ring = *m_queues[stage];
+    bool drop_oldest = (stage == Detect && m_param.m_detect_queue_policy == PipelineQueuePolicy::DropOldest) ||
+                       (stage == Track && m_param.m_track_queue_policy == PipelineQueuePolicy::DropOldest) ||
+                       (stage == Sink && m_param.m_sink_queue_policy == PipelineQueuePolicy::DropOldest);
+    int num_waits = 0;
+    while (!ring.try_push(frame)) {
+        if (m_aborted)
+            return false;
+        // only drop while the ring is full, a push can also fail while the consumer still moves out
+        // the oldest frame, dropping then would take one more
+        PipelineFrame oldest;
+        if (drop_oldest && ring.size() >= ring.capacity() && ring.try_pop(oldest))
+            m_counters[stage].num_dropped++;
+        else
+            backoff(num_waits);
+    }
+    // only this thread pushes to the ring, so a plain maximum is enough
+    size_t depth = ring.size();
+    if (depth > m_counters[stage].max_queue_depth)
+        m_counters[stage].max_queue_depth = depth;
+    return true;
+}
+
+bool TrackingPipeline::_pop(Stage stage, PipelineFrame &frame)
+{
+    Ring &ring = *m_queues[stage];
+    int num_waits = 0;
+    while (!m_aborted) {
+        if (ring.try_pop(frame))
+            return true;
+        // the last frames were pushed before the ring was closed
+        if (m_closed[stage])
+            return ring.try_pop(frame);
+        backoff(num_waits);
+    }
+    return false;
+}
+
+void TrackingPipeline::_close(Stage stage)
+{
+    m_closed[stage] = true;
+}
+
+void TrackingPipeline::_add_busy_time(Stage stage, Clock::time_point start)
+{
+    m_counters[stage].busy_time +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+} // namespace RedoxiTrack
@@ -19,6 +19,43 @@ namespace RedoxiTrack{
         *output = (wa*fa_normal+wb*fb_normal).normalized();
     }
 
+    void CosineFeature::normalize(Eigen::Ref<fVECTOR> feature) const {
+        feature.normalize();
+    }
+
+    void CosineFeature::compute_distance_matrix(const FeatureArray &a, const FeatureArray &b, CostMatrix &output) const {
+        output.resize(a.size(), b.size());
+        if (output.empty())
+            return;
+        if (a.dim() == 0 || b.dim() == 0) {
+            output.fill(max_distance());
+            return;
+        }
+        assert_throw(a.dim() == b.dim(), "features of different sizes can not be compared");
+        // one blocked product written straight into the padded rows of output
+        Eigen::Map<fMATRIX, 0, Eigen::OuterStride<>> dot(output.data(), a.size(), b.size(),
+                                                          Eigen::OuterStride<>(output.stride()));
+        dot.noalias() = a.features * b.features.transpose();
+        dot = (1 - dot.array()) / 2;
+        _fill_missing(a, b, output);
+    }
+
+    void CosineFeature::compute_distance_matrix(const FeatureArray &a, const FeatureArray &b,
+                                                const CandidatePairs &candidates, CostMatrix &output) const {
+        assert_throw(candidates.num_sources() == (int)a.size(), "candidate pairs do not match the sources");
+        output.assign(a.size(), b.size(), max_distance());
+        for (size_t i = 0; i < a.size(); i++) {
+            if (!a.has_feature[i])
+                continue;
+            float *row = output.row(i);
+            for (int k = candidates.offsets[i]; k < candidates.offsets[i + 1]; k++) {
+                const int j = candidates.targets[k];
+                if (b.has_feature[j])
+                    row[j] = (1 - a.features.row(i).dot(b.features.row(j))) / 2;
+            }
+        }
+    }
+
     double CosineFeature::max_distance() const {
         return 1;
     }
@@ -0,0 +1,88 @@
+#include "RedoxiTrack/utils/CostMatrix.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace RedoxiTrack
+{
+
+CostMatrix::CostMatrix(int rows, int cols, float value)
+{
+    assign(rows, cols, value);
+}
+
+CostMatrix::CostMatrix(const CostMatrix &other)
+{
+    *this = other;
+}
+
+CostMatrix::CostMatrix(CostMatrix &&other) noexcept
+{
+    swap(other);
+}
+
+CostMatrix &CostMatrix::operator=(const CostMatrix &other)
+{
+    if (this == &other)
+        return *this;
+    resize(other.m_rows, other.m_cols);
+    for (int i = 0; i < m_rows; i++)
+        std::memcpy(row(i), other.row(i), m_cols * sizeof(float));
+    return *this;
+}
+
+CostMatrix &CostMatrix::operator=(CostMatrix &&other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+CostMatrix::~CostMatrix()
+{
+    if (m_data)
+        ::operator delete(m_data, std::align_val_t(Alignment));
+}
+
+void CostMatrix::resize(int rows, int cols)
+{
+    assert_throw(rows >= 0 && cols >= 0, "cost matrix shape must not be negative");
+
+    // pad each row to a whole number of aligned blocks
+    const size_t floats_per_block = Alignment / sizeof(float);
+    size_t stride = (cols + floats_per_block - 1) / floats_per_block * floats_per_block;
+    size_t required = stride * rows;
+    if (required > m_capacity) {
+        if (m_data)
+            ::operator delete(m_data, std::align_val_t(Alignment));
+        // grow geometrically so that a slowly growing scene does not reallocate every frame
+        size_t capacity = std::max(required, m_capacity * 2);
+        m_data = (float *)::operator new(capacity * sizeof(float), std::align_val_t(Alignment));
+        m_capacity = capacity;
+    }
+    m_stride = stride;
+    m_rows = rows;
+    m_cols = cols;
+}
+
+void CostMatrix::assign(int rows, int cols, float value)
+{
+    resize(rows, cols);
+    fill(value);
+}
+
+void CostMatrix::fill(float value)
+{
+    for (int i = 0; i < m_rows; i++)
+        std::fill(row(i), row(i) + m_cols, value);
+}
+
+void CostMatrix::swap(CostMatrix &other) noexcept
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_capacity, other.m_capacity);
+    std::swap(m_stride, other.m_stride);
+    std::swap(m_rows, other.m_rows);
+    std::swap(m_cols, other.m_cols);
+}
+
+} // namespace RedoxiTrack
@@ -0,0 +1,180 @@
+#include "RedoxiTrack/utils/FeatureGallery.h"
+
+#include <algorithm>
+
+namespace RedoxiTrack
+{
+
+void FeatureGallery::init(int capacity, int max_tracks)
+{
+    assert_throw(capacity >= 0 && max_tracks >= 0, "gallery capacity and max tracks must not be negative");
+    m_capacity = capacity;
+    m_max_tracks = capacity > 0 ? max_tracks : 0;
+    m_slab.resize(0, 0);
+    m_packed_slab.clear();
+    clear();
+}
+
+void FeatureGallery::clear()
+{
+    m_slots.assign(m_max_tracks, Slot());
+    m_free_slots.resize(m_max_tracks);
+    // hand out the lowest slots first
+    for (int k = 0; k < m_max_tracks; k++)
+        m_free_slots[k] = m_max_tracks - 1 - k;
+    m_path2slot.clear();
+    m_clock = 0;
+}
+
+void FeatureGallery::add(int path_id, const fVECTOR &feature)
+{
+    if (m_capacity == 0 || m_max_tracks == 0 || feature.size() == 0)
+        return;
+    assert_throw(m_packed_slab.dim == 0, "float and packed features can not be kept in one gallery");
+    if (m_slab.cols() == 0)
+        m_slab.setZero((Eigen::Index)m_max_tracks * m_capacity, feature.size());
+    assert_throw(m_slab.cols() == feature.size(), "features of different sizes can not be kept in one gallery");
+    m_slab.row(_next_row(path_id)) = feature.transpose();
+}
+
+void FeatureGallery::add(int path_id, const PackedFeatures &feature)
+{
+    if (m_capacity == 0 || m_max_tracks == 0 || feature.dim == 0)
+        return;
+    assert_throw(m_slab.cols() == 0, "float and packed features can not be kept in one gallery");
+    if (m_packed_slab.dim == 0)
+        m_packed_slab.reset(feature.precision, feature.dim, (size_t)m_max_tracks * m_capacity);
+    assert_throw(m_packed_slab.precision == feature.precision && m_packed_slab.dim == feature.dim,
+                 "features of different sizes can not be kept in one gallery");
+    m_packed_slab.copy_row(_next_row(path_id), feature, 0);
+}
+
+int FeatureGallery::_next_row(int path_id)
+{
+    auto it = m_path2slot.find(path_id);
+    int slot_index = it != m_path2slot.end() ? it->second : _acquire_slot(path_id);
+    Slot &slot = m_slots[slot_index];
+    const int row = slot_index * m_capacity + slot.head;
+    slot.head = (slot.head + 1) % m_capacity;
+    slot.count = std::min(slot.count + 1, m_capacity);
+    slot.last_update = ++m_clock;
+    return row;
+}
+
+void FeatureGallery::remove(int path_id)
+{
+    auto it = m_path2slot.find(path_id);
+    if (it == m_path2slot.end())
+        return;
+    m_slots[it->second] = Slot();
+    m_free_slots.push_back(it->second);
+    m_path2slot.erase(it);
+}
+
+int FeatureGallery::get_size(int path_id) const
+{
+    auto it = m_path2slot.find(path_id);
+    return it == m_path2slot.end() ? 0 : m_slots[it->second].count;
+}
+
+int FeatureGallery::_acquire_slot(int path_id)
+{
+    int slot_index = 0;
+    if (!m_free_slots.empty()) {
+        slot_index = m_free_slots.back();
+        m_free_slots.pop_back();
+    } else {
+        // drop the gallery that was updated least recently
+        for (int k = 1; k < m_max_tracks; k++) {
+            if (m_slots[k].last_update < m_slots[slot_index].last_update)
+                slot_index = k;
+        }
+        m_path2slot.erase(m_slots[slot_index].path_id);
+    }
+    m_slots[slot_index] = Slot();
+    m_slots[slot_index].path_id = path_id;
+    m_path2slot[path_id] = slot_index;
+    return slot_index;
+}
+
+void FeatureGallery::compute_distance_matrix(const FeatureArray &a, const std::vector<int> &path_ids,
+                                             const FeatureTraits &traits, QueryMode mode,
+                                             const CandidatePairs *candidates, CostMatrix &output)
+{
+    assert_throw(output.rows() == (int)a.size() && output.cols() == (int)path_ids.size(),
+                 "output must be sized to the sources and the galleries");
+    assert_throw(!candidates || candidates->num_sources() == (int)a.size(), "candidate pairs do not match the sources");
+
+    // gather the queried galleries so that one distance matrix covers all of them
+    m_offsets.resize(path_ids.size() + 1);
+    m_offsets[0] = 0;
+    for (size_t j = 0; j < path_ids.size(); j++)
+        m_offsets[j + 1] = m_offsets[j] + get_size(path_ids[j]);
+    const int total = m_offsets.back();
+    if (total == 0)
+        return;
+
+    m_gathered.has_feature.assign(total, 1);
+    if (m_packed_slab.dim != 0) {
+        m_gathered.features.resize(total, 0);
+        m_gathered.packed.reset(m_packed_slab.precision, m_packed_slab.dim, total);
+    } else {
+        m_gathered.features.resize(total, m_slab.cols());
+        m_gathered.packed.clear();
+    }
+    for (size_t j = 0; j < path_ids.size(); j++) {
+        if (m_offsets[j] == m_offsets[j + 1])
+            continue;
+        const int first = m_path2slot[path_ids[j]] * m_capacity;
+        const int count = m_offsets[j + 1] - m_offsets[j];
+        if (m_packed_slab.dim != 0) {
+            for (int r = 0; r < count; r++)
+                m_gathered.packed.copy_row(m_offsets[j] + r, m_packed_slab, first + r);
+        } else
+            m_gathered.features.middleRows(m_offsets[j], count) = m_slab.middleRows(first, count);
+    }
+
+    if (candidates) {
+        // every gallery row of a candidate target becomes a candidate, rows stay in ascending order
+        m_gathered_candidates.offsets.resize(a.size() + 1);
+        m_gathered_candidates.targets.clear();
+        m_gathered_candidates.offsets[0] = 0;
+        for (size_t i = 0; i < a.size(); i++) {
+            for (int k = candidates->offsets[i]; k < candidates->offsets[i + 1]; k++) {
+                const int j = candidates->targets[k];
+                for (int r = m_offsets[j]; r < m_offsets[j + 1]; r++)
+                    m_gathered_candidates.targets.push_back(r);
+            }
+            m_gathered_candidates.offsets[i + 1] = (int)m_gathered_candidates.targets.size();
+        }
+        traits.compute_distance_matrix(a, m_gathered, m_gathered_candidates, m_distances);
+    } else
+        traits.compute_distance_matrix(a, m_gathered, m_distances);
+
+    auto reduce = [&](int i, int j) {
+        const float *row = m_distances.row(i);
+        if (mode == QueryMode::Min)
+            return *std::min_element(row + m_offsets[j], row + m_offsets[j + 1]);
+        float sum = 0;
+        for (int r = m_offsets[j]; r < m_offsets[j + 1]; r++)
+            sum += row[r];
+        return sum / (m_offsets[j + 1] - m_offsets[j]);
+    };
+    for (size_t i = 0; i < a.size(); i++) {
+        float *out_row = output.row(i);
+        if (candidates) {
+            for (int k = candidates->offsets[i]; k < candidates->offsets[i + 1]; k++) {
+                const int j = candidates->targets[k];
+                if (m_offsets[j] != m_offsets[j + 1])
+                    out_row[j] = reduce(i, j);
+            }
+        } else {
+            for (size_t j = 0; j < path_ids.size(); j++) {
+                if (m_offsets[j] != m_offsets[j + 1])
+                    out_row[j] = reduce(i, j);
+            }
+        }
+    }
+}
+
+} // namespace RedoxiTrack
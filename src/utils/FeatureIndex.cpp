@@ -0,0 +1,230 @@
+#include "RedoxiTrack/utils/FeatureIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace RedoxiTrack
+{
+
+FeatureIndex::FeatureIndex(int max_neighbors, int ef_construction)
+    : m_max_neighbors(std::max(2, max_neighbors)), m_ef_construction(std::max(1, ef_construction)),
+      m_level_mult(1.0 / std::log((double)m_max_neighbors)), m_rng(12345)
+{
+}
+
+void FeatureIndex::clear()
+{
+    m_dim = 0;
+    m_features.clear();
+    m_nodes.clear();
+    m_key2node.clear();
+    m_num_removed = 0;
+    m_entry = -1;
+}
+
+float FeatureIndex::_distance(const float *a, const float *b) const
+{
+    return 1.f - Eigen::Map<const fVECTOR>(a, m_dim).dot(Eigen::Map<const fVECTOR>(b, m_dim));
+}
+
+void FeatureIndex::add(int key, const Eigen::Ref<const fVECTOR> &feature)
+{
+    assert_throw(feature.size() > 0, "can not index an empty feature");
+    if (m_dim == 0)
+        m_dim = (int)feature.size();
+    assert_throw(feature.size() == m_dim, "features of different sizes can not be indexed together");
+    remove(key);
+
+    int node = (int)m_nodes.size();
+    m_features.insert(m_features.end(), feature.data(), feature.data() + m_dim);
+    m_nodes.emplace_back();
+    m_nodes[node].key = key;
+    m_key2node[key] = node;
+    _insert(node);
+}
+
+void FeatureIndex::remove(int key)
+{
+    auto it = m_key2node.find(key);
+    if (it == m_key2node.end())
+        return;
+    m_nodes[it->second].removed = true;
+    m_key2node.erase(it);
+    m_num_removed++;
+    if (m_key2node.empty())
+        clear();
+    else if (m_num_removed > m_key2node.size() && m_num_removed >= 64)
+        _rebuild();
+}
+
+void FeatureIndex::_rebuild()
+{
+    std::vector<float> features;
+    std::vector<int> keys;
+    features.reserve(m_key2node.size() * m_dim);
+    for (size_t i = 0; i < m_nodes.size(); i++) {
+        if (m_nodes[i].removed)
+            continue;
+        features.insert(features.end(), _feature((int)i), _feature((int)i) + m_dim);
+        keys.push_back(m_nodes[i].key);
+    }
+
+    int dim = m_dim;
+    clear();
+    m_dim = dim;
+    m_features.swap(features);
+    m_nodes.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        m_nodes[i].key = keys[i];
+        m_key2node[keys[i]] = (int)i;
+        _insert((int)i);
+    }
+}
+
+void FeatureIndex::_insert(int node)
+{
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    int level = (int)(-std::log(std::max(uniform(m_rng), 1e-12)) * m_level_mult);
+    m_nodes[node].links.resize(level + 1);
+    if (m_entry < 0) {
+        m_entry = node;
+        return;
+    }
+
+    const float *q = _feature(node);
+    int entry = m_entry;
+    int top = (int)m_nodes[m_entry].links.size() - 1;
+    std::vector<Candidate> found;
+    // greedy descent through the layers above the new node
+    for (int l = top; l > level; l--) {
+        _search_layer(q, entry, 1, l, found);
+        entry = found[0].second;
+    }
+
+    std::vector<int> selected;
+    std::vector<Candidate> candidates;
+    for (int l = std::min(level, top); l >= 0; l--) {
+        _search_layer(q, entry, m_ef_construction, l, found);
+        _select_neighbors(found, m_max_neighbors, selected);
+        m_nodes[node].links[l] = selected;
+        for (int nb : selected) {
+            auto &links = m_nodes[nb].links[l];
+            links.push_back(node);
+            if ((int)links.size() <= _max_links(l))
+                continue;
+            // too many links, keep the best of them
+            candidates.clear();
+            for (int x : links)
+                candidates.emplace_back(_distance(_feature(nb), _feature(x)), x);
+            std::sort(candidates.begin(), candidates.end());
+            _select_neighbors(candidates, _max_links(l), links);
+        }
+        entry = found[0].second;
+    }
+    if (level > top)
+        m_entry = node;
+}
+
+void FeatureIndex::_search_layer(const float *q, int entry, int ef, int level, std::vector<Candidate> &output) const
+{
+    if (m_visited.size() < m_nodes.size())
+        m_visited.resize(m_nodes.size(), 0);
+    if (++m_visit_mark == 0) {
+        std::fill(m_visited.begin(), m_visited.end(), 0);
+        m_visit_mark = 1;
+    }
+
+    // nearest candidate on top of to_visit, farthest result on top of results
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> to_visit;
+    std::priority_queue<Candidate> results;
+    float d = _distance(q, _feature(entry));
+    to_visit.emplace(d, entry);
+    results.emplace(d, entry);
+    m_visited[entry] = m_visit_mark;
+    while (!to_visit.empty()) {
+        Candidate c = to_visit.top();
+        if (c.first > results.top().first && (int)results.size() >= ef)
+            break;
+        to_visit.pop();
+        for (int nb : m_nodes[c.second].links[level]) {
+            if (m_visited[nb] == m_visit_mark)
+                continue;
+            m_visited[nb] = m_visit_mark;
+            float dn = _distance(q, _feature(nb));
+            if ((int)results.size() < ef || dn < results.top().first) {
+                to_visit.emplace(dn, nb);
+                results.emplace(dn, nb);
+                if ((int)results.size() > ef)
+                    results.pop();
+            }
+        }
+    }
+
+    output.resize(results.size());
+    for (size_t i = output.size(); i > 0; i--) {
+        output[i - 1] = results.top();
+        results.pop();
+    }
+}
+
+void FeatureIndex::_select_neighbors(const std::vector<Candidate> &candidates, int m, std::vector<int> &output) const
+{
+    std::vector<int> pruned;
+    std::vector<int> kept;
+    for (auto &c : candidates) {
+        if ((int)kept.size() >= m)
+            break;
+        bool good = true;
+        for (int r : kept) {
+            if (_distance(_feature(c.second), _feature(r)) < c.first) {
+                good = false;
+                break;
+            }
+        }
+        if (good)
+            kept.push_back(c.second);
+        else
+            pruned.push_back(c.second);
+    }
+    // fill up with the nearest pruned ones
+    for (size_t i = 0; i < pruned.size() && (int)kept.size() < m; i++)
+        kept.push_back(pruned[i]);
+    output.swap(kept);
+}
+
+void FeatureIndex::search(const Eigen::Ref<const fVECTOR> &query, int k, int ef,
+                          std::vector<std::pair<float, int>> &output) const
+{
+    output.clear();
+    if (m_key2node.empty() || k <= 0)
+        return;
+    assert_throw(query.size() == m_dim, "the query and the indexed features have different sizes");
+    const fVECTOR q = query;
+    ef = std::max(ef, k);
+
+    if (m_key2node.size() <= (size_t)ef) {
+        for (auto &p : m_key2node)
+            output.emplace_back(_distance(q.data(), _feature(p.second)), p.first);
+    } else {
+        int entry = m_entry;
+        std::vector<Candidate> found;
+        for (int l = (int)m_nodes[m_entry].links.size() - 1; l > 0; l--) {
+            _search_layer(q.data(), entry, 1, l, found);
+            entry = found[0].second;
+        }
+        _search_layer(q.data(), entry, ef, 0, found);
+        for (auto &c : found) {
+            if (!m_nodes[c.second].removed)
+                output.emplace_back(c.first, m_nodes[c.second].key);
+        }
+    }
+
+    std::sort(output.begin(), output.end());
+    if ((int)output.size() > k)
+        output.resize(k);
+    for (auto &p : output)
+        p.first /= 2;
+}
+
+} // namespace RedoxiTrack
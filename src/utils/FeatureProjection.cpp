@@ -0,0 +1,114 @@
+#include "RedoxiTrack/utils/FeatureProjection.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace RedoxiTrack
+{
+
+namespace
+{
+// file layout: magic, version, input_dim, output_dim (int32), then mean and row-major components (float32)
+const char ProjectionMagic[8] = {'R', 'X', 'T', 'P', 'R', 'O', 'J', '\0'};
+const int32_t ProjectionVersion = 1;
+} // namespace
+
+void FeatureProjection::set(const fVECTOR &mean, const fMATRIX &components)
+{
+    assert_throw(components.rows() > 0 && components.cols() > 0, "the projection must not be empty");
+    assert_throw(mean.size() == components.cols(), "the mean and the components have different sizes");
+    m_mean = mean;
+    m_components = components;
+}
+
+double FeatureProjection::fit(const fMATRIX &samples, int output_dim, bool center)
+{
+    const Eigen::Index n = samples.rows();
+    const Eigen::Index dim = samples.cols();
+    assert_throw(n >= 2, "at least 2 samples are needed to fit a projection");
+    assert_throw(output_dim >= 1 && output_dim <= dim, "output_dim must be in 1 .. feature size");
+
+    // accumulate in double, a block of rows at a time so that the samples are not copied at once
+    Eigen::VectorXd mean = Eigen::VectorXd::Zero(dim);
+    if (center)
+        mean = samples.cast<double>().colwise().sum().transpose() / (double)n;
+    Eigen::MatrixXd covariance = Eigen::MatrixXd::Zero(dim, dim);
+    const Eigen::Index block = 4096;
+    for (Eigen::Index first = 0; first < n; first += block) {
+        Eigen::MatrixXd centered = samples.middleRows(first, std::min(block, n - first)).cast<double>();
+        centered.rowwise() -= mean.transpose();
+        covariance.selfadjointView<Eigen::Lower>().rankUpdate(centered.transpose());
+    }
+    covariance = covariance.selfadjointView<Eigen::Lower>();
+    covariance /= (double)(center ? n - 1 : n);
+
+    // eigenvalues in ascending order, keep the last output_dim
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(covariance);
+    assert_throw(solver.info() == Eigen::Success, "failed to decompose the covariance of the samples");
+    m_components.resize(output_dim, dim);
+    for (int k = 0; k < output_dim; k++) {
+        Eigen::VectorXd v = solver.eigenvectors().col(dim - 1 - k);
+        // the sign of an eigenvector is arbitrary, make the largest element positive so that fits are repeatable
+        Eigen::Index largest;
+        v.cwiseAbs().maxCoeff(&largest);
+        if (v[largest] < 0)
+            v = -v;
+        m_components.row(k) = v.cast<float>().transpose();
+    }
+    m_mean = mean.cast<float>();
+
+    double total = solver.eigenvalues().sum();
+    double kept = solver.eigenvalues().tail(output_dim).sum();
+    return total > 0 ? kept / total : 1.0;
+}
+
+void FeatureProjection::load(const std::string &path)
+{
+    std::ifstream input(path, std::ios::binary);
+    assert_throw(input.good(), "can not open the projection file " + path);
+
+    char magic[sizeof(ProjectionMagic)];
+    int32_t header[3];
+    input.read(magic, sizeof(magic));
+    input.read(reinterpret_cast<char *>(header), sizeof(header));
+    assert_throw(input.good() && std::memcmp(magic, ProjectionMagic, sizeof(magic)) == 0,
+                 "not a projection file: " + path);
+    assert_throw(header[0] == ProjectionVersion, "unsupported projection file version in " + path);
+    assert_throw(header[1] > 0 && header[2] > 0, "invalid projection size in " + path);
+
+    fVECTOR mean(header[1]);
+    fMATRIX components(header[2], header[1]);
+    input.read(reinterpret_cast<char *>(mean.data()), mean.size() * sizeof(float));
+    input.read(reinterpret_cast<char *>(components.data()), components.size() * sizeof(float));
+    assert_throw(input.good(), "truncated projection file " + path);
+    set(mean, components);
+}
+
+void FeatureProjection::save(const std::string &path) const
+{
+    assert_throw(!empty(), "can not save an empty projection");
+    std::ofstream output(path, std::ios::binary);
+    assert_throw(output.good(), "can not create the projection file " + path);
+
+    int32_t header[3] = {ProjectionVersion, (int32_t)input_dim(), (int32_t)output_dim()};
+    output.write(ProjectionMagic, sizeof(ProjectionMagic));
+    output.write(reinterpret_cast<const char *>(header), sizeof(header));
+    output.write(reinterpret_cast<const char *>(m_mean.data()), m_mean.size() * sizeof(float));
+    output.write(reinterpret_cast<const char *>(m_components.data()), m_components.size() * sizeof(float));
+    assert_throw(output.good(), "failed to write the projection file " + path);
+}
+
+void FeatureProjection::project(const Eigen::Ref<const fVECTOR> &input, fVECTOR &output) const
+{
+    assert_throw(input.size() == input_dim(), "the feature does not have the input size of the projection");
+    output.noalias() = m_components * (input - m_mean);
+}
+
+void FeatureProjection::project(const fMATRIX &input, fMATRIX &output) const
+{
+    assert_throw(input.cols() == input_dim(), "the features do not have the input size of the projection");
+    output.resize(input.rows(), output_dim());
+    output.noalias() = (input.rowwise() - m_mean.transpose()) * m_components.transpose();
+}
+
+} // namespace RedoxiTrack
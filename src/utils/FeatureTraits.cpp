@@ -0,0 +1,66 @@
+#include "RedoxiTrack/utils/FeatureTraits.h"
+
+namespace RedoxiTrack
+{
+
+void FeatureTraits::compute_distance_matrix(const FeatureArray &a, const FeatureArray &b, CostMatrix &output) const
+{
+    output.resize(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!a.has_feature[i])
+            continue;
+        fVECTOR fa = a.features.row(i).transpose();
+        float *row = output.row(i);
+        for (size_t j = 0; j < b.size(); j++) {
+            if (b.has_feature[j])
+                row[j] = distance(fa, b.features.row(j).transpose());
+        }
+    }
+    _fill_missing(a, b, output);
+}
+
+void FeatureTraits::compute_distance_matrix(const FeatureArray &a, const FeatureArray &b,
+                                            const CandidatePairs &candidates, CostMatrix &output) const
+{
+    assert_throw(candidates.num_sources() == (int)a.size(), "candidate pairs do not match the sources");
+    output.assign(a.size(), b.size(), max_distance());
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!a.has_feature[i])
+            continue;
+        fVECTOR fa = a.features.row(i).transpose();
+        float *row = output.row(i);
+        for (int k = candidates.offsets[i]; k < candidates.offsets[i + 1]; k++) {
+            const int j = candidates.targets[k];
+            if (b.has_feature[j])
+                row[j] = distance(fa, b.features.row(j).transpose());
+        }
+    }
+}
+
+void FeatureTraits::_fill_missing(const FeatureArray &a, const FeatureArray &b, CostMatrix &output) const
+{
+    const float max_dist = max_distance();
+    for (size_t i = 0; i < a.size(); i++) {
+        float *row = output.row(i);
+        if (!a.has_feature[i]) {
+            std::fill(row, row + b.size(), max_dist);
+            continue;
+        }
+        for (size_t j = 0; j < b.size(); j++) {
+            if (!b.has_feature[j])
+                row[j] = max_dist;
+        }
+    }
+}
+
+bool FeatureTraits::project(fVECTOR &feature) const
+{
+    if (!m_projection || m_projection->empty() || feature.size() != m_projection->input_dim())
+        return false;
+    fVECTOR output;
+    m_projection->project(feature, output);
+    feature.swap(output);
+    return true;
+}
+
+} // namespace RedoxiTrack
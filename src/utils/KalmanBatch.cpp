@@ -0,0 +1,203 @@
+#include "RedoxiTrack/utils/KalmanBatch.h"
+#include <algorithm>
+#include <cmath>
+
+namespace RedoxiTrack
+{
+
+void KalmanBatch::_resize(size_t count)
+{
+    m_count = count;
+    m_state.resize(StateNum * count);
+    m_cov.resize(StateNum * StateNum * count);
+    m_noise.resize(StateNum * count);
+    m_measurement.resize(MeasureNum * count);
+}
+
+void KalmanBatch::predict(const std::vector<KalmanFilter *> &filters, int delta_frame_number)
+{
+    const size_t n = filters.size();
+    if (n == 0)
+        return;
+    _resize(n);
+
+    // gather
+    for (size_t i = 0; i < n; i++) {
+        KalmanFilter &kf = *filters[i];
+        for (int k = 0; k < MeasureNum; k++)
+            kf.transition_matrix(k, k + MeasureNum) = delta_frame_number;
+        for (int k = 0; k < StateNum; k++) {
+            _state(k)[i] = kf.state_post(k);
+            m_noise[k * n + i] = kf.process_noise_cov(k, k);
+        }
+        for (int b = 0; b < StateNum; b++)
+            for (int a = 0; a < StateNum; a++)
+                _cov(a, b)[i] = kf.error_cov_post(a, b);
+    }
+
+    // x' = A*x, with A = [I dt*I; 0 I] only the position rows change
+    const float dt = delta_frame_number;
+    for (int k = 0; k < MeasureNum; k++) {
+        float *x = _state(k);
+        const float *v = _state(k + MeasureNum);
+        for (size_t i = 0; i < n; i++)
+            x[i] += dt * v[i];
+    }
+
+    // P' = (A*P)*A' + Q, computed in place: first the position rows of A*P, then the position columns of (A*P)*A'.
+    // the products with the zeros of A are skipped, which does not change the result
+    for (int a = 0; a < MeasureNum; a++) {
+        for (int b = 0; b < StateNum; b++) {
+            float *p = _cov(a, b);
+            const float *q = _cov(a + MeasureNum, b);
+            for (size_t i = 0; i < n; i++)
+                p[i] += dt * q[i];
+        }
+    }
+    for (int a = 0; a < StateNum; a++) {
+        for (int b = 0; b < MeasureNum; b++) {
+            float *p = _cov(a, b);
+            const float *q = _cov(a, b + MeasureNum);
+            for (size_t i = 0; i < n; i++)
+                p[i] += dt * q[i];
+        }
+    }
+    for (int k = 0; k < StateNum; k++) {
+        float *p = _cov(k, k);
+        const float *q = m_noise.data() + k * n;
+        for (size_t i = 0; i < n; i++)
+            p[i] += q[i];
+    }
+
+    // scatter, like KalmanFilter::predict() the post state is set to the prediction
+    for (size_t i = 0; i < n; i++) {
+        KalmanFilter &kf = *filters[i];
+        for (int k = 0; k < StateNum; k++)
+            kf.state_pre(k) = _state(k)[i];
+        for (int b = 0; b < StateNum; b++)
+            for (int a = 0; a < StateNum; a++)
+                kf.error_cov_pre(a, b) = _cov(a, b)[i];
+        kf.state_post = kf.state_pre;
+        kf.error_cov_post = kf.error_cov_pre;
+    }
+}
+
+void KalmanBatch::correct(const std::vector<KalmanFilter *> &filters,
+                          const std::vector<KalmanFilter::MeasureVector> &measurements)
+{
+    assert_throw(filters.size() == measurements.size(), "every filter needs one measurement");
+    const size_t n = filters.size();
+    if (n == 0)
+        return;
+    _resize(n);
+
+    // gather
+    for (size_t i = 0; i < n; i++) {
+        KalmanFilter &kf = *filters[i];
+        for (int k = 0; k < StateNum; k++)
+            _state(k)[i] = kf.state_pre(k);
+        for (int k = 0; k < MeasureNum; k++) {
+            m_noise[k * n + i] = kf.measurement_noise_cov(k, k);
+            m_measurement[k * n + i] = measurements[i](k);
+        }
+        for (int b = 0; b < StateNum; b++)
+            for (int a = 0; a < StateNum; a++)
+                _cov(a, b)[i] = kf.error_cov_pre(a, b);
+    }
+
+    // with H = [I 0], H*P' is the position rows of P' and S = H*P'*H' + R their left block.
+    // K' = S^-1 * H*P' is solved with the cholesky factor of S, one 4x4 factorisation per filter.
+    // scratch rows: [0, 32) K', [32, 64) H*P', [64, 74) lower triangle of the factor
+    const int gain_rows = MeasureNum * StateNum;
+    m_scratch.resize((2 * gain_rows + 10) * n);
+    float *gain = m_scratch.data();
+    float *hp = gain + gain_rows * n;
+    float *chol = hp + gain_rows * n;
+    for (int m = 0; m < MeasureNum; m++)
+        for (int b = 0; b < StateNum; b++)
+            std::copy(_cov(m, b), _cov(m, b) + n, hp + (m * StateNum + b) * n);
+
+    // l(r, c) is row r * (r + 1) / 2 + c of the factor
+    auto l = [chol, n](int r, int c) { return chol + (r * (r + 1) / 2 + c) * n; };
+    for (int r = 0; r < MeasureNum; r++) {
+        for (int c = 0; c <= r; c++) {
+            float *out = l(r, c);
+            const float *s = _cov(r, c);
+            const float *noise = m_noise.data() + r * n;
+            for (size_t i = 0; i < n; i++) {
+                float v = s[i];
+                if (r == c)
+                    v += noise[i];
+                for (int k = 0; k < c; k++)
+                    v -= l(r, k)[i] * l(c, k)[i];
+                out[i] = r == c ? std::sqrt(v) : v / l(c, c)[i];
+            }
+        }
+    }
+
+    // L*L'*K' = H*P', forward then backward substitution on each of the StateNum columns
+    for (int b = 0; b < StateNum; b++) {
+        for (int m = 0; m < MeasureNum; m++) {
+            float *out = gain + (m * StateNum + b) * n;
+            const float *rhs = hp + (m * StateNum + b) * n;
+            for (size_t i = 0; i < n; i++) {
+                float v = rhs[i];
+                for (int k = 0; k < m; k++)
+                    v -= l(m, k)[i] * gain[(k * StateNum + b) * n + i];
+                out[i] = v / l(m, m)[i];
+            }
+        }
+        for (int m = MeasureNum - 1; m >= 0; m--) {
+            float *out = gain + (m * StateNum + b) * n;
+            for (size_t i = 0; i < n; i++) {
+                float v = out[i];
+                for (int k = m + 1; k < MeasureNum; k++)
+                    v -= l(k, m)[i] * gain[(k * StateNum + b) * n + i];
+                out[i] = v / l(m, m)[i];
+            }
+        }
+    }
+
+    // x = x' + K*(z - H*x'), P = P' - K*H*P'. the residual is computed before the position rows change
+    for (int m = 0; m < MeasureNum; m++) {
+        float *z = m_measurement.data() + m * n;
+        const float *x = _state(m);
+        for (size_t i = 0; i < n; i++)
+            z[i] -= x[i];
+    }
+    for (int a = 0; a < StateNum; a++) {
+        float *x = _state(a);
+        for (int m = 0; m < MeasureNum; m++) {
+            const float *k = gain + (m * StateNum + a) * n;
+            const float *r = m_measurement.data() + m * n;
+            for (size_t i = 0; i < n; i++)
+                x[i] += k[i] * r[i];
+        }
+    }
+    for (int a = 0; a < StateNum; a++) {
+        for (int b = 0; b < StateNum; b++) {
+            float *p = _cov(a, b);
+            for (int m = 0; m < MeasureNum; m++) {
+                const float *k = gain + (m * StateNum + a) * n;
+                const float *h = hp + (m * StateNum + b) * n;
+                for (size_t i = 0; i < n; i++)
+                    p[i] -= k[i] * h[i];
+            }
+        }
+    }
+
+    // scatter
+    for (size_t i = 0; i < n; i++) {
+        KalmanFilter &kf = *filters[i];
+        for (int k = 0; k < StateNum; k++)
+            kf.state_post(k) = _state(k)[i];
+        for (int b = 0; b < StateNum; b++)
+            for (int a = 0; a < StateNum; a++)
+                kf.error_cov_post(a, b) = _cov(a, b)[i];
+        for (int m = 0; m < MeasureNum; m++)
+            for (int a = 0; a < StateNum; a++)
+                kf.gain(a, m) = gain[(m * StateNum + a) * n + i];
+    }
+}
+
+} // namespace RedoxiTrack
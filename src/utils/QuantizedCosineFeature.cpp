@@ -0,0 +1,365 @@
+#include "RedoxiTrack/utils/QuantizedCosineFeature.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__F16C__)
+#include <immintrin.h>
+#elif defined(REDOXI_TRACK_WITH_NEON) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace RedoxiTrack
+{
+
+// round to nearest even, like the F16C conversion
+static uint16_t _float_to_half(float value)
+{
+#if defined(__F16C__)
+    return _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+#else
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    const uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t magnitude = x & 0x7fffffff;
+    if (magnitude >= 0x47800000) // overflow, inf and nan
+        return sign | (magnitude > 0x7f800000 ? 0x7e00 : 0x7c00);
+    if (magnitude < 0x38800000) { // zero and subnormal halves, which are multiples of 2^-24
+        float f;
+        std::memcpy(&f, &magnitude, sizeof(f));
+        return sign | (uint16_t)std::nearbyint(f * 16777216.0f);
+    }
+    // rebias the exponent and round the 13 dropped mantissa bits
+    magnitude += 0xc8000fff + ((magnitude >> 13) & 1);
+    return sign | (magnitude >> 13);
+#endif
+}
+
+static float _half_to_float(uint16_t value)
+{
+#if defined(__F16C__)
+    return _cvtsh_ss(value);
+#else
+    const uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1f;
+    const uint32_t mantissa = value & 0x3ff;
+    uint32_t x;
+    if (exponent == 0) {
+        float f = mantissa / 16777216.0f;
+        std::memcpy(&x, &f, sizeof(x));
+        x |= sign;
+    } else if (exponent == 31) {
+        x = sign | 0x7f800000 | (mantissa << 13);
+    } else {
+        x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float output;
+    std::memcpy(&output, &x, sizeof(output));
+    return output;
+#endif
+}
+
+#if defined(__F16C__) && defined(__AVX2__)
+// (l0 + l1) + (l2 + l3) + ((l4 + l5) + (l6 + l7)), the order _dot_half_x4() sums its lanes in
+static float _sum_lanes(__m256 acc)
+{
+    __m256 s = _mm256_hadd_ps(acc, acc);
+    s = _mm256_hadd_ps(s, s);
+    return _mm_cvtss_f32(_mm_add_ss(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1)));
+}
+
+static __m256 _fma(__m256 a, __m256 b, __m256 acc)
+{
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(a, b, acc);
+#else
+    return _mm256_add_ps(acc, _mm256_mul_ps(a, b));
+#endif
+}
+#endif
+
+// n is a multiple of PackedFeatures::RowAlignment
+static float _dot_half(const uint16_t *a, const uint16_t *b, int n)
+{
+#if defined(__F16C__) && defined(__AVX2__)
+    __m256 acc = _mm256_setzero_ps();
+    for (int k = 0; k < n; k += 8)
+        acc = _fma(_mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(a + k))),
+                   _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(b + k))), acc);
+    return _sum_lanes(acc);
+#elif defined(REDOXI_TRACK_WITH_NEON) && defined(__ARM_NEON) && defined(__aarch64__)
+    float32x4_t acc0 = vdupq_n_f32(0), acc1 = vdupq_n_f32(0);
+    for (int k = 0; k < n; k += 8) {
+        float32x4_t a0 = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(a + k)));
+        float32x4_t b0 = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(b + k)));
+        float32x4_t a1 = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(a + k + 4)));
+        float32x4_t b1 = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(b + k + 4)));
+        acc0 = vfmaq_f32(acc0, a0, b0);
+        acc1 = vfmaq_f32(acc1, a1, b1);
+    }
+    return vaddvq_f32(vaddq_f32(acc0, acc1));
+#else
+    float sum = 0;
+    for (int k = 0; k < n; k++)
+        sum += _half_to_float(a[k]) * _half_to_float(b[k]);
+    return sum;
+#endif
+}
+
+// dot products of a with 4 consecutive rows of b, the conversions of a are shared.
+// each output is the same as _dot_half() of that row
+static void _dot_half_x4(const uint16_t *a, const uint16_t *b, int stride, int n, float *output)
+{
+#if defined(__F16C__) && defined(__AVX2__)
+    __m256 acc[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+    for (int k = 0; k < n; k += 8) {
+        __m256 va = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(a + k)));
+        for (int r = 0; r < 4; r++)
+            acc[r] = _fma(va, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(b + r * stride + k))), acc[r]);
+    }
+    __m256 s01 = _mm256_hadd_ps(acc[0], acc[1]);
+    __m256 s23 = _mm256_hadd_ps(acc[2], acc[3]);
+    __m256 s = _mm256_hadd_ps(s01, s23);
+    _mm_storeu_ps(output, _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1)));
+#else
+    for (int r = 0; r < 4; r++)
+        output[r] = _dot_half(a, b + r * stride, n);
+#endif
+}
+
+// n is a multiple of PackedFeatures::RowAlignment, the values are in [-127, 127]
+static int32_t _dot_int8(const int8_t *a, const int8_t *b, int n)
+{
+#if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int k = 0; k < n; k += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + k));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + k));
+        // maddubs takes unsigned * signed bytes, so move the sign of a onto b.
+        // pairs of products stay within int16 since |a|, |b| <= 127
+        __m256i abs_a = _mm256_sign_epi8(va, va);
+        __m256i signed_b = _mm256_sign_epi8(vb, va);
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(abs_a, signed_b), ones));
+    }
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_hadd_epi32(sum, sum);
+    sum = _mm_hadd_epi32(sum, sum);
+    return _mm_cvtsi128_si32(sum);
+#elif defined(REDOXI_TRACK_WITH_NEON) && defined(__ARM_NEON) && defined(__aarch64__)
+    int32x4_t acc = vdupq_n_s32(0);
+    for (int k = 0; k < n; k += 16) {
+        int8x16_t va = vld1q_s8(a + k);
+        int8x16_t vb = vld1q_s8(b + k);
+        acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+        acc = vpadalq_s16(acc, vmull_high_s8(va, vb));
+    }
+    return vaddvq_s32(acc);
+#else
+    int32_t sum = 0;
+    for (int k = 0; k < n; k++)
+        sum += (int32_t)a[k] * b[k];
+    return sum;
+#endif
+}
+
+// dot products of a with 4 consecutive rows of b, the loads of a are shared
+static void _dot_int8_x4(const int8_t *a, const int8_t *b, int stride, int n, int32_t *output)
+{
+#if defined(__AVX2__)
+    __m256i acc[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int k = 0; k < n; k += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + k));
+        __m256i abs_a = _mm256_sign_epi8(va, va);
+        for (int r = 0; r < 4; r++) {
+            __m256i signed_b = _mm256_sign_epi8(_mm256_loadu_si256((const __m256i *)(b + r * stride + k)), va);
+            acc[r] = _mm256_add_epi32(acc[r], _mm256_madd_epi16(_mm256_maddubs_epi16(abs_a, signed_b), ones));
+        }
+    }
+    __m256i s01 = _mm256_hadd_epi32(acc[0], acc[1]);
+    __m256i s23 = _mm256_hadd_epi32(acc[2], acc[3]);
+    __m256i s = _mm256_hadd_epi32(s01, s23);
+    _mm_storeu_si128((__m128i *)output, _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1)));
+#else
+    for (int r = 0; r < 4; r++)
+        output[r] = _dot_int8(a, b + r * stride, n);
+#endif
+}
+
+// |v| <= 127, rounded half away from zero
+static int8_t _quantize(float v)
+{
+    return (int8_t)(v + (v >= 0 ? 0.5f : -0.5f));
+}
+
+// pack dim floats to row i of output, which is already reset
+static void _pack_row(const float *input, int dim, PackedFeatures &output, size_t i)
+{
+    if (output.precision == PackedFeatures::Precision::Float16) {
+        uint16_t *row = output.halves.data() + i * output.stride;
+        int k = 0;
+#if defined(__F16C__)
+        for (; k + 8 <= dim; k += 8)
+            _mm_storeu_si128((__m128i *)(row + k),
+                             _mm256_cvtps_ph(_mm256_loadu_ps(input + k), _MM_FROUND_TO_NEAREST_INT));
+#endif
+        for (; k < dim; k++)
+            row[k] = _float_to_half(input[k]);
+        return;
+    }
+
+    float max_abs = 0;
+    for (int k = 0; k < dim; k++)
+        max_abs = std::max(max_abs, std::abs(input[k]));
+    if (max_abs == 0)
+        return;
+    output.scales[i] = max_abs / 127;
+    const float inv_scale = 127 / max_abs;
+    int8_t *row = output.values.data() + i * output.stride;
+    for (int k = 0; k < dim; k++)
+        row[k] = _quantize(input[k] * inv_scale);
+}
+
+QuantizedCosineFeature::QuantizedCosineFeature(Precision precision) : m_precision(precision)
+{
+}
+
+double QuantizedCosineFeature::distance(const fVECTOR &input1, const fVECTOR &input2) const
+{
+    assert_throw(input1.size() == input2.size(), "features of different sizes can not be compared");
+    const int dim = (int)input1.size();
+    // normalized like normalize() and quantized like pack(), one element at a time
+    const float norm1 = std::sqrt(input1.squaredNorm()), norm2 = std::sqrt(input2.squaredNorm());
+    auto element = [](const fVECTOR &input, float norm, int k) { return norm > 0 ? input[k] / norm : input[k]; };
+
+    float dot = 0;
+    if (m_precision == Precision::Float16) {
+        for (int k = 0; k < dim; k++)
+            dot += _half_to_float(_float_to_half(element(input1, norm1, k))) *
+                   _half_to_float(_float_to_half(element(input2, norm2, k)));
+    } else {
+        float max1 = 0, max2 = 0;
+        for (int k = 0; k < dim; k++) {
+            max1 = std::max(max1, std::abs(element(input1, norm1, k)));
+            max2 = std::max(max2, std::abs(element(input2, norm2, k)));
+        }
+        if (max1 != 0 && max2 != 0) {
+            const float inv_scale1 = 127 / max1, inv_scale2 = 127 / max2;
+            int32_t int_dot = 0;
+            for (int k = 0; k < dim; k++)
+                int_dot += (int32_t)_quantize(element(input1, norm1, k) * inv_scale1) *
+                           _quantize(element(input2, norm2, k) * inv_scale2);
+            dot = max1 / 127 * (max2 / 127) * (float)int_dot;
+        }
+    }
+    return (1 - dot) / 2.0;
+}
+
+void QuantizedCosineFeature::pack(const fMATRIX &features, PackedFeatures &output) const
+{
+    output.reset(m_precision, (int)features.cols(), features.rows());
+    for (Eigen::Index i = 0; i < features.rows(); i++)
+        _pack_row(features.row(i).data(), (int)features.cols(), output, i);
+}
+
+void QuantizedCosineFeature::pack_feature(const Eigen::Ref<const fVECTOR> &feature, PackedFeatures &output) const
+{
+    output.reset(m_precision, (int)feature.size(), 1);
+    _pack_row(feature.data(), (int)feature.size(), output, 0);
+}
+
+float QuantizedCosineFeature::dot(const PackedFeatures &a, size_t i, const PackedFeatures &b, size_t j)
+{
+    if (a.precision == Precision::Float16)
+        return _dot_half(a.halves.data() + i * a.stride, b.halves.data() + j * b.stride, a.stride);
+    return a.scales[i] * b.scales[j] *
+           (float)_dot_int8(a.values.data() + i * a.stride, b.values.data() + j * b.stride, a.stride);
+}
+
+const PackedFeatures &QuantizedCosineFeature::_packed(const FeatureArray &a, PackedFeatures &scratch) const
+{
+    if (a.packed.dim != 0) {
+        assert_throw(a.packed.precision == m_precision, "features are packed with another precision");
+        return a.packed;
+    }
+    pack(a.features, scratch);
+    return scratch;
+}
+
+void QuantizedCosineFeature::compute_distance_matrix(const FeatureArray &a, const FeatureArray &b,
+                                                     CostMatrix &output) const
+{
+    output.resize(a.size(), b.size());
+    if (output.empty())
+        return;
+    if (a.dim() == 0 || b.dim() == 0) {
+        output.fill(max_distance());
+        return;
+    }
+    assert_throw(a.dim() == b.dim(), "features of different sizes can not be compared");
+    PackedFeatures scratch_a, scratch_b;
+    compute_distance_matrix(_packed(a, scratch_a), _packed(b, scratch_b), output);
+    _fill_missing(a, b, output);
+}
+
+void QuantizedCosineFeature::compute_distance_matrix(const PackedFeatures &a, const PackedFeatures &b,
+                                                     CostMatrix &output) const
+{
+    assert_throw(a.precision == b.precision && a.dim == b.dim, "packed features are not comparable");
+    const size_t n = a.size(), m = b.size();
+    const int stride = a.stride;
+    output.resize(n, m);
+    if (output.empty())
+        return;
+
+    // rows of b are taken in blocks that stay in cache while every row of a is compared with them,
+    // 4 rows at a time, so that each load of a row of a is used 4 times
+    const size_t block = 64;
+    int32_t int_dots[4];
+    for (size_t j0 = 0; j0 < m; j0 += block) {
+        const size_t j1 = std::min(m, j0 + block);
+        for (size_t i = 0; i < n; i++) {
+            float *row = output.row(i);
+            size_t j = j0;
+            for (; j + 4 <= j1; j += 4) {
+                if (a.precision == Precision::Float16) {
+                    _dot_half_x4(a.halves.data() + i * stride, b.halves.data() + j * stride, stride, stride, row + j);
+                    continue;
+                }
+                _dot_int8_x4(a.values.data() + i * stride, b.values.data() + j * stride, stride, stride, int_dots);
+                for (int r = 0; r < 4; r++)
+                    row[j + r] = a.scales[i] * b.scales[j + r] * (float)int_dots[r];
+            }
+            for (; j < j1; j++)
+                row[j] = dot(a, i, b, j);
+            for (j = j0; j < j1; j++)
+                row[j] = (1 - row[j]) / 2;
+        }
+    }
+}
+
+void QuantizedCosineFeature::compute_distance_matrix(const FeatureArray &a, const FeatureArray &b,
+                                                     const CandidatePairs &candidates, CostMatrix &output) const
+{
+    assert_throw(candidates.num_sources() == (int)a.size(), "candidate pairs do not match the sources");
+    output.assign(a.size(), b.size(), max_distance());
+    if (a.dim() == 0 || b.dim() == 0)
+        return;
+    assert_throw(a.dim() == b.dim(), "features of different sizes can not be compared");
+    PackedFeatures scratch_a, scratch_b;
+    const PackedFeatures &packed_a = _packed(a, scratch_a);
+    const PackedFeatures &packed_b = _packed(b, scratch_b);
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!a.has_feature[i])
+            continue;
+        float *row = output.row(i);
+        for (int k = candidates.offsets[i]; k < candidates.offsets[i + 1]; k++) {
+            const int j = candidates.targets[k];
+            if (b.has_feature[j])
+                row[j] = (1 - dot(packed_a, i, packed_b, j)) / 2;
+        }
+    }
+}
+
+} // namespace RedoxiTrack
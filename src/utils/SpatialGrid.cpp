@@ -0,0 +1,124 @@
+#include "RedoxiTrack/utils/SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace RedoxiTrack
+{
+
+void SpatialGrid::build(const BoxArray &boxes, float cell_size)
+{
+    m_boxes = &boxes;
+    const size_t n = boxes.size();
+    m_num_cols = m_num_rows = 0;
+    m_cell_offsets.assign(1, 0);
+    m_cell_items.clear();
+    if (n == 0)
+        return;
+
+    // the grid spans the box centers and the cell side defaults to the median box side, so a few huge
+    // boxes do not coarsen it. cell coordinates are clamped to the border, a box reaching outside the
+    // grid is registered in the border cells it maps to, and queries are clamped the same way
+    std::vector<float> sides(n);
+    float min_x = (boxes.x1[0] + boxes.x2[0]) / 2, max_x = min_x;
+    float min_y = (boxes.y1[0] + boxes.y2[0]) / 2, max_y = min_y;
+    for (size_t i = 0; i < n; i++) {
+        float cx = (boxes.x1[i] + boxes.x2[i]) / 2, cy = (boxes.y1[i] + boxes.y2[i]) / 2;
+        min_x = std::min(min_x, cx);
+        max_x = std::max(max_x, cx);
+        min_y = std::min(min_y, cy);
+        max_y = std::max(max_y, cy);
+        sides[i] = std::max(boxes.x2[i] - boxes.x1[i], boxes.y2[i] - boxes.y1[i]) + 1;
+    }
+    if (cell_size <= 0) {
+        std::nth_element(sides.begin(), sides.begin() + n / 2, sides.end());
+        cell_size = sides[n / 2];
+    }
+    cell_size = std::max(cell_size, 1.0f);
+    max_x += cell_size;
+    max_y += cell_size;
+
+    // keep the number of cells in proportion to the number of boxes
+    const double max_cells = std::max<double>(64, 4.0 * n);
+    while ((double)std::ceil((max_x - min_x) / cell_size) * std::ceil((max_y - min_y) / cell_size) > max_cells)
+        cell_size *= 2;
+
+    m_origin_x = min_x;
+    m_origin_y = min_y;
+    m_cell_size = cell_size;
+    m_num_cols = std::max(1, (int)std::ceil((max_x - min_x) / cell_size));
+    m_num_rows = std::max(1, (int)std::ceil((max_y - min_y) / cell_size));
+
+    // counting sort of (cell, box) entries
+    const int num_cells = m_num_cols * m_num_rows;
+    m_cell_offsets.assign(num_cells + 1, 0);
+    for (size_t i = 0; i < n; i++) {
+        int cx1, cy1, cx2, cy2;
+        _cell_range(boxes.x1[i], boxes.y1[i], boxes.x2[i] + 1, boxes.y2[i] + 1, cx1, cy1, cx2, cy2);
+        for (int cy = cy1; cy <= cy2; cy++)
+            for (int cx = cx1; cx <= cx2; cx++)
+                m_cell_offsets[cy * m_num_cols + cx + 1]++;
+    }
+    for (int c = 0; c < num_cells; c++)
+        m_cell_offsets[c + 1] += m_cell_offsets[c];
+    m_cell_items.resize(m_cell_offsets[num_cells]);
+    std::vector<int> fill(m_cell_offsets.begin(), m_cell_offsets.end() - 1);
+    for (size_t i = 0; i < n; i++) {
+        int cx1, cy1, cx2, cy2;
+        _cell_range(boxes.x1[i], boxes.y1[i], boxes.x2[i] + 1, boxes.y2[i] + 1, cx1, cy1, cx2, cy2);
+        for (int cy = cy1; cy <= cy2; cy++)
+            for (int cx = cx1; cx <= cx2; cx++)
+                m_cell_items[fill[cy * m_num_cols + cx]++] = (int)i;
+    }
+}
+
+void SpatialGrid::_cell_range(float x1, float y1, float x2, float y2, int &cx1, int &cy1, int &cx2, int &cy2) const
+{
+    auto to_cell = [this](float v, float origin, int num) {
+        float c = std::floor((v - origin) / m_cell_size);
+        if (!(c >= 0))
+            return 0;
+        return (int)std::min<float>(c, num - 1);
+    };
+    cx1 = to_cell(x1, m_origin_x, m_num_cols);
+    cx2 = to_cell(x2, m_origin_x, m_num_cols);
+    cy1 = to_cell(y1, m_origin_y, m_num_rows);
+    cy2 = to_cell(y2, m_origin_y, m_num_rows);
+}
+
+void SpatialGrid::query(const BoxArray &queries, float radius, CandidatePairs &output) const
+{
+    output.offsets.assign(1, 0);
+    output.targets.clear();
+    const size_t n = size();
+    m_visited.assign(n, -1);
+
+    for (size_t q = 0; q < queries.size(); q++) {
+        size_t begin = output.targets.size();
+        if (n > 0) {
+            const float qx1 = queries.x1[q] - radius, qy1 = queries.y1[q] - radius;
+            const float qx2 = queries.x2[q] + radius, qy2 = queries.y2[q] + radius;
+            int cx1, cy1, cx2, cy2;
+            _cell_range(qx1, qy1, qx2 + 1, qy2 + 1, cx1, cy1, cx2, cy2);
+            for (int cy = cy1; cy <= cy2; cy++) {
+                for (int cx = cx1; cx <= cx2; cx++) {
+                    const int c = cy * m_num_cols + cx;
+                    for (int k = m_cell_offsets[c]; k < m_cell_offsets[c + 1]; k++) {
+                        const int t = m_cell_items[k];
+                        if (m_visited[t] == (int)q)
+                            continue;
+                        m_visited[t] = (int)q;
+                        // same overlap test as compute_iou()
+                        float iw = std::min(qx2, m_boxes->x2[t]) - std::max(qx1, m_boxes->x1[t]) + 1;
+                        float ih = std::min(qy2, m_boxes->y2[t]) - std::max(qy1, m_boxes->y1[t]) + 1;
+                        if (iw > 0 && ih > 0)
+                            output.targets.push_back(t);
+                    }
+                }
+            }
+            std::sort(output.targets.begin() + begin, output.targets.end());
+        }
+        output.offsets.push_back((int)output.targets.size());
+    }
+}
+
+} // namespace RedoxiTrack
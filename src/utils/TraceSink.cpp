@@ -0,0 +1,175 @@
+#include "RedoxiTrack/utils/TraceSink.h"
+#include <cstring>
+#include <fstream>
+
+namespace RedoxiTrack
+{
+
+TraceSink::TraceSink(size_t capacity)
+{
+    assert_throw(capacity > 0, "trace sink capacity must be positive");
+    m_records.resize(capacity);
+}
+
+void TraceSink::_push(int checkpoint, int kind, int a, int b, float v0, float v1, float v2, float v3)
+{
+    TraceRecord &r = m_records[m_next % m_records.size()];
+    r.m_frame_number = m_frame_number;
+    r.m_checkpoint = (uint16_t)checkpoint;
+    r.m_kind = (uint16_t)kind;
+    r.m_a = a;
+    r.m_b = b;
+    r.m_value[0] = v0;
+    r.m_value[1] = v1;
+    r.m_value[2] = v2;
+    r.m_value[3] = v3;
+    m_next++;
+}
+
+void TraceSink::record_target(int checkpoint, int path_id, const BBOX &bbox, int flag)
+{
+    _push(checkpoint, Target, path_id, flag, bbox.x, bbox.y, bbox.width, bbox.height);
+}
+
+void TraceSink::record_detection(int checkpoint, int index, const BBOX &bbox, float confidence)
+{
+    // confidence goes to the b slot as fixed point so the bbox fits in the values
+    _push(checkpoint, Detection, index, (int)(confidence * 1000), bbox.x, bbox.y, bbox.width, bbox.height);
+}
+
+void TraceSink::record_match(int checkpoint, int source, int target)
+{
+    _push(checkpoint, Match, source, target, 0);
+}
+
+void TraceSink::record_index(int checkpoint, int index)
+{
+    _push(checkpoint, Index, index, 0, 0);
+}
+
+void TraceSink::record_cost(int checkpoint, int row, int col, float value)
+{
+    _push(checkpoint, Cost, row, col, value);
+}
+
+void TraceSink::clear()
+{
+    m_next = 0;
+}
+
+size_t TraceSink::size() const
+{
+    return (size_t)std::min<uint64_t>(m_next, m_records.size());
+}
+
+std::vector<TraceRecord> TraceSink::snapshot() const
+{
+    std::vector<TraceRecord> output;
+    size_t n = size();
+    output.reserve(n);
+    uint64_t first = m_next - n;
+    for (uint64_t i = first; i < m_next; i++)
+        output.push_back(m_records[i % m_records.size()]);
+    return output;
+}
+
+bool TraceSink::dump(const std::string &path) const
+{
+    std::ofstream fout(path, std::ios::binary);
+    if (!fout.is_open())
+        return false;
+
+    auto records = snapshot();
+    const char magic[8] = {'R', 'X', 'T', 'R', 'A', 'C', 'E', '1'};
+    uint32_t record_size = sizeof(TraceRecord);
+    uint32_t reserved = 0;
+    uint64_t count = records.size();
+    fout.write(magic, sizeof(magic));
+    fout.write((const char *)&record_size, sizeof(record_size));
+    fout.write((const char *)&reserved, sizeof(reserved));
+    fout.write((const char *)&count, sizeof(count));
+    if (!records.empty())
+        fout.write((const char *)records.data(), records.size() * sizeof(TraceRecord));
+    return fout.good();
+}
+
+void TraceSink::dump_text(std::ostream &os) const
+{
+    static const char *kind_names[] = {"target", "detection", "match", "index", "cost"};
+    for (auto &r : snapshot()) {
+        os << r.m_frame_number << "," << get_checkpoint_name(r.m_checkpoint) << ","
+           << (r.m_kind < 5 ? kind_names[r.m_kind] : "unknown") << ","
+           << r.m_a << "," << r.m_b << ","
+           << r.m_value[0] << "," << r.m_value[1] << "," << r.m_value[2] << "," << r.m_value[3] << "\n";
+    }
+}
+
+const char *TraceSink::get_checkpoint_name(int checkpoint)
+{
+    switch (checkpoint) {
+    case TrackedTargets:
+        return "tracked_stracks";
+    case LostTargets:
+        return "lost_stracks";
+    case RemovedTargets:
+        return "removed_stracks";
+    case HighScoreDetections:
+        return "high_score_detections";
+    case Unconfirmed:
+        return "unconfirmed";
+    case TargetPool:
+        return "strack_pool";
+    case TargetPoolPredicted:
+        return "strack_pool_after_predict";
+    case FirstIouDistance:
+        return "first_iou_dists";
+    case FuseScoreDistance:
+        return "fuse_score_iou_dists";
+    case FirstAppearanceDistance:
+        return "first_appearance_dists";
+    case FirstMatched:
+        return "first_matched";
+    case FirstUnmatchedTrack:
+        return "first_u_track";
+    case FirstUnmatchedDetection:
+        return "first_u_detection";
+    case LowScoreDetections:
+        return "low_score_detections";
+    case SecondIouDistance:
+        return "second_iou_dists";
+    case SecondMatched:
+        return "second_matched";
+    case SecondUnmatchedTrack:
+        return "second_u_track";
+    case SecondUnmatchedDetection:
+        return "second_u_detection";
+    case FinalDistance:
+        return "final_dists";
+    case ThirdMatched:
+        return "third_matched";
+    case ThirdUnmatchedTrack:
+        return "third_u_track";
+    case ThirdUnmatchedDetection:
+        return "third_u_detection";
+    case Activated:
+        return "activated_stracks";
+    case Refind:
+        return "refind_stracks";
+    case Lost:
+        return "lost";
+    case Removed:
+        return "removed";
+    case BeforeDedupTracked:
+        return "before_dedup_tracked_stracks";
+    case BeforeDedupLost:
+        return "before_dedup_lost_stracks";
+    case AfterDedupLost:
+        return "after_dedup_lost_stracks";
+    case Output:
+        return "output";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace RedoxiTrack
@@ -0,0 +1,210 @@
+#include "RedoxiTrack/utils/WorkStealingPool.h"
+
+#include <algorithm>
+
+namespace RedoxiTrack
+{
+
+namespace
+{
+// the pool and queue of the worker running on this thread, if any
+thread_local const WorkStealingPool *t_pool = nullptr;
+thread_local size_t t_worker_index = 0;
+} // namespace
+
+WorkStealingPool::~WorkStealingPool()
+{
+    stop();
+}
+
+void WorkStealingPool::start(int num_threads)
+{
+    assert_throw(m_threads.empty(), "the pool is already started");
+    if (num_threads <= 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    m_stopping = false;
+    m_workers.clear();
+    for (int i = 0; i < num_threads; i++)
+        m_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    for (int i = 0; i < num_threads; i++)
+        m_threads.emplace_back(&WorkStealingPool::_worker_loop, this, (size_t)i);
+}
+
+void WorkStealingPool::stop()
+{
+    if (m_threads.empty())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto &t : m_threads)
+        t.join();
+    m_threads.clear();
+    m_workers.clear();
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    assert_throw(!m_threads.empty(), "the pool is not started");
+    size_t index = t_pool == this ? t_worker_index : m_next_worker.fetch_add(1) % m_workers.size();
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // under the wake mutex, so that a worker about to sleep can not miss it
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_num_queued++;
+    }
+    m_wake.notify_one();
+}
+
+void WorkStealingPool::parallel_for(size_t num_items, size_t grain,
+                                    const std::function<void(size_t, size_t)> &fn)
+{
+    grain = std::max<size_t>(grain, 1);
+    const size_t num_tiles = (num_items + grain - 1) / grain;
+    if (num_tiles <= 1 || m_threads.empty()) {
+        if (num_items > 0)
+            fn(0, num_items);
+        return;
+    }
+
+    // helpers that start after the last tile was claimed do nothing, they may outlive this call so the
+    // counters are shared. fn is only called for claimed tiles, which this call waits for
+    struct Loop {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto loop = std::make_shared<Loop>();
+    const std::function<void(size_t, size_t)> *body = &fn;
+    auto run_tiles = [loop, body, num_items, grain, num_tiles]() {
+        size_t tile;
+        while ((tile = loop->next.fetch_add(1)) < num_tiles) {
+            size_t begin = tile * grain;
+            (*body)(begin, std::min(begin + grain, num_items));
+            if (loop->done.fetch_add(1) + 1 == num_tiles) {
+                std::lock_guard<std::mutex> lock(loop->mutex);
+                loop->finished.notify_all();
+            }
+        }
+    };
+
+    size_t num_helpers = std::min(num_tiles - 1, m_threads.size());
+    for (size_t k = 0; k < num_helpers; k++)
+        submit(run_tiles);
+    run_tiles();
+
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->finished.wait(lock, [&loop, num_tiles]() { return loop->done == num_tiles; });
+}
+
+bool WorkStealingPool::_take(size_t index, Task &task)
+{
+    const size_t n = m_workers.size();
+    for (size_t k = 0; k < n; k++) {
+        Worker &w = *m_workers[(index + k) % n];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (w.tasks.empty())
+            continue;
+        if (k == 0) {
+            task = std::move(w.tasks.front());
+            w.tasks.pop_front();
+        } else {
+            task = std::move(w.tasks.back());
+            w.tasks.pop_back();
+        }
+        m_num_queued--;
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::_worker_loop(size_t index)
+{
+    t_pool = this;
+    t_worker_index = index;
+    Task task;
+    while (true) {
+        if (_take(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_wake_mutex);
+        m_wake.wait(lock, [this]() { return m_num_queued > 0 || m_stopping; });
+        if (m_stopping && m_num_queued == 0)
+            break;
+    }
+    t_pool = nullptr;
+}
+
+AsyncTask::~AsyncTask()
+{
+    reset();
+}
+
+void AsyncTask::start(WorkStealingPool *pool, WorkStealingPool::Task task)
+{
+    reset();
+    m_state = std::make_shared<State>();
+    m_state->task = std::move(task);
+    m_done = m_state->done.get_future();
+
+    std::shared_ptr<State> state = m_state;
+    if (pool && pool->get_num_threads() > 0)
+        pool->submit([state]() { _run(state); });
+    else
+        m_thread = std::async(std::launch::async, [state]() { _run(state); });
+}
+
+void AsyncTask::join()
+{
+    if (!m_state)
+        return;
+    _run(m_state);
+    std::future<void> done = std::move(m_done);
+    m_state = nullptr;
+    m_thread = std::future<void>();
+    done.get();
+}
+
+void AsyncTask::reset()
+{
+    if (!m_state)
+        return;
+    // claiming it here keeps the pool or the thread from starting it
+    if (!m_state->claimed.exchange(true))
+        m_state->done.set_value();
+    m_done.wait();
+    m_state = nullptr;
+    m_done = std::future<void>();
+    m_thread = std::future<void>();
+}
+
+bool AsyncTask::_run(const std::shared_ptr<State> &state)
+{
+    if (state->claimed.exchange(true))
+        return false;
+    // the captures of the task may hold resources, they are released before join() returns
+    WorkStealingPool::Task task = std::move(state->task);
+    std::exception_ptr error;
+    try {
+        task();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    task = nullptr;
+    if (error)
+        state->done.set_exception(error);
+    else
+        state->done.set_value();
+    return true;
+}
+
+} // namespace RedoxiTrack
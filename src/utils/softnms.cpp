@@ -101,7 +101,7 @@ namespace RedoxiTrack {
 
                 float similarity = 0;
                 // if without id feature, back to navie softnms
-                if (!m_use_IDfeature || m_detections[it->second]->get_feature().size() == 0) {
+                if (!m_use_IDfeature || !m_detections[it->second]->has_feature()) {
                     similarity = IOU;
                 }
                 else {
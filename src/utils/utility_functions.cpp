@@ -1,5 +1,11 @@
 #include "RedoxiTrack/utils/utility_functions.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(REDOXI_TRACK_WITH_NEON) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace RedoxiTrack{
     float median(std::vector<float> &v, const float empty_output)
     {
@@ -10,22 +16,8 @@ namespace RedoxiTrack{
         return v[n];
     }
 
-    void copy_kalmanFilter(const cv::KalmanFilter &from, cv::KalmanFilter &to){
-         from.transitionMatrix.copyTo(to.transitionMatrix);
-         from.measurementMatrix.copyTo(to.measurementMatrix);
-         from.processNoiseCov.copyTo(to.processNoiseCov);
-         from.measurementNoiseCov.copyTo(to.measurementNoiseCov);
-         from.errorCovPost.copyTo(to.errorCovPost);
-         from.statePre.copyTo(to.statePre);
-         from.statePost.copyTo(to.statePost);
-         from.controlMatrix.copyTo(to.controlMatrix);
-         from.errorCovPre.copyTo(to.errorCovPre);
-         from.gain.copyTo(to.gain);
-         from.temp1.copyTo(to.temp1);
-         from.temp2.copyTo(to.temp2 );
-         from.temp3.copyTo(to.temp3);
-         from.temp4.copyTo(to.temp4 );
-         from.temp5.copyTo(to.temp5);
+    void copy_kalmanFilter(const KalmanFilter &from, KalmanFilter &to){
+        to = from;
     }
 
     float compute_iou(const Detection& source, const Detection& target){
@@ -57,6 +49,212 @@ namespace RedoxiTrack{
         }
         return iou;
     }
+    // iou (or 1 - iou) of one source box against all target boxes, same arithmetic as compute_iou()
+    static void _pairwise_iou_row(float source_x1, float source_y1, float source_x2, float source_y2,
+                                  const BoxArray &target, float *output, bool output_distance) {
+        const float source_area = (source_x2 - source_x1 + 1) * (source_y2 - source_y1 + 1);
+        const float *tx1 = target.x1.data(), *ty1 = target.y1.data();
+        const float *tx2 = target.x2.data(), *ty2 = target.y2.data();
+        const size_t n = target.size();
+        size_t j = 0;
+#if defined(__AVX2__)
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 sx1 = _mm256_set1_ps(source_x1), sy1 = _mm256_set1_ps(source_y1);
+        const __m256 sx2 = _mm256_set1_ps(source_x2), sy2 = _mm256_set1_ps(source_y2);
+        const __m256 sarea = _mm256_set1_ps(source_area);
+        for (; j + 8 <= n; j += 8) {
+            __m256 x1 = _mm256_loadu_ps(tx1 + j), y1 = _mm256_loadu_ps(ty1 + j);
+            __m256 x2 = _mm256_loadu_ps(tx2 + j), y2 = _mm256_loadu_ps(ty2 + j);
+            __m256 box_area = _mm256_mul_ps(_mm256_add_ps(_mm256_sub_ps(x2, x1), one),
+                                            _mm256_add_ps(_mm256_sub_ps(y2, y1), one));
+            __m256 iw = _mm256_add_ps(_mm256_sub_ps(_mm256_min_ps(sx2, x2), _mm256_max_ps(sx1, x1)), one);
+            __m256 ih = _mm256_add_ps(_mm256_sub_ps(_mm256_min_ps(sy2, y2), _mm256_max_ps(sy1, y1)), one);
+            __m256 inter = _mm256_mul_ps(iw, ih);
+            __m256 ua = _mm256_sub_ps(_mm256_add_ps(sarea, box_area), inter);
+            __m256 valid = _mm256_and_ps(_mm256_cmp_ps(iw, zero, _CMP_GT_OQ), _mm256_cmp_ps(ih, zero, _CMP_GT_OQ));
+            __m256 iou = _mm256_and_ps(valid, _mm256_div_ps(inter, ua));
+            if (output_distance)
+                iou = _mm256_sub_ps(one, iou);
+            _mm256_storeu_ps(output + j, iou);
+        }
+#elif defined(REDOXI_TRACK_WITH_NEON) && defined(__ARM_NEON) && defined(__aarch64__)
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const float32x4_t sx1 = vdupq_n_f32(source_x1), sy1 = vdupq_n_f32(source_y1);
+        const float32x4_t sx2 = vdupq_n_f32(source_x2), sy2 = vdupq_n_f32(source_y2);
+        const float32x4_t sarea = vdupq_n_f32(source_area);
+        for (; j + 4 <= n; j += 4) {
+            float32x4_t x1 = vld1q_f32(tx1 + j), y1 = vld1q_f32(ty1 + j);
+            float32x4_t x2 = vld1q_f32(tx2 + j), y2 = vld1q_f32(ty2 + j);
+            float32x4_t box_area = vmulq_f32(vaddq_f32(vsubq_f32(x2, x1), one), vaddq_f32(vsubq_f32(y2, y1), one));
+            float32x4_t iw = vaddq_f32(vsubq_f32(vminq_f32(sx2, x2), vmaxq_f32(sx1, x1)), one);
+            float32x4_t ih = vaddq_f32(vsubq_f32(vminq_f32(sy2, y2), vmaxq_f32(sy1, y1)), one);
+            float32x4_t inter = vmulq_f32(iw, ih);
+            float32x4_t ua = vsubq_f32(vaddq_f32(sarea, box_area), inter);
+            uint32x4_t valid = vandq_u32(vcgtq_f32(iw, zero), vcgtq_f32(ih, zero));
+            float32x4_t iou = vreinterpretq_f32_u32(vandq_u32(valid, vreinterpretq_u32_f32(vdivq_f32(inter, ua))));
+            if (output_distance)
+                iou = vsubq_f32(one, iou);
+            vst1q_f32(output + j, iou);
+        }
+#endif
+        for (; j < n; j++) {
+            float iou = 0.0;
+            float box_area = (tx2[j] - tx1[j] + 1) * (ty2[j] - ty1[j] + 1);
+            float iw = min(source_x2, tx2[j]) - max(source_x1, tx1[j]) + 1;
+            if (iw > 0) {
+                float ih = min(source_y2, ty2[j]) - max(source_y1, ty1[j]) + 1;
+                if (ih > 0) {
+                    float ua = float(source_area + box_area - iw * ih);
+                    iou = iw * ih / ua;
+                }
+            }
+            output[j] = output_distance ? 1 - iou : iou;
+        }
+    }
+
+    void compute_pairwise_iou(const BoxArray &source, const BoxArray &target,
+                              float *output, size_t output_stride, bool output_distance) {
+        compute_pairwise_iou_rows(source, 0, source.size(), target, output, output_stride, output_distance);
+    }
+
+    void compute_pairwise_iou_rows(const BoxArray &source, size_t first, size_t last, const BoxArray &target,
+                                   float *output, size_t output_stride, bool output_distance) {
+        for (size_t i = first; i < last; i++)
+            _pairwise_iou_row(source.x1[i], source.y1[i], source.x2[i], source.y2[i],
+                              target, output + i * output_stride, output_distance);
+    }
+
+    void compute_pairwise_iou(const BoxArray &source, const BoxArray &target,
+                              CostMatrix &output, bool output_distance) {
+        output.resize(source.size(), target.size());
+        compute_pairwise_iou(source, target, output.data(), output.stride(), output_distance);
+    }
+
+    void compute_pairwise_iou(const BoxArray &source, const BoxArray &target,
+                              const CandidatePairs &candidates, CostMatrix &output, bool output_distance) {
+        assert_throw(candidates.num_sources() == (int)source.size(), "candidate pairs do not match the sources");
+        output.assign(source.size(), target.size(), output_distance ? 1.0f : 0.0f);
+        for (size_t i = 0; i < source.size(); i++) {
+            const float sx1 = source.x1[i], sy1 = source.y1[i], sx2 = source.x2[i], sy2 = source.y2[i];
+            const float source_area = (sx2 - sx1 + 1) * (sy2 - sy1 + 1);
+            float *row = output.row(i);
+            for (int k = candidates.offsets[i]; k < candidates.offsets[i + 1]; k++) {
+                const int j = candidates.targets[k];
+                float iou = 0.0;
+                float box_area = (target.x2[j] - target.x1[j] + 1) * (target.y2[j] - target.y1[j] + 1);
+                float iw = min(sx2, target.x2[j]) - max(sx1, target.x1[j]) + 1;
+                if (iw > 0) {
+                    float ih = min(sy2, target.y2[j]) - max(sy1, target.y1[j]) + 1;
+                    if (ih > 0) {
+                        float ua = float(source_area + box_area - iw * ih);
+                        iou = iw * ih / ua;
+                    }
+                }
+                row[j] = output_distance ? 1 - iou : iou;
+            }
+        }
+    }
+
+    void select_pairs(const CostMatrix &matrix, float max_value, const CandidatePairs *within,
+                      CandidatePairs &output) {
+        assert_throw(!within || within->num_sources() == matrix.rows(), "candidate pairs do not match the matrix");
+        output.offsets.resize(matrix.rows() + 1);
+        output.targets.clear();
+        output.offsets[0] = 0;
+        for (int i = 0; i < matrix.rows(); i++) {
+            const float *row = matrix.row(i);
+            if (within) {
+                for (int k = within->offsets[i]; k < within->offsets[i + 1]; k++) {
+                    if (row[within->targets[k]] <= max_value)
+                        output.targets.push_back(within->targets[k]);
+                }
+            } else {
+                for (int j = 0; j < matrix.cols(); j++) {
+                    if (row[j] <= max_value)
+                        output.targets.push_back(j);
+                }
+            }
+            output.offsets[i + 1] = (int)output.targets.size();
+        }
+    }
+
+    void compute_pairwise_iou(const std::vector<DetectionPtr> &source,
+                              const std::vector<DetectionPtr> &target,
+                              fMATRIX *out_distance) {
+        BoxArray source_boxes, target_boxes;
+        source_boxes.assign(source);
+        target_boxes.assign(target);
+        out_distance->resize(source.size(), target.size());
+        compute_pairwise_iou(source_boxes, target_boxes, out_distance->data(), target.size(), false);
+    }
+
+    void compute_pairwise_mahalanobis(const std::vector<KalmanFilter::MeasureVector> &measurements,
+                                      const std::vector<KalmanFilter::MeasureVector> &means,
+                                      const std::vector<KalmanFilter::MeasureMatrix> &covariances,
+                                      CostMatrix &output) {
+        static_assert(KalmanFilter::MeasureSize == 4, "the distance is unrolled for 4 measurements");
+        assert_throw(means.size() == covariances.size(), "every mean needs one covariance");
+        const size_t n = measurements.size(), m = means.size();
+        output.resize(n, m);
+        if (n == 0 || m == 0)
+            return;
+
+        // d' * S^-1 * d = |L^-1 * d|^2 with S = L * L'. per gaussian, the mean and the lower triangle of L^-1
+        // are stored as structure-of-arrays so that one measurement against all gaussians is a vectorized loop
+        std::vector<float> params(14 * m);
+        float *mu[4], *w[10];
+        for (int k = 0; k < 4; k++)
+            mu[k] = params.data() + k * m;
+        for (int k = 0; k < 10; k++)
+            w[k] = params.data() + (4 + k) * m;
+        std::vector<size_t> singular;
+        for (size_t j = 0; j < m; j++) {
+            KalmanFilter::MeasureMatrix inv_l = KalmanFilter::MeasureMatrix::Identity();
+            Eigen::LLT<KalmanFilter::MeasureMatrix> llt(covariances[j]);
+            if (llt.info() == Eigen::Success)
+                llt.matrixL().solveInPlace(inv_l);
+            else
+                singular.push_back(j);
+            for (int k = 0; k < 4; k++)
+                mu[k][j] = means[j](k);
+            for (int r = 0, k = 0; r < 4; r++)
+                for (int c = 0; c <= r; c++, k++)
+                    w[k][j] = inv_l(r, c);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            const float z0 = measurements[i](0), z1 = measurements[i](1);
+            const float z2 = measurements[i](2), z3 = measurements[i](3);
+            float *row = output.row(i);
+            for (size_t j = 0; j < m; j++) {
+                const float d0 = z0 - mu[0][j], d1 = z1 - mu[1][j], d2 = z2 - mu[2][j], d3 = z3 - mu[3][j];
+                const float y0 = w[0][j] * d0;
+                const float y1 = w[1][j] * d0 + w[2][j] * d1;
+                const float y2 = w[3][j] * d0 + w[4][j] * d1 + w[5][j] * d2;
+                const float y3 = w[6][j] * d0 + w[7][j] * d1 + w[8][j] * d2 + w[9][j] * d3;
+                row[j] = y0 * y0 + y1 * y1 + y2 * y2 + y3 * y3;
+            }
+        }
+
+        // covariances that are not positive definite are solved pair by pair
+        for (size_t j : singular) {
+            auto ldlt = covariances[j].ldlt();
+            for (size_t i = 0; i < n; i++) {
+                KalmanFilter::MeasureVector diff = measurements[i] - means[j];
+                output(i, j) = diff.dot(ldlt.solve(diff));
+            }
+        }
+    }
+
+    static void _pack_cost_matrix(const std::vector<std::vector<float>> &matrix_source2target,
+                                  const int source_length, const int target_length, CostMatrix &output) {
+        output.resize(source_length, target_length);
+        for (int i = 0; i < source_length; i++)
+            std::copy(matrix_source2target[i].begin(), matrix_source2target[i].begin() + target_length, output.row(i));
+    }
+
     // in this namespace, source represent now(detection), target represent prev predict(tracker)
     void
     hungarian_match(const std::vector<std::vector<float>> &matrix_source2target,
@@ -64,10 +262,21 @@ namespace RedoxiTrack{
                     std::vector<std::pair<int, int>> &output_matched_pair,
                     std::vector<int> &output_unmatched_source,
                     std::vector<int> &output_unmatched_target) {
+        CostMatrix cost_matrix;
+        _pack_cost_matrix(matrix_source2target, source_length, target_length, cost_matrix);
+        hungarian_match(cost_matrix, thresh, output_matched_pair, output_unmatched_source, output_unmatched_target);
+    }
+
+    void hungarian_match(const CostMatrix &matrix_source2target, const float thresh,
+                         std::vector<std::pair<int, int>> &output_matched_pair,
+                         std::vector<int> &output_unmatched_source,
+                         std::vector<int> &output_unmatched_target) {
+        const int source_length = matrix_source2target.rows();
+        const int target_length = matrix_source2target.cols();
         std::vector<int> assignment;
         RedoxiTrack::HungarianAlgorithm HungAlgo;
         // assignment: target index
-        HungAlgo.Solve(const_cast<std::vector<std::vector<float>>&>(matrix_source2target), assignment);
+        HungAlgo.Solve(matrix_source2target.data(), source_length, target_length, matrix_source2target.stride(), assignment);
 
         std::vector<bool> unmatched_rows(source_length, true);
         std::vector<bool> unmatched_cols(target_length, true);
@@ -75,7 +284,7 @@ namespace RedoxiTrack{
             int &col = assignment[row];
             if (col == -1 || col >= target_length)
                 continue;
-            if (matrix_source2target[row][col] <= thresh) {
+            if (matrix_source2target(row, col) <= thresh) {
                 output_matched_pair.push_back(std::pair<int, int>(row, col));
                 unmatched_rows[row] = false;
                 unmatched_cols[col] = false;
@@ -94,6 +303,17 @@ namespace RedoxiTrack{
                           std::vector<std::pair<int, int>> &output_matched_pair,
                           std::vector<int> &output_unmatched_source,
                           std::vector<int> &output_unmatched_target) {
+        CostMatrix cost_matrix;
+        _pack_cost_matrix(matrix_source2target, source_length, target_length, cost_matrix);
+        lapjv_match(cost_matrix, thresh, output_matched_pair, output_unmatched_source, output_unmatched_target);
+    }
+
+    void lapjv_match(const CostMatrix &matrix_source2target, const float thresh,
+                     std::vector<std::pair<int, int>> &output_matched_pair,
+                     std::vector<int> &output_unmatched_source,
+                     std::vector<int> &output_unmatched_target) {
+        const int source_length = matrix_source2target.rows();
+        const int target_length = matrix_source2target.cols();
         if (source_length == 0 && target_length == 0) return;
         else if (source_length == 0) {
             for (int i = 0; i < target_length; i++) {
@@ -107,53 +327,153 @@ namespace RedoxiTrack{
             }
             return;
         }
-        uint_t n = source_length + target_length;
-        std::vector<std::vector<double>> cost_matrix(n, std::vector<double>(n, thresh / 2));
-        for (unsigned int row = 0; row < n; row++) {
-            for (unsigned int col = 0; col < n; col++) {
-                if (row < source_length && col < target_length) {
-                    cost_matrix[row][col] = matrix_source2target[row][col];
-                }
-                else if (row >= source_length && col >= target_length) {
-                    cost_matrix[row][col] = 0.0;
-                }
+
+        // solved as a rectangular problem, an unmatched source or target costs thresh/2.
+        // the buffers are kept per thread, so this does not allocate once they have grown to the scene size
+        thread_local std::vector<int_t> x, y;
+        x.resize(source_length);
+        y.resize(target_length);
+        int ret = lapjv_rectangular(source_length, target_length, matrix_source2target.data(),
+                                    matrix_source2target.stride(), thresh, x.data(), y.data());
+        assert_throw(ret == 0, "Unknown error (lapjv_rectangular returned %d).");
+
+        for (int i = 0; i < source_length; i++) {
+            if (x[i] != -1) {
+                output_matched_pair.push_back(std::pair<int, int>(i, x[i]));
+            }
+            else {
+                output_unmatched_source.push_back(i);
+            }
+        }
+        for (int i = 0; i < target_length; i++) {
+            if (y[i] == -1) {
+                output_unmatched_target.push_back(i);
             }
         }
+    }
 
-        double **cost_ptr = (double **) malloc(n * sizeof(double *));
-        for (int i = 0; i < n; i++) {
-            cost_ptr[i] = cost_matrix[i].data();
+    static int _find_root(std::vector<int> &parent, int i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
         }
+        return i;
+    }
 
-        int_t *x = (int_t *) malloc(n * sizeof(int_t));
-        int_t *y = (int_t *) malloc(n * sizeof(int_t));
+    // solve each connected component of the gated bipartite graph with the given dense matcher
+    template <typename DenseMatch>
+    static void _match_by_components(const CostMatrix &matrix_source2target, const float thresh,
+                                     DenseMatch dense_match,
+                                     std::vector<std::pair<int, int>> &output_matched_pair,
+                                     std::vector<int> &output_unmatched_source,
+                                     std::vector<int> &output_unmatched_target) {
+        const int source_length = matrix_source2target.rows();
+        const int target_length = matrix_source2target.cols();
 
-        int ret = lapjv_internal(n, cost_ptr, x, y);
-        free(cost_ptr);
-        assert_throw(ret == 0, "Unknown error (lapjv_internal returned %d).");
+        // union-find over sources [0, n) and targets [n, n+m), joined by every pair within thresh
+        std::vector<int> parent(source_length + target_length);
+        for (size_t i = 0; i < parent.size(); i++)
+            parent[i] = i;
+        for (int i = 0; i < source_length; i++) {
+            const float *cost_row = matrix_source2target.row(i);
+            for (int j = 0; j < target_length; j++) {
+                if (cost_row[j] <= thresh) {
+                    int a = _find_root(parent, i);
+                    int b = _find_root(parent, source_length + j);
+                    if (a != b)
+                        parent[b] = a;
+                }
+            }
+        }
+
+        // group the sources and targets by component, components without any pair are left unmatched
+        std::vector<int> root2component(parent.size(), -1);
+        std::vector<std::vector<int>> component_sources, component_targets;
+        std::vector<char> has_pair(parent.size(), 0);
+        for (size_t k = 0; k < parent.size(); k++)
+            has_pair[_find_root(parent, k)] |= (int)k >= source_length ? 2 : 1;
+        for (int k = 0; k < source_length + target_length; k++) {
+            int root = _find_root(parent, k);
+            if (has_pair[root] != 3)
+                continue;
+            if (root2component[root] == -1) {
+                root2component[root] = component_sources.size();
+                component_sources.emplace_back();
+                component_targets.emplace_back();
+            }
+            if (k < source_length)
+                component_sources[root2component[root]].push_back(k);
+            else
+                component_targets[root2component[root]].push_back(k - source_length);
+        }
 
-        if (n != source_length) {
-            for (int j = 0; j < n; j++) {
-                if (x[j] >= target_length)
-                    x[j] = -1;
-                if (y[j] >= source_length)
-                    y[j] = -1;
+        std::vector<int> source2target(source_length, -1);
+        std::vector<bool> target_matched(target_length, false);
+        if (component_sources.size() == 1 && (int)component_sources[0].size() == source_length &&
+            (int)component_targets[0].size() == target_length) {
+            // everything is connected, solve the original matrix in place
+            std::vector<std::pair<int, int>> matched_pair;
+            std::vector<int> unmatched_source, unmatched_target;
+            dense_match(matrix_source2target, thresh, matched_pair, unmatched_source, unmatched_target);
+            for (auto &p : matched_pair)
+                source2target[p.first] = p.second;
+        }
+        else {
+            CostMatrix sub_matrix;
+            std::vector<std::pair<int, int>> matched_pair;
+            std::vector<int> unmatched_source, unmatched_target;
+            for (size_t c = 0; c < component_sources.size(); c++) {
+                auto &rows = component_sources[c];
+                auto &cols = component_targets[c];
+                sub_matrix.resize(rows.size(), cols.size());
+                for (size_t i = 0; i < rows.size(); i++) {
+                    const float *cost_row = matrix_source2target.row(rows[i]);
+                    float *sub_row = sub_matrix.row(i);
+                    for (size_t j = 0; j < cols.size(); j++)
+                        sub_row[j] = cost_row[cols[j]];
+                }
+                matched_pair.clear();
+                unmatched_source.clear();
+                unmatched_target.clear();
+                dense_match(sub_matrix, thresh, matched_pair, unmatched_source, unmatched_target);
+                for (auto &p : matched_pair)
+                    source2target[rows[p.first]] = cols[p.second];
             }
         }
 
+        // same ordering as the dense matchers: pairs by source, unmatched indices ascending
         for (int i = 0; i < source_length; i++) {
-            if (x[i] != -1) {
-                output_matched_pair.push_back(std::pair<int, int>(i, x[i]));
+            if (source2target[i] != -1) {
+                output_matched_pair.push_back(std::pair<int, int>(i, source2target[i]));
+                target_matched[source2target[i]] = true;
             }
             else {
                 output_unmatched_source.push_back(i);
             }
         }
-        for (int i = 0; i < target_length; i++) {
-            if (y[i] == -1) {
+        for (int i = 0; i < target_length; i++)
+            if (!target_matched[i])
                 output_unmatched_target.push_back(i);
-            }
-        }
+    }
+
+    void hungarian_match_sparse(const CostMatrix &matrix_source2target, const float thresh,
+                                std::vector<std::pair<int, int>> &output_matched_pair,
+                                std::vector<int> &output_unmatched_source,
+                                std::vector<int> &output_unmatched_target) {
+        void (*dense_match)(const CostMatrix &, const float, std::vector<std::pair<int, int>> &,
+                            std::vector<int> &, std::vector<int> &) = hungarian_match;
+        _match_by_components(matrix_source2target, thresh, dense_match,
+                             output_matched_pair, output_unmatched_source, output_unmatched_target);
+    }
+
+    void lapjv_match_sparse(const CostMatrix &matrix_source2target, const float thresh,
+                            std::vector<std::pair<int, int>> &output_matched_pair,
+                            std::vector<int> &output_unmatched_source,
+                            std::vector<int> &output_unmatched_target) {
+        void (*dense_match)(const CostMatrix &, const float, std::vector<std::pair<int, int>> &,
+                            std::vector<int> &, std::vector<int> &) = lapjv_match;
+        _match_by_components(matrix_source2target, thresh, dense_match,
+                             output_matched_pair, output_unmatched_source, output_unmatched_target);
     }
 
     std::vector<POINT>
@@ -0,0 +1,144 @@
+/**
+ * pin the order of the events of KalmanTracker, which corrects and predicts its filters in batches:
+ * - track(img, detections, frame_number) fires evt_target_association_before for every matched pair, then
+ *   corrects all filters, then fires evt_target_association_after for every pair in the same order
+ * - track(img, frame_number) fires evt_target_motion_predict_before and _after per target, the bbox of the
+ *   target changes in between
+ * exits with 1 and prints the first failed check otherwise
+ */
+#include <RedoxiTrack/RedoxiTrack.h>
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace rxt = RedoxiTrack;
+
+namespace
+{
+const int NumObjects = 4;
+
+struct Event {
+    std::string name;
+    const rxt::TrackTarget *target;
+};
+
+class RecordingHandler : public rxt::TrackingEventHandler
+{
+  public:
+    int evt_target_association_before(rxt::TrackerBase *sender,
+                                      const rxt::TrackingEvent::TargetAssociation &evt_data) override
+    {
+        m_events.push_back({"association_before", evt_data.m_target.get()});
+        m_bbox_before[evt_data.m_target.get()] = evt_data.m_target->get_bbox();
+        return 0;
+    }
+
+    int evt_target_association_after(rxt::TrackerBase *sender,
+                                     const rxt::TrackingEvent::TargetAssociation &evt_data) override
+    {
+        // the first after event comes when every matched target is already corrected
+        if (m_events.empty() || m_events.back().name != "association_after") {
+            for (auto &p : m_bbox_before)
+                if (p.first->get_bbox() == p.second)
+                    m_corrected_in_batch = false;
+        }
+        m_events.push_back({"association_after", evt_data.m_target.get()});
+        return 0;
+    }
+
+    int evt_target_motion_predict_before(rxt::TrackerBase *sender,
+                                         const rxt::TrackingEvent::TargetMotionPredict &evt_data) override
+    {
+        m_events.push_back({"motion_predict_before", evt_data.m_target.get()});
+        m_bbox_before[evt_data.m_target.get()] = evt_data.m_target->get_bbox();
+        return 0;
+    }
+
+    int evt_target_motion_predict_after(rxt::TrackerBase *sender,
+                                        const rxt::TrackingEvent::TargetMotionPredict &evt_data) override
+    {
+        if (evt_data.m_target->get_bbox() == m_bbox_before[evt_data.m_target.get()])
+            m_predicted_in_between = false;
+        m_events.push_back({"motion_predict_after", evt_data.m_target.get()});
+        return 0;
+    }
+
+    void clear()
+    {
+        m_events.clear();
+        m_bbox_before.clear();
+    }
+
+  public:
+    std::vector<Event> m_events;
+    std::map<const rxt::TrackTarget *, rxt::BBOX> m_bbox_before;
+    bool m_corrected_in_batch = true;
+    bool m_predicted_in_between = true;
+};
+
+// objects in a row walking to the right, 10 px per frame
+std::vector<rxt::DetectionPtr> create_detections(int frame_number)
+{
+    std::vector<rxt::DetectionPtr> output;
+    for (int i = 0; i < NumObjects; i++) {
+        auto det = std::make_shared<rxt::SingleDetection>();
+        det->set_bbox(rxt::BBOX(100 + i * 200 + frame_number * 10, 300, 60, 150));
+        det->set_confidence(0.9f);
+        output.push_back(det);
+    }
+    return output;
+}
+
+bool check(bool condition, const char *what)
+{
+    if (!condition)
+        std::printf("FAILED: %s\n", what);
+    return condition;
+}
+} // namespace
+
+int main()
+{
+    cv::Mat img(1080, 1920, CV_8UC3, cv::Scalar::all(0));
+    auto handler = std::make_shared<RecordingHandler>();
+
+    rxt::KalmanTracker tracker;
+    tracker.init(rxt::TrackerParam());
+    tracker.add_event_handler(handler);
+    tracker.begin_track(img, create_detections(0), 0);
+
+    // every object is matched, all before events come first, then all after events in the same order
+    handler->clear();
+    tracker.track(img, create_detections(1), 1);
+    auto &events = handler->m_events;
+    if (!check(events.size() == 2 * NumObjects, "one association before and after event per object"))
+        return 1;
+    for (int i = 0; i < NumObjects; i++) {
+        if (!check(events[i].name == "association_before", "association before events come first") ||
+            !check(events[NumObjects + i].name == "association_after", "association after events come last") ||
+            !check(events[NumObjects + i].target == events[i].target, "after events keep the order of before"))
+            return 1;
+    }
+    if (!check(handler->m_corrected_in_batch, "all filters are corrected between the before and after events"))
+        return 1;
+
+    // prediction only, before and after per target
+    handler->clear();
+    tracker.track(img, 2);
+    if (!check(events.size() == 2 * NumObjects, "one motion predict before and after event per object"))
+        return 1;
+    for (int i = 0; i < NumObjects; i++) {
+        if (!check(events[2 * i].name == "motion_predict_before", "motion predict before of a target comes first") ||
+            !check(events[2 * i + 1].name == "motion_predict_after", "motion predict after follows its before") ||
+            !check(events[2 * i + 1].target == events[2 * i].target, "motion predict events come per target"))
+            return 1;
+    }
+    if (!check(handler->m_predicted_in_between, "the bbox is predicted between the before and after events"))
+        return 1;
+
+    tracker.finish_track();
+    std::printf("kalman event order ok\n");
+    return 0;
+}
@@ -0,0 +1,128 @@
+/**
+ * fit a PCA projection of reid features, for the m_feature_projection_file of the tracker params.
+ * features are normalized to unit length before fitting, as CosineFeature compares them.
+ * prints the fraction of variance (or energy) kept and how much the cosine distances of sample pairs change.
+ *
+ * usage: redoxi_fit_projection features output_file --dim D [--center] [--raw-dim N] [--max-samples M]
+ *   features       one feature per line, values separated by spaces or commas (e.g. numpy.savetxt),
+ *                  or raw float32 features with --raw-dim
+ *   output_file    projection written by FeatureProjection::save()
+ *   --dim          size of the projected features
+ *   --center       subtract the mean feature, see FeatureProjection::fit()
+ *   --raw-dim      read the features as raw float32, N values each
+ *   --max-samples  fit on at most M features, evenly spaced in the file (default: all)
+ */
+#include <RedoxiTrack/RedoxiTrackConfig.h>
+#include <RedoxiTrack/utils/FeatureProjection.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace rxt = RedoxiTrack;
+
+namespace
+{
+void read_text(const std::string &path, std::vector<std::vector<float>> &output)
+{
+    std::ifstream input(path);
+    rxt::assert_throw(input.good(), "can not open " + path);
+    std::string line;
+    while (std::getline(input, line)) {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream is(line);
+        std::vector<float> feature;
+        float x;
+        while (is >> x)
+            feature.push_back(x);
+        if (feature.empty())
+            continue;
+        rxt::assert_throw(output.empty() || feature.size() == output[0].size(),
+                          "features of different sizes in " + path);
+        output.push_back(std::move(feature));
+    }
+}
+
+void read_raw(const std::string &path, int dim, std::vector<std::vector<float>> &output)
+{
+    std::ifstream input(path, std::ios::binary);
+    rxt::assert_throw(input.good(), "can not open " + path);
+    std::vector<float> feature(dim);
+    while (input.read(reinterpret_cast<char *>(feature.data()), dim * sizeof(float)))
+        output.push_back(feature);
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string input_path, output_path;
+    int dim = 0, raw_dim = 0;
+    size_t max_samples = 0;
+    bool center = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--dim" && i + 1 < argc)
+            dim = std::stoi(argv[++i]);
+        else if (arg == "--center")
+            center = true;
+        else if (arg == "--raw-dim" && i + 1 < argc)
+            raw_dim = std::stoi(argv[++i]);
+        else if (arg == "--max-samples" && i + 1 < argc)
+            max_samples = std::stoul(argv[++i]);
+        else if (input_path.empty())
+            input_path = arg;
+        else
+            output_path = arg;
+    }
+    if (input_path.empty() || output_path.empty() || dim <= 0) {
+        printf("usage: redoxi_fit_projection features output_file --dim D [--center] [--raw-dim N] [--max-samples M]\n");
+        return 1;
+    }
+
+    std::vector<std::vector<float>> features;
+    if (raw_dim > 0)
+        read_raw(input_path, raw_dim, features);
+    else
+        read_text(input_path, features);
+    rxt::assert_throw(features.size() >= 2, "at least 2 features are needed");
+    // rounded up, so that at most max_samples are taken
+    const size_t step = max_samples > 0 ? (features.size() + max_samples - 1) / max_samples : 1;
+    const size_t n = (features.size() + step - 1) / step;
+    const int input_dim = (int)features[0].size();
+    printf("%zu features of size %d, fitting on %zu\n", features.size(), input_dim, n);
+
+    rxt::fMATRIX samples(n, input_dim);
+    for (size_t i = 0; i < n; i++) {
+        samples.row(i) = Eigen::Map<const rxt::fVECTOR>(features[i * step].data(), input_dim).transpose();
+        if (samples.row(i).norm() > 0)
+            samples.row(i).normalize();
+    }
+
+    rxt::FeatureProjection projection;
+    double kept = projection.fit(samples, dim, center);
+    projection.save(output_path);
+    printf("projection %d -> %d written to %s, %.1f%% of the %s kept\n", input_dim, dim, output_path.c_str(),
+           kept * 100, center ? "variance" : "energy");
+
+    // cosine distances before and after, on random pairs of the samples
+    rxt::fMATRIX projected;
+    projection.project(samples, projected);
+    projected.rowwise().normalize();
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+    const int num_pairs = 100000;
+    double sum_error = 0, max_error = 0;
+    for (int k = 0; k < num_pairs; k++) {
+        size_t a = pick(rng), b = pick(rng);
+        double before = (1 - samples.row(a).dot(samples.row(b))) / 2;
+        double after = (1 - projected.row(a).dot(projected.row(b))) / 2;
+        sum_error += std::abs(after - before);
+        max_error = std::max(max_error, std::abs(after - before));
+    }
+    printf("cosine distance change over %d pairs: mean %.4f, max %.4f\n", num_pairs, sum_error / num_pairs,
+           max_error);
+    return 0;
+}